@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "misc.h"
+#include "list.h"
+#include "diff.h"
+#include "stats.h"
+
+// bytes of each file compared at a time, a multiple of any fragment
+#define DIFF_CHUNK	(1 << 20)
+
+struct diff_side {
+	disk_device *device;
+	struct fs *fs;
+};
+
+// one directory's entries, in name order, and their inodes
+struct diff_dir {
+	struct direct *entries;
+	ufs_dinode *dinodes;
+	int n;
+};
+
+struct diff_state {
+	struct diff_side a, b;
+	int same_layout;		/* block pointers mean the same */
+	FILE *out;
+	int64_t added;
+	int64_t removed;
+	int64_t modified;
+	int64_t compared;		/* files whose contents were read */
+	int errors;
+};
+
+// what of an inode tells whether a file changed, from either version
+struct diff_meta {
+	uint16_t mode;
+	uint32_t uid;
+	uint32_t gid;
+	uint32_t flags;
+	int64_t size;
+	int64_t mtime;
+	int32_t mtimensec;
+	int64_t ctime;
+	int32_t ctimensec;
+	int32_t gen;
+	int64_t db[NDADDR];
+	int64_t ib[NIADDR];
+};
+
+static void get_meta(struct fs *fs, const ufs_dinode *dinode,
+    struct diff_meta *meta)
+{
+	const struct ufs1_dinode *d1 = &dinode->din.ufs1;
+	const struct ufs2_dinode *d2 = &dinode->din.ufs2;
+	int i;
+
+	memset(meta, 0, sizeof(*meta));
+	meta->mode = dinode->mode;
+	meta->size = dinode->size;
+	meta->mtime = dinode->mtime;
+	if (fs->fs_magic == FS_UFS1_MAGIC) {
+		meta->uid = d1->di_uid;
+		meta->gid = d1->di_gid;
+		meta->flags = d1->di_flags;
+		meta->mtimensec = d1->di_mtimensec;
+		meta->ctime = d1->di_ctime;
+		meta->ctimensec = d1->di_ctimensec;
+		meta->gen = d1->di_gen;
+		for (i = 0; i < NDADDR; ++i)
+			meta->db[i] = d1->di_db[i];
+		for (i = 0; i < NIADDR; ++i)
+			meta->ib[i] = d1->di_ib[i];
+	} else {
+		meta->uid = d2->di_uid;
+		meta->gid = d2->di_gid;
+		meta->flags = d2->di_flags;
+		meta->mtimensec = d2->di_mtimensec;
+		meta->ctime = d2->di_ctime;
+		meta->ctimensec = d2->di_ctimensec;
+		meta->gen = d2->di_gen;
+		for (i = 0; i < NDADDR; ++i)
+			meta->db[i] = d2->di_db[i];
+		for (i = 0; i < NIADDR; ++i)
+			meta->ib[i] = d2->di_ib[i];
+	}
+}
+
+// whether the inodes are the same file, untouched: the same inode,
+// generation, times and block pointers. nothing else need be read.
+static int same_inode(struct diff_state *st, ufs_inop ino_a,
+    const struct diff_meta *a, ufs_inop ino_b, const struct diff_meta *b)
+{
+	return st->same_layout && ino_a == ino_b && a->size == b->size &&
+	    a->gen == b->gen && a->mtime == b->mtime &&
+	    a->mtimensec == b->mtimensec && a->ctime == b->ctime &&
+	    a->ctimensec == b->ctimensec &&
+	    !memcmp(a->db, b->db, sizeof(a->db)) &&
+	    !memcmp(a->ib, b->ib, sizeof(a->ib));
+}
+
+// whether the mode, owner or flags changed
+static int attrs_differ(const struct diff_meta *a, const struct diff_meta *b)
+{
+	return a->mode != b->mode || a->uid != b->uid || a->gid != b->gid ||
+	    a->flags != b->flags;
+}
+
+// read and compare two files of the same size
+static int same_data(struct diff_state *st, ufs_dinode *dinode_a,
+    ufs_dinode *dinode_b)
+{
+	struct diff_side *a = &st->a, *b = &st->b;
+	ufs_block_list *list_a, *list_b;
+	unsigned char *buf_a, *buf_b;
+	int64_t pos, len, t;
+	int same;
+
+	st->compared++;
+
+	t = stats_begin();
+	list_a = ufs_get_block_list(a->device, a->fs, dinode_a);
+	list_b = ufs_get_block_list(b->device, b->fs, dinode_b);
+	stats_end(STATS_BLOCKMAP, t);
+
+	buf_a = malloc(DIFF_CHUNK);
+	buf_b = malloc(DIFF_CHUNK);
+
+	same = 1;
+	t = stats_begin();
+	for (pos = 0; same && pos < (int64_t)dinode_a->size; pos += len) {
+		len = dinode_a->size - pos;
+		if (len > DIFF_CHUNK)
+			len = DIFF_CHUNK;
+		if (ufs_read_data(a->device, a->fs, dinode_a, list_a, buf_a,
+		    pos >> a->fs->fs_fshift, howmany(len, a->fs->fs_fsize)) <
+		    len || ufs_read_data(b->device, b->fs, dinode_b, list_b,
+		    buf_b, pos >> b->fs->fs_fshift,
+		    howmany(len, b->fs->fs_fsize)) < len) {
+			st->errors++;
+			same = 0;
+			break;
+		}
+		same = !memcmp(buf_a, buf_b, (size_t)len);
+	}
+	stats_end(STATS_READ, t);
+
+	free(buf_b);
+	free(buf_a);
+	ufs_free_block_list(list_b);
+	ufs_free_block_list(list_a);
+
+	return same;
+}
+
+static const void *short_link(struct fs *fs, const ufs_dinode *dinode)
+{
+	return fs->fs_magic == FS_UFS1_MAGIC ?
+	    (const void *)dinode->din.ufs1.di_db :
+	    (const void *)dinode->din.ufs2.di_db;
+}
+
+// whether two files of the same type differ
+static int file_differs(struct diff_state *st, ufs_inop ino_a,
+    ufs_dinode *dinode_a, ufs_inop ino_b, ufs_dinode *dinode_b)
+{
+	struct diff_meta a, b;
+
+	get_meta(st->a.fs, dinode_a, &a);
+	get_meta(st->b.fs, dinode_b, &b);
+
+	if (attrs_differ(&a, &b) || a.size != b.size)
+		return 1;
+	if (same_inode(st, ino_a, &a, ino_b, &b))
+		return 0;
+
+	switch (a.mode & IFMT) {
+		case IFREG:
+			break;
+		case IFLNK:
+			// a short link's target is where the block pointers
+			// would be
+			if (a.size < st->a.fs->fs_maxsymlinklen &&
+			    b.size < st->b.fs->fs_maxsymlinklen)
+				return memcmp(short_link(st->a.fs, dinode_a),
+				    short_link(st->b.fs, dinode_b),
+				    (size_t)dinode_a->size) != 0;
+			break;
+		case IFCHR:
+		case IFBLK:
+			return a.db[0] != b.db[0];
+		default:
+			// fifos and sockets have nothing more to them
+			return 0;
+	}
+
+	return !same_data(st, dinode_a, dinode_b);
+}
+
+// the entries of a directory, less "." and "..", sorted by name, with
+// their inodes. -1, with no entries, if it can't be read.
+static int read_dir(struct diff_side *side, ufs_dinode *dinode,
+    struct diff_dir *dir)
+{
+	struct fs *fs = side->fs;
+	ufs_block_list *block_list;
+	struct direct direct;
+	ufs_inop *inos;
+	char *buf;
+	int64_t pos, t;
+	uint16_t reclen;
+	int i, max, ret;
+
+	memset(dir, 0, sizeof(*dir));
+
+	t = stats_begin();
+	block_list = ufs_get_block_list(side->device, fs, dinode);
+	stats_end(STATS_BLOCKMAP, t);
+	t = stats_begin();
+	buf = malloc((size_t)dinode->size + sizeof(struct direct));
+	ret = ufs_read_data(side->device, fs, dinode, block_list, buf, 0, 0);
+	stats_end(STATS_READ, t);
+	ufs_free_block_list(block_list);
+	if (ret < 0) {
+		free(buf);
+		return -1;
+	}
+	STATS_ADD(directories, 1);
+	STATS_ADD(dirblocks, lblkno(fs, blkroundup(fs, dinode->size)));
+
+	max = 0;
+	for (pos = 0; pos < (int64_t)dinode->size; pos += reclen) {
+		reclen = ufs_read_direntry(buf + pos, &direct);
+		if (!reclen)
+			break;
+		if (!direct.d_ino || !strcmp(direct.d_name, ".") ||
+		    !strcmp(direct.d_name, ".."))
+			continue;
+		if (dir->n == max) {
+			max = max ? max * 2 : 64;
+			dir->entries = realloc(dir->entries,
+			    max * sizeof(*dir->entries));
+		}
+		dir->entries[dir->n++] = direct;
+	}
+	free(buf);
+
+	qsort(dir->entries, dir->n, sizeof(*dir->entries), sort_direct);
+
+	inos = malloc((dir->n ? dir->n : 1) * sizeof(*inos));
+	dir->dinodes = malloc((dir->n ? dir->n : 1) * sizeof(*dir->dinodes));
+	for (i = 0; i < dir->n; ++i)
+		inos[i] = dir->entries[i].d_ino;
+	ufs_read_inodes(side->device, fs, inos, dir->n, dir->dinodes);
+	free(inos);
+
+	return 0;
+}
+
+static void free_dir(struct diff_dir *dir)
+{
+	free(dir->entries);
+	free(dir->dinodes);
+}
+
+static void report(struct diff_state *st, char what, const char *path,
+    const ufs_dinode *dinode)
+{
+	fprintf(st->out, "%c %s%s\n", what, path,
+	    (dinode->mode & IFMT) == IFDIR && strcmp(path, "/") ? "/" : "");
+
+	if (what == '+')
+		st->added++;
+	else if (what == '-')
+		st->removed++;
+	else
+		st->modified++;
+}
+
+static void diff_dirs(struct diff_state *st, ufs_dinode *dinode_a,
+    ufs_dinode *dinode_b, const char *path);
+
+// compare what path is in each, either of which may not have it
+static void diff_entry(struct diff_state *st, const char *path,
+    ufs_inop ino_a, ufs_dinode *dinode_a, ufs_inop ino_b,
+    ufs_dinode *dinode_b)
+{
+	struct diff_meta a, b;
+	int dir_a, dir_b;
+
+	dir_a = dinode_a && (dinode_a->mode & IFMT) == IFDIR;
+	dir_b = dinode_b && (dinode_b->mode & IFMT) == IFDIR;
+
+	// one of a different type was put in its place
+	if (dinode_a && dinode_b &&
+	    (dinode_a->mode & IFMT) != (dinode_b->mode & IFMT)) {
+		diff_entry(st, path, ino_a, dinode_a, 0, NULL);
+		diff_entry(st, path, 0, NULL, ino_b, dinode_b);
+		return;
+	}
+
+	if (!dinode_b) {
+		report(st, '-', path, dinode_a);
+		if (dir_a)
+			diff_dirs(st, dinode_a, NULL, path);
+	} else if (!dinode_a) {
+		report(st, '+', path, dinode_b);
+		if (dir_b)
+			diff_dirs(st, NULL, dinode_b, path);
+	} else if (dir_a) {
+		get_meta(st->a.fs, dinode_a, &a);
+		get_meta(st->b.fs, dinode_b, &b);
+		if (attrs_differ(&a, &b))
+			report(st, 'M', path, dinode_b);
+		diff_dirs(st, dinode_a, dinode_b, path);
+	} else if (file_differs(st, ino_a, dinode_a, ino_b, dinode_b)) {
+		report(st, 'M', path, dinode_b);
+	}
+}
+
+// merge the entries of a directory in each, either of which may be
+// missing
+static void diff_dirs(struct diff_state *st, ufs_dinode *dinode_a,
+    ufs_dinode *dinode_b, const char *path)
+{
+	struct diff_dir a, b;
+	char *sub;
+	int i, j, c;
+
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+	// an unreadable side would show as everything added or removed
+	if ((dinode_a && read_dir(&st->a, dinode_a, &a)) ||
+	    (dinode_b && read_dir(&st->b, dinode_b, &b))) {
+		fprintf(stderr, "ufs2tool: cannot read directory \"%s\"\n",
+		    path);
+		st->errors++;
+		free_dir(&b);
+		free_dir(&a);
+		return;
+	}
+
+	for (i = j = 0; i < a.n || j < b.n;) {
+		if (i == a.n)
+			c = 1;
+		else if (j == b.n)
+			c = -1;
+		else
+			c = strcmp(a.entries[i].d_name, b.entries[j].d_name);
+
+		sub = malloc(strlen(path) + MAXNAMLEN + 2);
+		strcpy(sub, path);
+		if (path[strlen(path) - 1] != '/')
+			strcat(sub, "/");
+		strcat(sub, c <= 0 ? a.entries[i].d_name : b.entries[j].d_name);
+
+		if (c < 0) {
+			diff_entry(st, sub, a.entries[i].d_ino, &a.dinodes[i],
+			    0, NULL);
+			++i;
+		} else if (c > 0) {
+			diff_entry(st, sub, 0, NULL, b.entries[j].d_ino,
+			    &b.dinodes[j]);
+			++j;
+		} else {
+			diff_entry(st, sub, a.entries[i].d_ino, &a.dinodes[i],
+			    b.entries[j].d_ino, &b.dinodes[j]);
+			++i;
+			++j;
+		}
+		free(sub);
+	}
+
+	free_dir(&b);
+	free_dir(&a);
+}
+
+int ufs_diff(disk_device *device_a, struct fs *fs_a,
+    disk_device *device_b, struct fs *fs_b, char *path, FILE *out)
+{
+	struct diff_state st;
+	ufs_dinode dinode_a, dinode_b;
+	ufs_inop ino_a, ino_b;
+	int64_t t;
+
+	memset(&st, 0, sizeof(st));
+	st.a.device = device_a;
+	st.a.fs = fs_a;
+	st.b.device = device_b;
+	st.b.fs = fs_b;
+	st.out = out;
+	st.same_layout = fs_a->fs_magic == fs_b->fs_magic &&
+	    fs_a->fs_fsize == fs_b->fs_fsize &&
+	    fs_a->fs_bsize == fs_b->fs_bsize;
+
+	t = stats_begin();
+	ino_a = ufs_lookup_path(device_a, fs_a, path, 1, ROOTINO);
+	ino_b = ufs_lookup_path(device_b, fs_b, path, 1, ROOTINO);
+	stats_end(STATS_LOOKUP, t);
+	if (!ino_a && !ino_b) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", path);
+		return -1;
+	}
+	if (ino_a)
+		ufs_read_inode(device_a, fs_a, ino_a, &dinode_a);
+	if (ino_b)
+		ufs_read_inode(device_b, fs_b, ino_b, &dinode_b);
+
+	diff_entry(&st, path, ino_a, ino_a ? &dinode_a : NULL, ino_b,
+	    ino_b ? &dinode_b : NULL);
+	fflush(out);
+
+	fprintf(stderr, "%I64d added, %I64d removed, %I64d modified (%I64d "
+	    "compared by contents)\n", st.added, st.removed, st.modified,
+	    st.compared);
+
+	return st.errors ? -1 : 0;
+}
@@ -1,357 +1,796 @@
-/*
- * Copyright (c) 2004 Nehal Mistry
- * All rights reserved.
- * 
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission.
- * 
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
- * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
- * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
- * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
- * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include <windows.h>
-#include <stdio.h>
-#include <stdint.h>
-
-#include "diskio.h"
-
-#ifndef INVALID_SET_FILE_POINTER
-#define INVALID_SET_FILE_POINTER ((DWORD)-1)
-#endif
-
-uint32_t slice_offset;
-uint32_t partition_offset;
-
-static uint32_t sector_offset = 0;
-struct dos_table table;
-struct disklabel label;
-
-int seek_absolute_device(HANDLE device, int64_t offset, int whence)
-{
-	unsigned long low, high;
-	int read;
-
-	if (device == INVALID_HANDLE_VALUE)
-		return -1;
-
-	high = (offset >> 32) & 0x7FFFFFFF;
-	low = offset & 0xFFFFFFFF;
-
-	sector_offset = low % 512;
-	low -= sector_offset;
-
-	switch (whence) {
-		case SEEK_SET:
-			read = SetFilePointer(device, low, &high, FILE_BEGIN);
-			break;
-		case SEEK_CUR:
-			read = SetFilePointer(device, low, &high, FILE_CURRENT);
-			break;
-		case SEEK_END:
-			read = SetFilePointer(device, low, &high, FILE_END);
-			break;
-	}
-
-	if (read == INVALID_SET_FILE_POINTER && GetLastError() != NO_ERROR) {
-		return -1;
-	} else {
-		return 0;
-	}
-}
-
-int seek_device(HANDLE device, int64_t offset, int whence)
-{
-	if (whence == SEEK_SET) {
-		if (partition_offset) {
-			offset += (int64_t)partition_offset * 512;
-		} else {
-			offset += (int64_t)slice_offset * 512;
-		}
-	} else if (whence == SEEK_END) {
-		// fixme;
-	}
-
-	return seek_absolute_device(device, offset, whence);
-}
-
-int read_device(HANDLE device, char *buf, int64_t numbytes)
-{
-	long read;
-	int ret;
-	char tmp[512];
-	int64_t rem;
-
-	if (device == INVALID_HANDLE_VALUE)
-		return -1;
-
-	ret = ReadFile(device, tmp, 512, &read, NULL);
-	if (!ret) {
-		FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM |
-		    FORMAT_MESSAGE_IGNORE_INSERTS, NULL, GetLastError(),
-		    MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-		    tmp, 512, NULL);
-		fprintf(stderr, "%s\n", tmp);
-	}
-
-	if (numbytes > 512 - sector_offset) {
-		memcpy(buf, tmp + sector_offset, 512 - sector_offset);
-		rem = numbytes - (512 - sector_offset);
-	} else {
-		memcpy(buf, tmp + sector_offset, numbytes);
-		rem = 0;
-	}
-
-	if (rem % 512) {
-		ReadFile(device, buf + 512 - sector_offset, (rem / 512) *
-		    512, &read, NULL);
-		sector_offset = rem % 512;
-		ret = ReadFile(device, tmp, 512, &read, NULL);
-		memcpy(buf, tmp, sector_offset);
-		seek_device(device, SEEK_CUR, -512);
-	} else {
-		ret = ReadFile(device, buf + 512 - sector_offset, rem, &read, NULL);
-		if (!ret) {
-			FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-			    NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-			    tmp, 512, NULL);
-			fprintf(stderr, "%s\n", tmp);
-		}
-		sector_offset = 0;
-	}
-
-	return (!ret);
-}
-
-static int partindex = 0;
-static int numlogical = 0;
-
-// start - offset of slice table
-// offset - offset of the first extended slice
-static int read_slice_table(HANDLE device, struct dos_table *dt,
-    uint32_t start, uint32_t offset)
-{
-	int i;
-	int32_t extstart;
-	char buf[512];
-	char emptybuf[DOSPARTSIZE];
-	void *tablep;
-	struct dos_partition d;
-	struct dos_partition *dpnext;	// pointer to next entry to fill
-
-	memset(emptybuf, 0, DOSPARTSIZE);
-
-	seek_device(device, (int64_t)start * 512, SEEK_SET);
-	read_device(device, buf, 512);
-
-	if (*(uint16_t*)(buf + DOSMAGICOFFSET) != DOSMAGIC) {
-		return -1;
-	}
-
-	// intialize the dos_table struct
-	if (!offset) {
-		dt->dt_entrycount = 0;
-		dt->dt_partcount = 0;
-		for (i = 0; i < NEXTDOSPART+1; ++i) {
-			dt->dt_partnum[i] = -1;
-		}
-	}
-
-	extstart = -1;
-
-	// read the primary slices
-	// FIXME: cleanup
-	for (i = 0; i < 4; ++i) {
-		tablep = &buf[DOSPARTOFF + i * DOSPARTSIZE];
-		dpnext = &dt->dt_slices[partindex];
-		dos_partition_dec(tablep, dpnext);
-		// set to absolute value
-		dpnext->dp_start += start;
-		if (dpnext->dp_typ == DOSPTYP_EXT ||
-		    dpnext->dp_typ == DOSPTYP_EXTLBA ||
-		    dpnext->dp_typ == 0x85) {
-			extstart = dpnext->dp_start;
-			if (!offset) {
-				dt->dt_partnum[i + 1] = partindex;
-				++partindex;
-				++dt->dt_partcount;
-			}
-			++dt->dt_entrycount;
-		} else {
-			if (memcmp(tablep, emptybuf, DOSPARTSIZE)) {
-				++dt->dt_entrycount;
-				++dt->dt_partcount;
-				if (!offset) {
-					dt->dt_partnum[i + 1] = partindex;
-				} else {
-					++numlogical;
-					dt->dt_partnum[4 + numlogical] = partindex;
-				}
-				++partindex;
-			} else if (!offset) {
-				++partindex;
-			}
-		}
-	}
-
-	// read logical slices
-	if (extstart >= 0) {
-		for (i = 0; i < 4; ++i) {
-			tablep = &buf[DOSPARTOFF + i * DOSPARTSIZE];
-			dos_partition_dec(tablep, &d);
-			if (d.dp_typ == DOSPTYP_EXT || 
-			    d.dp_typ == DOSPTYP_EXTLBA || d.dp_typ == 0x85) {
-				d.dp_start += offset;
-				read_slice_table(device, dt, d.dp_start,
-				    (offset ? offset : extstart));
-			}
-		}
-	}
-	return 0;
-}
-
-// drive (0-based)
-HANDLE open_device(int drive)
-{
-	HANDLE device;
-	char path[32];
-
-	sprintf(path, "\\\\.\\PhysicalDrive%d", drive);
-
-	device = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
-	    NULL, OPEN_EXISTING, 0, NULL);
-	if (device == INVALID_HANDLE_VALUE)
-		return INVALID_HANDLE_VALUE;
-
-	read_slice_table(device, &table, 0, 0);
-	slice_offset = 0;
-
-	return device;
-}
-
-// drive (0-based)
-// slice (1-based)
-HANDLE open_slice_device(int drive, int slice)
-{
-	HANDLE device;
-	char path[32];
-
-	sprintf(path, "\\\\.\\PhysicalDrive%d", drive);
-
-	device = CreateFile(path, GENERIC_READ, FILE_SHARE_READ |
-	    FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-	if (device == INVALID_HANDLE_VALUE) {
-		printf("open_slice_device: invalid handle\n");
-		return INVALID_HANDLE_VALUE;
-	}
-
-	read_slice_table(device, &table, 0, 0);
-
-	printf("ec: %u\npc: %u\n\n\n", table.dt_entrycount, table.dt_partcount);
-
-	if (slice > NEXTDOSPART+1) {
-		printf("open_slice_device: invalid slice\n");
-		close_device(device);
-		return INVALID_HANDLE_VALUE;
-	}
-
-	
-	if (table.dt_partnum[slice] == -1 ||
-	    table.dt_slices[table.dt_partnum[slice]].dp_size == 0) {
-		printf("open_slice_device: invalid size\n");
-		close_device(device);
-		return INVALID_HANDLE_VALUE;
-	} else {
-		slice_offset = table.dt_slices[table.dt_partnum[slice]].dp_start;
-	}
-
-	return device;
-}
-
-// drive (0-based)
-// slice (1-based)
-// partition (0-based)
-HANDLE open_partition_device(int drive, int slice, int partition)
-{
-	HANDLE device;
-	char path[32];
-	char buf[BBSIZE];
-
-	sprintf(path, "\\\\.\\PhysicalDrive%d", drive);
-	device = CreateFile(path, GENERIC_READ, FILE_SHARE_READ |
-	    FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-	if (device == INVALID_HANDLE_VALUE)
-		return INVALID_HANDLE_VALUE;
-
-	if (slice > NEXTDOSPART+1 || partition > MAXPARTITIONS) {
-		close_device(device);
-		return INVALID_HANDLE_VALUE;
-	}
-
-	if (slice) {
-		read_slice_table(device, &table, 0, 0);
-		if (table.dt_partnum[slice] == -1 ||
-		    table.dt_slices[table.dt_partnum[slice]].dp_size == 0) {
-			close_device(device);
-			return INVALID_HANDLE_VALUE;
-		} else {
-			slice_offset = table.dt_slices[table.dt_partnum[slice]].dp_start;
-		}
-	} else {
-		slice_offset = 0;
-	}
-
-	seek_device(device, 0, SEEK_SET);
-	read_device(device, buf, BBSIZE);
-
-	if (bsd_disklabel_le_dec(buf + 512, &label, MAXPARTITIONS)) {
-		close_device(device);
-		return INVALID_HANDLE_VALUE;
-	}
-
-	if (partition >= MAXPARTITIONS || !label.d_partitions[partition].p_size) {
-		close_device(device);
-		return INVALID_HANDLE_VALUE;
-	}
-
-	partition_offset = label.d_partitions[partition].p_offset;
-
-	return device;
-}
-
-// open a file
-HANDLE open_file_device(char *path)
-{
-	HANDLE device;
-
-	device = CreateFile(path, GENERIC_READ, FILE_SHARE_READ |
-	    FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-	if (device == INVALID_HANDLE_VALUE)
-		return INVALID_HANDLE_VALUE;
-
-	read_slice_table(device, &table, 0, 0);
-
-	slice_offset = 0;
-
-	return device;
-}
-
-void close_device(HANDLE device)
-{
-	CloseHandle(device);
-}
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <winioctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "diskio.h"
+#include "../stats.h"
+#include "../trace.h"
+
+// largest single ReadFile request
+#define MAX_READ_CHUNK (1 << 30)
+
+static void print_last_error(void)
+{
+	char msg[512];
+
+	FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM |
+	    FORMAT_MESSAGE_IGNORE_INSERTS, NULL, GetLastError(),
+	    MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+	    msg, sizeof(msg), NULL);
+	fprintf(stderr, "%s\n", msg);
+}
+
+// read whole sectors at an absolute, sector aligned offset.
+// the device's file pointer is not used, so this is safe to call on
+// handles shared between devices.
+static int read_sectors(disk_device *device, char *buf, int64_t offset,
+    int64_t numbytes)
+{
+	OVERLAPPED ov;
+	DWORD len, read;
+	int64_t start;
+
+	if (stats_enabled) {
+		STATS_ADD(discontig, offset != device->next_request);
+		device->next_request = offset + numbytes;
+	}
+
+	if (device->sim && sim_request(device->sim, offset, numbytes))
+		return -1;
+
+	if (device->memory) {
+		int64_t avail;
+
+		start = stats_begin();
+
+		avail = device->memory_size - offset;
+		if (avail < 0)
+			avail = 0;
+		if (avail > numbytes)
+			avail = numbytes;
+		memcpy(buf, device->memory + offset, (size_t)avail);
+		memset(buf + avail, 0, (size_t)(numbytes - avail));
+		device->nreads++;
+		device->nbytes += avail;
+		stats_request(avail, start);
+		return 0;
+	}
+
+	while (numbytes > 0) {
+		len = (DWORD)(numbytes > MAX_READ_CHUNK ? MAX_READ_CHUNK :
+		    numbytes);
+
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		ov.OffsetHigh = (DWORD)(offset >> 32);
+
+		start = stats_begin();
+		if (!ReadFile(device->handle, buf, len, &read, &ov)) {
+			print_last_error();
+			return -1;
+		}
+		device->nreads++;
+		device->nbytes += read;
+		stats_request(read, start);
+
+		// past the end of an image file
+		if (read < len)
+			memset(buf + read, 0, len - read);
+
+		buf += len;
+		offset += len;
+		numbytes -= len;
+	}
+
+	return 0;
+}
+
+int seek_absolute_device(disk_device *device, int64_t offset, int whence)
+{
+	LARGE_INTEGER size;
+
+	if (device == NULL)
+		return -1;
+
+	switch (whence) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			offset += device->position;
+			break;
+		case SEEK_END:
+			if (device->memory) {
+				offset += device->memory_size;
+				break;
+			}
+			if (!GetFileSizeEx(device->handle, &size))
+				return -1;
+			offset += size.QuadPart;
+			break;
+		default:
+			return -1;
+	}
+
+	if (offset < 0)
+		return -1;
+
+	device->position = offset;
+	STATS_ADD(seeks, 1);
+
+	return 0;
+}
+
+// a partition relative offset from the start of the disk
+int64_t device_absolute(disk_device *device, int64_t offset)
+{
+	if (device->partition_offset) {
+		offset += (int64_t)device->partition_offset *
+		    device->sector_size;
+	} else {
+		offset += (int64_t)device->slice_offset *
+		    device->sector_size;
+	}
+
+	return offset;
+}
+
+int seek_device(disk_device *device, int64_t offset, int whence)
+{
+	int ret;
+
+	if (device == NULL)
+		return -1;
+
+	TRACE_SEEK_ENTRY(offset, whence);
+
+	if (whence == SEEK_SET) {
+		offset = device_absolute(device, offset);
+	} else if (whence == SEEK_END) {
+		// fixme;
+	}
+
+	ret = seek_absolute_device(device, offset, whence);
+	TRACE_SEEK_RETURN(device->position, ret);
+
+	return ret;
+}
+
+static int read_unaligned(disk_device *device, char *buf, int64_t numbytes)
+{
+	int64_t start, len;
+	uint32_t head, ssize;
+
+	ssize = device->sector_size;
+	head = (uint32_t)(device->position % ssize);
+	start = device->position - head;
+
+	// leading partial sector
+	if (head && numbytes > 0) {
+		if (read_sectors(device, device->bounce, start, ssize))
+			return -1;
+
+		len = ssize - head;
+		if (len > numbytes)
+			len = numbytes;
+		memcpy(buf, device->bounce + head, len);
+		STATS_ADD(bounced, len);
+
+		buf += len;
+		numbytes -= len;
+		device->position += len;
+		start += ssize;
+	}
+
+	// whole sectors go straight to the caller's buffer
+	len = numbytes - numbytes % ssize;
+	if (len) {
+		if (read_sectors(device, buf, start, len))
+			return -1;
+
+		buf += len;
+		numbytes -= len;
+		device->position += len;
+		start += len;
+	}
+
+	// trailing partial sector
+	if (numbytes > 0) {
+		if (read_sectors(device, device->bounce, start, ssize))
+			return -1;
+
+		memcpy(buf, device->bounce, numbytes);
+		STATS_ADD(bounced, numbytes);
+		device->position += numbytes;
+	}
+
+	return 0;
+}
+
+int read_device(disk_device *device, char *buf, int64_t numbytes)
+{
+	int ret;
+
+	if (device == NULL)
+		return -1;
+
+	TRACE_READ_ENTRY(device->position, numbytes);
+	stats_read(numbytes);
+
+	if (device->ra && ra_read(device->ra, device->position, buf,
+	    numbytes)) {
+		device->position += numbytes;
+		TRACE_READ_RETURN(device->position, numbytes, 0);
+		return 0;
+	}
+
+	ret = read_unaligned(device, buf, numbytes);
+	TRACE_READ_RETURN(device->position, numbytes, ret);
+
+	return ret;
+}
+
+// how much a long sequential read should ask for at once
+int64_t device_io_size(disk_device *device)
+{
+	int rotational;
+
+	if (!device->tune.size) {
+		// a timing model knows better than the file under it
+		rotational = device->rotational;
+		if (device->sim)
+			rotational = device->sim->params.rpm > 0;
+		io_tune_init(&device->tune, device->io_min, device->io_opt,
+		    rotational);
+
+		stats.io_min = device->io_min;
+		stats.io_opt = device->io_opt;
+		stats.rotational = rotational;
+		stats.io_start = device->tune.start;
+		stats.io_size = device->tune.size;
+	}
+
+	return device->tune.size;
+}
+
+// ns for timing reads, virtual when there's a timing model
+int64_t device_clock(disk_device *device)
+{
+	if (device->sim)
+		return device->sim->clock;
+
+	return stats_now();
+}
+
+// a read of device_io_size() bytes that began at start has finished
+void device_io_done(disk_device *device, int64_t bytes, int64_t start)
+{
+	int changes;
+
+	changes = device->tune.changes;
+	io_tune_update(&device->tune, bytes, device_clock(device) - start);
+	// other threads' devices update these too
+	if (device->tune.changes != changes) {
+		InterlockedExchange64(&stats.io_size, device->tune.size);
+		STATS_ADD(io_changes, device->tune.changes - changes);
+	}
+}
+
+// start - offset of slice table
+// offset - offset of the first extended slice
+static int read_slice_table(disk_device *device, struct dos_table *dt,
+    uint32_t start, uint32_t offset)
+{
+	int i;
+	int32_t extstart;
+	char *buf;
+	char emptybuf[DOSPARTSIZE];
+	void *tablep;
+	struct dos_partition d;
+	struct dos_partition *dpnext;	// pointer to next entry to fill
+
+	TRACE_SLICE_TABLE(start, offset);
+
+	memset(emptybuf, 0, DOSPARTSIZE);
+
+	// intialize the dos_table struct
+	if (!offset) {
+		dt->dt_entrycount = 0;
+		dt->dt_partcount = 0;
+		dt->dt_partindex = 0;
+		dt->dt_numlogical = 0;
+		for (i = 0; i < NEXTDOSPART+1; ++i) {
+			dt->dt_partnum[i] = -1;
+		}
+	}
+
+	buf = malloc(device->sector_size);
+
+	seek_absolute_device(device, (int64_t)start * device->sector_size,
+	    SEEK_SET);
+	if (read_device(device, buf, device->sector_size) ||
+	    *(uint16_t*)(buf + DOSMAGICOFFSET) != DOSMAGIC) {
+		free(buf);
+		return -1;
+	}
+
+	extstart = -1;
+
+	// read the primary slices
+	// FIXME: cleanup
+	for (i = 0; i < 4 && dt->dt_partindex < NEXTDOSPART; ++i) {
+		tablep = &buf[DOSPARTOFF + i * DOSPARTSIZE];
+		dpnext = &dt->dt_slices[dt->dt_partindex];
+		dos_partition_dec(tablep, dpnext);
+		// set to absolute value
+		dpnext->dp_start += start;
+		if (dpnext->dp_typ == DOSPTYP_EXT ||
+		    dpnext->dp_typ == DOSPTYP_EXTLBA ||
+		    dpnext->dp_typ == 0x85) {
+			extstart = dpnext->dp_start;
+			if (!offset) {
+				dt->dt_partnum[i + 1] = dt->dt_partindex;
+				++dt->dt_partindex;
+				++dt->dt_partcount;
+			}
+			++dt->dt_entrycount;
+		} else {
+			if (memcmp(tablep, emptybuf, DOSPARTSIZE)) {
+				++dt->dt_entrycount;
+				++dt->dt_partcount;
+				if (!offset) {
+					dt->dt_partnum[i + 1] = dt->dt_partindex;
+				} else if (4 + dt->dt_numlogical < NEXTDOSPART) {
+					++dt->dt_numlogical;
+					dt->dt_partnum[4 + dt->dt_numlogical] =
+					    dt->dt_partindex;
+				}
+				++dt->dt_partindex;
+			} else if (!offset) {
+				++dt->dt_partindex;
+			}
+		}
+	}
+
+	// read logical slices
+	if (extstart >= 0) {
+		for (i = 0; i < 4; ++i) {
+			tablep = &buf[DOSPARTOFF + i * DOSPARTSIZE];
+			dos_partition_dec(tablep, &d);
+			if (d.dp_typ == DOSPTYP_EXT || 
+			    d.dp_typ == DOSPTYP_EXTLBA || d.dp_typ == 0x85) {
+				d.dp_start += offset;
+				read_slice_table(device, dt, d.dp_start,
+				    (offset ? offset : extstart));
+			}
+		}
+	}
+
+	TRACE_SLICE_TABLE_DONE(start, dt->dt_entrycount);
+
+	free(buf);
+	return 0;
+}
+
+// absolute sector offset of a bsdlabel partition. older labels store
+// absolute offsets, newer ones are relative to the slice, which shows
+// in where the raw partition starts.
+static uint32_t label_offset(const struct disklabel *label, int partition,
+    uint32_t slice_offset)
+{
+	uint32_t offset;
+
+	offset = label->d_partitions[partition].p_offset;
+	if (label->d_partitions[RAW_PART].p_offset != slice_offset)
+		offset += slice_offset;
+
+	return offset;
+}
+
+// have the file system share len bytes of the partition at offset with
+// dest at dest_offset, rather than copy them. both offsets and len must
+// be multiples of clone_unit, and dest already that long. the first
+// refusal, most likely dest being on another volume, turns it off.
+int device_clone_range(disk_device *device, int64_t offset, HANDLE dest,
+    int64_t dest_offset, int64_t len)
+{
+	DUPLICATE_EXTENTS_DATA extents;
+	DWORD returned;
+	int64_t n;
+
+	if (!device->clone_unit || device->memory)
+		return -1;
+
+	// a single request has to be shorter than 4GB
+	for (; len > 0; len -= n) {
+		n = len < ((int64_t)1 << 30) ? len : (int64_t)1 << 30;
+		extents.FileHandle = device->handle;
+		extents.SourceFileOffset.QuadPart = device_absolute(device,
+		    offset);
+		extents.TargetFileOffset.QuadPart = dest_offset;
+		extents.ByteCount.QuadPart = n;
+		if (!DeviceIoControl(dest, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+		    &extents, sizeof(extents), NULL, 0, &returned, NULL)) {
+			device->clone_unit = 0;
+			return -1;
+		}
+		offset += n;
+		dest_offset += n;
+	}
+
+	return 0;
+}
+
+// ask the storage stack what the disk under handle prefers. handle can
+// be a drive or a volume, image files ask their volume.
+static void query_storage(disk_device *device, HANDLE handle)
+{
+	STORAGE_PROPERTY_QUERY query;
+	STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR alignment;
+	STORAGE_ADAPTER_DESCRIPTOR adapter;
+	DEVICE_SEEK_PENALTY_DESCRIPTOR penalty;
+	DWORD returned;
+
+	memset(&query, 0, sizeof(query));
+	query.QueryType = PropertyStandardQuery;
+
+	query.PropertyId = StorageAccessAlignmentProperty;
+	if (DeviceIoControl(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query,
+	    sizeof(query), &alignment, sizeof(alignment), &returned, NULL) &&
+	    returned >= sizeof(alignment))
+		device->io_min = alignment.BytesPerPhysicalSector;
+
+	// windows has no preferred transfer size, the most the adapter
+	// takes in one request is the nearest thing
+	query.PropertyId = StorageAdapterProperty;
+	if (DeviceIoControl(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query,
+	    sizeof(query), &adapter, sizeof(adapter), &returned, NULL) &&
+	    returned >= sizeof(adapter))
+		device->io_opt = adapter.MaximumTransferLength;
+
+	query.PropertyId = StorageDeviceSeekPenaltyProperty;
+	if (DeviceIoControl(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query,
+	    sizeof(query), &penalty, sizeof(penalty), &returned, NULL) &&
+	    returned >= sizeof(penalty))
+		device->rotational = penalty.IncursSeekPenalty ? 1 : 0;
+}
+
+// the volume an image file lives on
+static void query_file_storage(disk_device *device, const char *path)
+{
+	char volume[MAX_PATH - 4], name[MAX_PATH];
+	HANDLE handle;
+	size_t len;
+
+	if (!GetVolumePathName(path, volume, sizeof(volume)))
+		return;
+	len = strlen(volume);
+	if (len && volume[len - 1] == '\\')
+		volume[--len] = '\0';
+
+	// no access is needed to query properties
+	sprintf(name, "\\\\.\\%s", volume);
+	handle = CreateFile(name, 0, FILE_SHARE_READ | FILE_SHARE_WRITE,
+	    NULL, OPEN_EXISTING, 0, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+	query_storage(device, handle);
+	CloseHandle(handle);
+}
+
+// whether the volume of an image file can clone blocks from it into other
+// files. only ReFS answers FSCTL_GET_INTEGRITY_INFORMATION, and with the
+// cluster size that cloned ranges must be aligned to.
+static void query_clone_unit(disk_device *device)
+{
+	FSCTL_GET_INTEGRITY_INFORMATION_BUFFER integrity;
+	DWORD returned;
+
+	if (DeviceIoControl(device->handle, FSCTL_GET_INTEGRITY_INFORMATION,
+	    NULL, 0, &integrity, sizeof(integrity), &returned, NULL) &&
+	    integrity.ClusterSizeInBytes >= 512)
+		device->clone_unit = integrity.ClusterSizeInBytes;
+}
+
+// wrap an open handle, the offsets start out at the beginning of the disk
+static disk_device *new_device(HANDLE handle)
+{
+	disk_device *device;
+	DISK_GEOMETRY geometry;
+	DWORD returned;
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	device = calloc(1, sizeof(*device));
+	device->handle = handle;
+	device->sector_size = 512;
+
+	// image files have no geometry and keep the 512 byte default
+	if (DeviceIoControl(handle, IOCTL_DISK_GET_DRIVE_GEOMETRY, NULL, 0,
+	    &geometry, sizeof(geometry), &returned, NULL) &&
+	    geometry.BytesPerSector >= 512) {
+		device->sector_size = geometry.BytesPerSector;
+	}
+	device->rotational = -1;
+	query_storage(device, handle);
+
+	device->bounce = malloc(device->sector_size);
+
+	return device;
+}
+
+static HANDLE open_drive_handle(int drive)
+{
+	char path[32];
+
+	sprintf(path, "\\\\.\\PhysicalDrive%d", drive);
+
+	return CreateFile(path, GENERIC_READ, FILE_SHARE_READ |
+	    FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+}
+
+// drive (0-based)
+disk_device *open_device(int drive)
+{
+	disk_device *device;
+
+	device = new_device(open_drive_handle(drive));
+	if (device == NULL)
+		return NULL;
+
+	read_slice_table(device, &device->table, 0, 0);
+
+	return device;
+}
+
+// drive (0-based)
+// slice (1-based)
+disk_device *open_slice_device(int drive, int slice)
+{
+	disk_device *device;
+	struct dos_table *table;
+
+	device = new_device(open_drive_handle(drive));
+	if (device == NULL) {
+		printf("open_slice_device: invalid handle\n");
+		return NULL;
+	}
+
+	table = &device->table;
+	read_slice_table(device, table, 0, 0);
+
+	printf("ec: %u\npc: %u\n\n\n", table->dt_entrycount,
+	    table->dt_partcount);
+
+	if (slice < 0 || slice > NEXTDOSPART) {
+		printf("open_slice_device: invalid slice\n");
+		close_device(device);
+		return NULL;
+	}
+
+	if (table->dt_partnum[slice] == -1 ||
+	    table->dt_slices[table->dt_partnum[slice]].dp_size == 0) {
+		printf("open_slice_device: invalid size\n");
+		close_device(device);
+		return NULL;
+	} else {
+		device->slice_offset =
+		    table->dt_slices[table->dt_partnum[slice]].dp_start;
+	}
+
+	return device;
+}
+
+// drive (0-based)
+// slice (1-based)
+// partition (0-based)
+disk_device *open_partition_device(int drive, int slice, int partition)
+{
+	disk_device *device;
+	struct dos_table *table;
+	char buf[BBSIZE];
+
+	if (slice < 0 || slice > NEXTDOSPART ||
+	    partition < 0 || partition >= MAXPARTITIONS)
+		return NULL;
+
+	device = new_device(open_drive_handle(drive));
+	if (device == NULL)
+		return NULL;
+
+	table = &device->table;
+
+	if (slice) {
+		read_slice_table(device, table, 0, 0);
+		if (table->dt_partnum[slice] == -1 ||
+		    table->dt_slices[table->dt_partnum[slice]].dp_size == 0) {
+			close_device(device);
+			return NULL;
+		} else {
+			device->slice_offset =
+			    table->dt_slices[table->dt_partnum[slice]].dp_start;
+		}
+	}
+
+	seek_device(device, 0, SEEK_SET);
+	if (read_device(device, buf, BBSIZE) ||
+	    bsd_disklabel_le_dec(buf + 512, &device->label, MAXPARTITIONS)) {
+		close_device(device);
+		return NULL;
+	}
+
+	if (!device->label.d_partitions[partition].p_size) {
+		close_device(device);
+		return NULL;
+	}
+
+	device->partition_offset = label_offset(&device->label, partition,
+	    device->slice_offset);
+
+	return device;
+}
+
+// open a file
+disk_device *open_file_device(char *path)
+{
+	disk_device *device;
+
+	device = new_device(CreateFile(path, GENERIC_READ, FILE_SHARE_READ |
+	    FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL));
+	if (device == NULL)
+		return NULL;
+	device->image = 1;
+	query_file_storage(device, path);
+	query_clone_unit(device);
+
+	read_slice_table(device, &device->table, 0, 0);
+
+	return device;
+}
+
+// an image already in memory, which the caller keeps until the device is
+// closed. mostly useful for benchmarks.
+disk_device *open_memory_device(const void *image, int64_t size)
+{
+	disk_device *device;
+
+	device = calloc(1, sizeof(*device));
+	device->handle = INVALID_HANDLE_VALUE;
+	device->memory = image;
+	device->memory_size = size;
+	device->sector_size = 512;
+	device->bounce = malloc(device->sector_size);
+	device->rotational = 0;
+
+	read_slice_table(device, &device->table, 0, 0);
+
+	return device;
+}
+
+// another device on the same disk with its own cursor, for use from a
+// different thread
+disk_device *clone_device(disk_device *device)
+{
+	disk_device *clone;
+	HANDLE handle;
+
+	handle = INVALID_HANDLE_VALUE;
+	if (!device->memory && !DuplicateHandle(GetCurrentProcess(),
+	    device->handle, GetCurrentProcess(), &handle, 0, FALSE,
+	    DUPLICATE_SAME_ACCESS))
+		return NULL;
+
+	clone = malloc(sizeof(*clone));
+	*clone = *device;
+	clone->handle = handle;
+	clone->position = 0;
+	clone->nreads = 0;
+	clone->nbytes = 0;
+	clone->ra = NULL;
+	clone->bounce = malloc(clone->sector_size);
+
+	return clone;
+}
+
+// read the bsdlabel of a slice and add its FFS partitions
+static int add_label_partitions(disk_device *device, int slice,
+    uint32_t slice_offset, struct disk_partition *parts, int n,
+    int maxparts)
+{
+	struct disklabel label;
+	char buf[BBSIZE];
+	int i;
+
+	seek_absolute_device(device, (int64_t)slice_offset *
+	    device->sector_size, SEEK_SET);
+	if (read_device(device, buf, BBSIZE) ||
+	    bsd_disklabel_le_dec(buf + 512, &label, MAXPARTITIONS))
+		return n;
+
+	for (i = 0; i < label.d_npartitions && n < maxparts; ++i) {
+		if (i == RAW_PART || !label.d_partitions[i].p_size ||
+		    label.d_partitions[i].p_fstype != FS_BSDFFS)
+			continue;
+
+		parts[n].dp_slice = slice;
+		parts[n].dp_partition = i;
+		parts[n].dp_offset = label_offset(&label, i, slice_offset);
+		parts[n].dp_size = label.d_partitions[i].p_size;
+		++n;
+	}
+
+	return n;
+}
+
+// find every FFS partition on a whole disk (or disk image), using the
+// slice table read when the device was opened. returns the number of
+// partitions found.
+int find_partitions(disk_device *device, struct disk_partition *parts,
+    int maxparts)
+{
+	struct dos_table *table = &device->table;
+	struct dos_partition *dp;
+	int slice, n;
+
+	n = 0;
+	for (slice = 1; slice <= NEXTDOSPART && n < maxparts; ++slice) {
+		if (table->dt_partnum[slice] == -1)
+			continue;
+
+		dp = &table->dt_slices[table->dt_partnum[slice]];
+		if (dp->dp_size == 0 || dp->dp_typ == DOSPTYP_EXT ||
+		    dp->dp_typ == DOSPTYP_EXTLBA || dp->dp_typ == 0x85)
+			continue;
+
+		n = add_label_partitions(device, slice, dp->dp_start, parts,
+		    n, maxparts);
+	}
+
+	// dangerously dedicated disk, the label is at the very start
+	if (n == 0)
+		n = add_label_partitions(device, 0, 0, parts, 0, maxparts);
+
+	return n;
+}
+
+void close_device(disk_device *device)
+{
+	if (device == NULL)
+		return;
+
+	ra_free(device->ra);
+	if (device->handle != INVALID_HANDLE_VALUE)
+		CloseHandle(device->handle);
+	free(device->bounce);
+	free(device);
+}
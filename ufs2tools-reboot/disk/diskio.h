@@ -1,62 +1,116 @@
-/*
- * Copyright (c) 2004 Nehal Mistry
- * All rights reserved.
- * 
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission.
- * 
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
- * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
- * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
- * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
- * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#ifndef _DISKIO_H_
-#define _DISKIO_H_
-
-#include <stdint.h>
-#include <windows.h>
-
-#include "diskmbr.h"
-#include "disklabel.h"
-
-struct dos_table {
-	unsigned char dt_entrycount;	/* entry count, includes any
-					   extended slices */
-	unsigned char dt_partcount;	/* slice count */
-	int dt_partnum[NEXTDOSPART+1];
-					/* linked list, unix slice
-					   number => partnum entry,
-					   -1 if invalid entry */
-	struct dos_partition dt_slices[NEXTDOSPART];
-					/* slice entries */
-};
-
-extern uint32_t slice_offset;
-extern uint32_t partition_offset;
-
-extern int seek_device(HANDLE device, int64_t offset, int whence);
-extern int seek_absolute_device(HANDLE device, int64_t offset, int whence);
-extern int read_device(HANDLE device, char *buf, int64_t numbytes);
-
-extern HANDLE open_device(int drive);
-extern HANDLE open_file_device(char *path);
-extern HANDLE open_slice_device(int drive, int slice);
-extern HANDLE open_partition_device(int drive, int slice, int partition);
-extern void close_device(HANDLE device);
-
-#endif
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DISKIO_H_
+#define _DISKIO_H_
+
+#include <stdint.h>
+#include <windows.h>
+
+#include "diskmbr.h"
+#include "disklabel.h"
+#include "simdisk.h"
+#include "iosize.h"
+#include "readahead.h"
+#include "../memcount.h"
+
+struct dos_table {
+	unsigned char dt_entrycount;	/* entry count, includes any
+					   extended slices */
+	unsigned char dt_partcount;	/* slice count */
+	int dt_partnum[NEXTDOSPART+1];
+					/* linked list, unix slice
+					   number => partnum entry,
+					   -1 if invalid entry */
+	struct dos_partition dt_slices[NEXTDOSPART];
+					/* slice entries */
+	int dt_partindex;		/* next dt_slices entry to fill */
+	int dt_numlogical;		/* logical slices found so far */
+};
+
+// everything needed to address one open drive, slice or partition.
+// each device owns its own cursor, so separate devices (or clones of
+// one device) may be read from different threads at the same time.
+typedef struct _disk_device_ {
+	HANDLE handle;
+	int image;			/* an image file, not a drive */
+	const char *memory;		/* image in memory, instead of handle */
+	int64_t memory_size;
+	uint32_t sector_size;		/* bytes per sector */
+	uint32_t io_min;		/* physical sector, 0 if not reported */
+	uint32_t io_opt;		/* largest transfer, 0 if not reported */
+	int rotational;			/* seeks are slow, -1 if not reported */
+	io_tuner tune;			/* size of long reads, see iosize.h */
+	uint32_t clone_unit;		/* cluster size if the image's volume
+					   can clone blocks, else 0 */
+	uint32_t slice_offset;		/* in sectors, 0 for whole disk */
+	uint32_t partition_offset;	/* in sectors, 0 if no bsdlabel */
+	int64_t position;		/* absolute byte offset of next read */
+	char *bounce;			/* one sector, for unaligned reads */
+	int64_t nreads;			/* read requests issued */
+	int64_t nbytes;			/* bytes those requests returned */
+	int64_t next_request;		/* offset just past the last one */
+	sim_disk *sim;			/* timing model, if any */
+	read_ahead *ra;			/* see readahead.h, NULL if none */
+	struct dos_table table;
+	struct disklabel label;
+} disk_device;
+
+// an FFS partition found by find_partitions()
+struct disk_partition {
+	int dp_slice;			/* 1-based, 0 if no slice table */
+	int dp_partition;		/* 0-based bsdlabel index */
+	uint32_t dp_offset;		/* absolute, in sectors */
+	uint32_t dp_size;		/* in sectors */
+};
+
+extern int64_t device_absolute(disk_device *device, int64_t offset);
+extern int seek_device(disk_device *device, int64_t offset, int whence);
+extern int seek_absolute_device(disk_device *device, int64_t offset,
+    int whence);
+extern int read_device(disk_device *device, char *buf, int64_t numbytes);
+
+extern int64_t device_io_size(disk_device *device);
+extern int64_t device_clock(disk_device *device);
+extern void device_io_done(disk_device *device, int64_t bytes,
+    int64_t start);
+extern int device_clone_range(disk_device *device, int64_t offset,
+    HANDLE dest, int64_t dest_offset, int64_t len);
+
+extern disk_device *open_device(int drive);
+extern disk_device *open_file_device(char *path);
+extern disk_device *open_slice_device(int drive, int slice);
+extern disk_device *open_partition_device(int drive, int slice,
+    int partition);
+extern disk_device *open_memory_device(const void *image, int64_t size);
+extern disk_device *clone_device(disk_device *device);
+extern void close_device(disk_device *device);
+
+extern int find_partitions(disk_device *device, struct disk_partition *parts,
+    int maxparts);
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iosize.h"
+
+// a decision needs this many reads, and this much time so a fast
+// device's page cache noise averages out
+#define WINDOW_READS	8
+#define WINDOW_NS	50000000LL
+
+// better or worse only counts beyond this
+#define RATE_NOISE	1.05
+// a settled tuner climbs again below this part of its best
+#define RATE_DROP	0.7
+
+static int64_t pow2_at_least(int64_t n)
+{
+	int64_t p;
+
+	for (p = 1; p < n; p <<= 1)
+		;
+
+	return p;
+}
+
+static int64_t clamp_size(const io_tuner *tune, int64_t size)
+{
+	if (size < tune->min)
+		return tune->min;
+	if (size > tune->max)
+		return tune->max;
+	return size;
+}
+
+// io_min and io_opt are in bytes, 0 if the device didn't say. rotational
+// is -1 if unknown.
+void io_tune_init(io_tuner *tune, uint32_t io_min, uint32_t io_opt,
+    int rotational)
+{
+	memset(tune, 0, sizeof(*tune));
+	tune->min = pow2_at_least(io_min > IO_SIZE_MIN ? io_min : IO_SIZE_MIN);
+	tune->max = IO_SIZE_MAX;
+	if (tune->min > tune->max)
+		tune->max = tune->min;
+
+	// without a preferred size, disks want long reads to hide the seek,
+	// flash gets there sooner. unknown keeps the old fixed 2 MB.
+	if (io_opt)
+		tune->start = pow2_at_least(io_opt);
+	else if (rotational == 0)
+		tune->start = 1 << 20;
+	else
+		tune->start = 2 << 20;
+	tune->start = clamp_size(tune, tune->start);
+
+	tune->size = tune->start;
+	tune->best = tune->start;
+	tune->direction = 1;
+}
+
+// always use size, for runs that must repeat exactly
+void io_tune_fixed(io_tuner *tune, int64_t size)
+{
+	memset(tune, 0, sizeof(*tune));
+	tune->min = size;
+	tune->max = size;
+	tune->start = size;
+	tune->size = size;
+	tune->best = size;
+	tune->settled = 1;
+}
+
+// step away from the best size, or settle there if that's out of bounds
+static void next_size(io_tuner *tune)
+{
+	int64_t size;
+
+	size = tune->direction > 0 ? tune->best * 2 : tune->best / 2;
+	if (size < tune->min || size > tune->max) {
+		if (++tune->turns >= 2) {
+			tune->settled = 1;
+			size = tune->best;
+		} else {
+			tune->direction = -tune->direction;
+			size = tune->direction > 0 ?
+			    tune->best * 2 : tune->best / 2;
+			if (size < tune->min || size > tune->max) {
+				tune->settled = 1;
+				size = tune->best;
+			}
+		}
+	}
+
+	if (size != tune->size)
+		tune->changes++;
+	tune->size = size;
+}
+
+// a read of bytes, issued at the current size, took ns
+void io_tune_update(io_tuner *tune, int64_t bytes, int64_t ns)
+{
+	double rate;
+
+	tune->window_bytes += bytes;
+	tune->window_ns += ns;
+	if (++tune->window_reads < WINDOW_READS ||
+	    tune->window_ns < WINDOW_NS)
+		return;
+
+	rate = tune->window_bytes * 1e9 / tune->window_ns;
+	tune->window_bytes = 0;
+	tune->window_ns = 0;
+	tune->window_reads = 0;
+
+	if (tune->settled) {
+		if (rate >= tune->best_rate * RATE_DROP)
+			return;
+		// the device changed under us, look again from here
+		tune->settled = 0;
+		tune->turns = 0;
+		tune->best = tune->size;
+		tune->best_rate = rate;
+		next_size(tune);
+		return;
+	}
+
+	if (tune->best_rate == 0 || rate > tune->best_rate * RATE_NOISE) {
+		tune->best_rate = rate;
+		tune->best = tune->size;
+	} else if (tune->size != tune->best) {
+		// no better than the best, turn around or stop
+		if (++tune->turns >= 2) {
+			tune->settled = 1;
+			tune->changes++;
+			tune->size = tune->best;
+			return;
+		}
+		tune->direction = -tune->direction;
+	}
+
+	next_size(tune);
+}
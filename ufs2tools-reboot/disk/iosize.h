@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _IOSIZE_H_
+#define _IOSIZE_H_
+
+#include <stdint.h>
+
+// picks the size of the large sequential reads copy_file() issues. it
+// starts from what the device reports and then hill-climbs: after each
+// window of reads it compares the throughput with the best seen so far,
+// keeps doubling or halving while that helps, turns around once when it
+// stops helping, and settles on the best size after the second turn. a
+// settled tuner starts climbing again if throughput drops well below
+// what it settled on.
+
+#define IO_SIZE_MIN	(64 << 10)
+#define IO_SIZE_MAX	(8 << 20)
+
+typedef struct _io_tuner_ {
+	int64_t min;			/* bounds on size, powers of 2 */
+	int64_t max;
+	int64_t start;			/* first size tried */
+	int64_t size;			/* current */
+	int64_t best;			/* size with the best throughput */
+	double best_rate;		/* its bytes per second */
+	int direction;			/* 1 doubles, -1 halves */
+	int turns;			/* times direction changed */
+	int settled;
+	int changes;			/* times size changed */
+	int64_t window_bytes;		/* measured since the last decision */
+	int64_t window_ns;
+	int window_reads;
+} io_tuner;
+
+extern void io_tune_init(io_tuner *tune, uint32_t io_min, uint32_t io_opt,
+    int rotational);
+extern void io_tune_fixed(io_tuner *tune, int64_t size);
+extern void io_tune_update(io_tuner *tune, int64_t bytes, int64_t ns);
+
+#endif
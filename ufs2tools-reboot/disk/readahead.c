@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "diskio.h"
+#include "readahead.h"
+#include "../stats.h"
+
+int readahead_enabled;
+
+// an extent no longer needed. what was fetched but never read is counted,
+// so the window sizes can be tuned against it. called locked.
+static void drop_extent(read_ahead *ra, struct ra_extent *e)
+{
+	if (e->state == RA_READY)
+		STATS_ADD(ra_wasted, e->len - e->used);
+	ra->buffered -= e->len;
+	free(e->data);
+	e->data = NULL;
+	e->state = RA_FREE;
+}
+
+// a stream stopped reading in order, or is being reused for another
+// file. called locked.
+static void drop_stream(read_ahead *ra, struct ra_stream *s)
+{
+	int i;
+
+	for (i = 0; i < RA_EXTENTS; ++i) {
+		if (ra->extents[i].stream == s &&
+		    (ra->extents[i].state == RA_QUEUED ||
+		    ra->extents[i].state == RA_READY))
+			drop_extent(ra, &ra->extents[i]);
+	}
+}
+
+// a stream read on past these: fetched for it but ending before start,
+// they won't be asked for. called locked.
+static void drop_behind(read_ahead *ra, struct ra_stream *s, int64_t start)
+{
+	int i;
+
+	for (i = 0; i < RA_EXTENTS; ++i) {
+		if (ra->extents[i].stream == s && ra->extents[i].end <= start &&
+		    (ra->extents[i].state == RA_QUEUED ||
+		    ra->extents[i].state == RA_READY))
+			drop_extent(ra, &ra->extents[i]);
+	}
+}
+
+// the extent holding the absolute offset, if any. called locked.
+static struct ra_extent *find_extent(read_ahead *ra, int64_t offset)
+{
+	int i;
+
+	for (i = 0; i < RA_EXTENTS; ++i) {
+		if (ra->extents[i].state != RA_FREE &&
+		    ra->extents[i].offset <= offset &&
+		    offset < ra->extents[i].offset + ra->extents[i].len)
+			return &ra->extents[i];
+	}
+
+	return NULL;
+}
+
+static DWORD WINAPI ra_worker(LPVOID arg)
+{
+	read_ahead *ra = arg;
+	struct ra_extent *e;
+	char *data;
+	int i, ret;
+
+	EnterCriticalSection(&ra->lock);
+	for (;;) {
+		e = NULL;
+		for (i = 0; i < RA_EXTENTS; ++i) {
+			if (ra->extents[i].state == RA_QUEUED &&
+			    (!e || ra->extents[i].seq < e->seq))
+				e = &ra->extents[i];
+		}
+		if (ra->stopping)
+			break;
+		if (!e) {
+			SleepConditionVariableCS(&ra->queued, &ra->lock,
+			    INFINITE);
+			continue;
+		}
+
+		// nobody takes a loading extent away, so it can be read
+		// without the lock
+		e->state = RA_LOADING;
+		LeaveCriticalSection(&ra->lock);
+
+		data = malloc(e->len);
+		ret = data == NULL ||
+		    seek_absolute_device(ra->reader, e->offset, SEEK_SET) ||
+		    read_device(ra->reader, data, e->len);
+
+		EnterCriticalSection(&ra->lock);
+		if (ret) {
+			// the reader gets the error when it reads this itself
+			free(data);
+			ra->buffered -= e->len;
+			e->state = RA_FREE;
+		} else {
+			e->data = data;
+			e->state = RA_READY;
+			STATS_ADD(ra_fetched, e->len);
+		}
+		WakeAllConditionVariable(&ra->loaded);
+	}
+	LeaveCriticalSection(&ra->lock);
+
+	return 0;
+}
+
+read_ahead *ra_create(disk_device *device)
+{
+	read_ahead *ra;
+	HANDLE handle;
+
+	if (device->memory)
+		return NULL;
+
+	ra = calloc(1, sizeof(*ra));
+	ra->reader = clone_device(device);
+	if (ra->reader == NULL) {
+		free(ra);
+		return NULL;
+	}
+
+	// on an image file, tell the cache manager the thread streams data
+	// and everything else, inodes and directories mostly, jumps around
+	if (device->image) {
+		handle = ReOpenFile(ra->reader->handle, GENERIC_READ,
+		    FILE_SHARE_READ | FILE_SHARE_WRITE,
+		    FILE_FLAG_SEQUENTIAL_SCAN);
+		if (handle != INVALID_HANDLE_VALUE) {
+			CloseHandle(ra->reader->handle);
+			ra->reader->handle = handle;
+		}
+		handle = ReOpenFile(device->handle, GENERIC_READ,
+		    FILE_SHARE_READ | FILE_SHARE_WRITE,
+		    FILE_FLAG_RANDOM_ACCESS);
+		if (handle != INVALID_HANDLE_VALUE) {
+			CloseHandle(device->handle);
+			device->handle = handle;
+		}
+	}
+
+	InitializeCriticalSection(&ra->lock);
+	InitializeConditionVariable(&ra->queued);
+	InitializeConditionVariable(&ra->loaded);
+
+	ra->thread = CreateThread(NULL, 0, ra_worker, ra, 0, NULL);
+	if (ra->thread == NULL) {
+		DeleteCriticalSection(&ra->lock);
+		close_device(ra->reader);
+		free(ra);
+		return NULL;
+	}
+
+	return ra;
+}
+
+void ra_free(read_ahead *ra)
+{
+	int i;
+
+	if (ra == NULL)
+		return;
+
+	EnterCriticalSection(&ra->lock);
+	ra->stopping = 1;
+	WakeAllConditionVariable(&ra->queued);
+	LeaveCriticalSection(&ra->lock);
+
+	WaitForSingleObject(ra->thread, INFINITE);
+	CloseHandle(ra->thread);
+
+	for (i = 0; i < RA_EXTENTS; ++i) {
+		if (ra->extents[i].state != RA_FREE)
+			drop_extent(ra, &ra->extents[i]);
+	}
+
+	DeleteCriticalSection(&ra->lock);
+	close_device(ra->reader);
+	free(ra);
+}
+
+// a read of count fragments at start, bytes long, of the file key. returns
+// how many bytes past it should be fetched.
+int64_t ra_access(read_ahead *ra, const void *key, int64_t start,
+    int64_t count, int64_t bytes)
+{
+	struct ra_stream *s, *oldest;
+	int i;
+
+	EnterCriticalSection(&ra->lock);
+
+	s = oldest = NULL;
+	for (i = 0; i < RA_STREAMS; ++i) {
+		if (ra->streams[i].key == key)
+			s = &ra->streams[i];
+		if (!oldest || ra->streams[i].used < oldest->used)
+			oldest = &ra->streams[i];
+	}
+
+	if (s == NULL || start == 0) {
+		// a file read from its start will likely be read through
+		if (s == NULL)
+			s = oldest;
+		drop_stream(ra, s);
+		s->key = key;
+		s->window = start == 0 ? bytes : 0;
+	} else if (start == s->next) {
+		drop_behind(ra, s, start);
+		s->window = s->window ? s->window * 2 : bytes;
+		if (s->window > RA_MAX_WINDOW)
+			s->window = RA_MAX_WINDOW;
+	} else {
+		drop_stream(ra, s);
+		s->window /= 2;
+		if (s->window < bytes)
+			s->window = 0;
+	}
+
+	ra->current = s;
+	s->next = start + count;
+	s->used = ++ra->seq;
+
+	LeaveCriticalSection(&ra->lock);
+
+	return s->window;
+}
+
+// fetch len bytes at offset, relative to the partition like seek_device(),
+// which end before fragment end of the file
+void ra_queue(read_ahead *ra, int64_t offset, int64_t len, int64_t end)
+{
+	struct ra_extent *e;
+	int i;
+
+	offset = device_absolute(ra->reader, offset);
+
+	EnterCriticalSection(&ra->lock);
+
+	e = NULL;
+	for (i = 0; i < RA_EXTENTS; ++i) {
+		if (ra->extents[i].state == RA_FREE) {
+			if (!e)
+				e = &ra->extents[i];
+			continue;
+		}
+		// already on its way
+		if (offset < ra->extents[i].offset + ra->extents[i].len &&
+		    ra->extents[i].offset < offset + len) {
+			LeaveCriticalSection(&ra->lock);
+			return;
+		}
+	}
+
+	// full. what's there is still ahead of the reader, so this waits
+	// until the reader has caught up and queues it again
+	if (!e || ra->buffered + len > RA_MAX_WINDOW) {
+		LeaveCriticalSection(&ra->lock);
+		return;
+	}
+
+	e->stream = ra->current;
+	e->offset = offset;
+	e->len = len;
+	e->used = 0;
+	e->seq = ++ra->seq;
+	e->end = end;
+	e->state = RA_QUEUED;
+	ra->buffered += len;
+	WakeAllConditionVariable(&ra->queued);
+
+	LeaveCriticalSection(&ra->lock);
+}
+
+// copy len bytes at the absolute offset, if they were fetched, from as
+// many extents as they span. returns 0 if the caller has to read them
+// itself.
+int ra_read(read_ahead *ra, int64_t offset, char *buf, int64_t len)
+{
+	struct ra_extent *e, *loading;
+	int64_t pos, n;
+
+	EnterCriticalSection(&ra->lock);
+
+	for (;;) {
+		e = loading = NULL;
+		for (pos = offset; pos < offset + len; pos = e->offset + e->len) {
+			if ((e = find_extent(ra, pos)) == NULL)
+				break;
+			// not started, reading it here is as quick
+			if (e->state == RA_QUEUED) {
+				drop_extent(ra, e);
+				e = NULL;
+				break;
+			}
+			if (e->state == RA_LOADING)
+				loading = e;
+		}
+		if (e == NULL || loading == NULL)
+			break;
+		SleepConditionVariableCS(&ra->loaded, &ra->lock, INFINITE);
+	}
+	if (e == NULL) {
+		LeaveCriticalSection(&ra->lock);
+		return 0;
+	}
+
+	for (pos = offset; pos < offset + len; pos += n) {
+		e = find_extent(ra, pos);
+		n = e->offset + e->len - pos;
+		if (n > offset + len - pos)
+			n = offset + len - pos;
+		memcpy(buf + (pos - offset), e->data + (pos - e->offset),
+		    (size_t)n);
+		e->used += n;
+		if (e->used >= e->len)
+			drop_extent(ra, e);
+	}
+	STATS_ADD(ra_used, len);
+
+	LeaveCriticalSection(&ra->lock);
+
+	return 1;
+}
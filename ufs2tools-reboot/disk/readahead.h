@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _READAHEAD_H_
+#define _READAHEAD_H_
+
+#include <windows.h>
+#include <stdint.h>
+
+// read-ahead for files read in order. ufs_read_data() reports which
+// fragments of which file it just read; while a file keeps being read
+// where the last read ended, the window fetched ahead of it doubles up
+// to RA_MAX_WINDOW, and a read anywhere else halves it and drops what
+// was fetched for the file. the extents in
+// the window are read by a thread with its own cursor into buffers, and
+// read_device() copies from those when they cover the request.
+//
+// each device gets its own, made the first time it's needed while
+// readahead_enabled is set. clones don't share it.
+
+#define RA_EXTENTS	32
+#define RA_STREAMS	4
+#define RA_MAX_WINDOW	(32 << 20)
+
+struct _disk_device_;
+
+enum ra_state {
+	RA_FREE,
+	RA_QUEUED,			/* waiting for the thread */
+	RA_LOADING,			/* being read, wait for it */
+	RA_READY
+};
+
+struct ra_stream;
+
+struct ra_extent {
+	struct ra_stream *stream;	/* the file it was fetched for */
+	int64_t offset;			/* absolute, in bytes */
+	int64_t len;
+	int64_t used;			/* bytes read_device() took */
+	int64_t seq;			/* queue order */
+	int64_t end;			/* fragment of the file after it */
+	char *data;
+	enum ra_state state;
+};
+
+// one file being read
+struct ra_stream {
+	const void *key;		/* its block list */
+	int64_t next;			/* fragment an in order read starts at */
+	int64_t window;			/* bytes to keep ahead, 0 for none */
+	int64_t used;			/* for replacing the oldest */
+};
+
+typedef struct _read_ahead_ {
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE queued;	/* an extent was queued, or stopping */
+	CONDITION_VARIABLE loaded;	/* an extent finished loading */
+	struct _disk_device_ *reader;	/* the thread's own cursor */
+	HANDLE thread;
+	int stopping;
+	struct ra_stream *current;	/* of the last ra_access() */
+	int64_t seq;
+	int64_t buffered;		/* bytes queued, loading or ready */
+	struct ra_extent extents[RA_EXTENTS];
+	struct ra_stream streams[RA_STREAMS];
+} read_ahead;
+
+extern int readahead_enabled;
+
+extern read_ahead *ra_create(struct _disk_device_ *device);
+extern void ra_free(read_ahead *ra);
+extern int64_t ra_access(read_ahead *ra, const void *key, int64_t start,
+    int64_t count, int64_t bytes);
+extern void ra_queue(read_ahead *ra, int64_t offset, int64_t len,
+    int64_t end);
+extern int ra_read(read_ahead *ra, int64_t offset, char *buf, int64_t len);
+
+#endif
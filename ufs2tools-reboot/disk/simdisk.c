@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "simdisk.h"
+
+struct sim_profile {
+	const char *name;
+	sim_params params;
+};
+
+// starting points, any field can be changed in the spec
+static const struct sim_profile profiles[] = {
+	// 7200 rpm desktop disk, image at the start of 1 TB
+	{ "hdd", { 1LL << 40, 0.8, 18.0, 7200, 1 << 20, 50, 150, 0 } },
+	// 5400 rpm laptop disk behind a usb-sata bridge
+	{ "usb", { 1LL << 40, 1.0, 22.0, 5400, 1 << 20, 250, 100, 0 } },
+	// usb flash stick
+	{ "flash", { 1LL << 40, 0, 0, 0, 0, 500, 30, 0 } },
+	{ "ssd", { 1LL << 40, 0, 0, 0, 0, 60, 500, 0 } },
+};
+
+// "fail=sector[+count]" or "slow=sector[+count]:ms"
+static int parse_fault(sim_disk *sim, char *value, int fail)
+{
+	struct sim_fault *f;
+	char *end;
+
+	if (sim->nfaults == SIM_MAX_FAULTS)
+		return -1;
+	f = &sim->faults[sim->nfaults];
+
+	f->fail = fail;
+	f->count = 1;
+	f->delay_ms = 0;
+	f->sector = _strtoi64(value, &end, 0);
+	if (*end == '+')
+		f->count = _strtoi64(end + 1, &end, 0);
+	if (!fail) {
+		if (*end != ':')
+			return -1;
+		f->delay_ms = strtod(end + 1, &end);
+	}
+	if (*end != '\0' || f->sector < 0 || f->count < 1)
+		return -1;
+
+	++sim->nfaults;
+	return 0;
+}
+
+/*
+ * profile[,key=value...], eg. "hdd,rpm=5400,fail=2048+8,slow=4096:500"
+ *   profile	hdd, usb, flash or ssd
+ *   rpm, seek_track and seek_full (ms), overhead (us), bw (MB/s),
+ *   track (KB), capacity (GB), realtime (0 or 1)
+ *   fail=sector[+count]	requests touching these sectors fail
+ *   slow=sector[+count]:ms	and these take ms longer
+ */
+sim_disk *sim_create(const char *spec)
+{
+	sim_disk *sim;
+	char *copy, *tok, *value, *end;
+	int i, bad;
+
+	copy = strdup(spec);
+	sim = calloc(1, sizeof(*sim));
+
+	tok = strtok(copy, ",");
+	for (i = 0; tok && i < sizeof(profiles) / sizeof(profiles[0]); ++i) {
+		if (!strcmp(tok, profiles[i].name))
+			break;
+	}
+	if (tok == NULL || i == sizeof(profiles) / sizeof(profiles[0])) {
+		fprintf(stderr, "simdisk: unknown profile \"%s\"\n",
+		    tok ? tok : "");
+		free(copy);
+		free(sim);
+		return NULL;
+	}
+	sim->params = profiles[i].params;
+
+	bad = 0;
+	while (!bad && (tok = strtok(NULL, ","))) {
+		if ((value = strchr(tok, '=')) == NULL) {
+			bad = 1;
+			break;
+		}
+		*value++ = '\0';
+		end = value + strlen(value);
+
+		if (!strcmp(tok, "fail"))
+			bad = parse_fault(sim, value, 1);
+		else if (!strcmp(tok, "slow"))
+			bad = parse_fault(sim, value, 0);
+		else if (!strcmp(tok, "rpm"))
+			sim->params.rpm = strtod(value, &end);
+		else if (!strcmp(tok, "seek_track"))
+			sim->params.seek_track_ms = strtod(value, &end);
+		else if (!strcmp(tok, "seek_full"))
+			sim->params.seek_full_ms = strtod(value, &end);
+		else if (!strcmp(tok, "overhead"))
+			sim->params.overhead_us = strtod(value, &end);
+		else if (!strcmp(tok, "bw"))
+			sim->params.bandwidth = strtod(value, &end);
+		else if (!strcmp(tok, "track"))
+			sim->params.track_bytes = _strtoi64(value, &end, 0) << 10;
+		else if (!strcmp(tok, "capacity"))
+			sim->params.capacity = _strtoi64(value, &end, 0) << 30;
+		else if (!strcmp(tok, "realtime"))
+			sim->params.realtime = strtol(value, &end, 0);
+		else
+			bad = 1;
+
+		if (*end != '\0')
+			bad = 1;
+	}
+	free(copy);
+
+	if (bad || sim->params.bandwidth <= 0 || sim->params.capacity <= 0) {
+		fprintf(stderr, "simdisk: bad spec \"%s\"\n", spec);
+		free(sim);
+		return NULL;
+	}
+
+	InitializeCriticalSection(&sim->lock);
+
+	return sim;
+}
+
+void sim_free(sim_disk *sim)
+{
+	if (sim == NULL)
+		return;
+
+	DeleteCriticalSection(&sim->lock);
+	free(sim);
+}
+
+static int64_t seek_time(const sim_params *p, int64_t distance)
+{
+	double ms;
+
+	if (p->track_bytes && distance < p->track_bytes)
+		return 0;
+
+	ms = p->seek_track_ms + (p->seek_full_ms - p->seek_track_ms) *
+	    sqrt((double)distance / p->capacity);
+	if (ms > p->seek_full_ms)
+		ms = p->seek_full_ms;
+
+	return (int64_t)(ms * 1e6);
+}
+
+// time until the start of offset passes under the head, at time now
+static int64_t rotate_time(const sim_params *p, int64_t offset, int64_t now)
+{
+	double period, angle, target, wait;
+
+	if (p->rpm <= 0 || p->track_bytes <= 0)
+		return 0;
+
+	period = 60e9 / p->rpm;
+	angle = fmod((double)now, period) / period;
+	target = (double)(offset % p->track_bytes) / p->track_bytes;
+	wait = target - angle;
+	if (wait < 0)
+		wait += 1;
+
+	return (int64_t)(wait * period);
+}
+
+// charge a request to the clock. -1 if it touches a failing sector.
+int sim_request(sim_disk *sim, int64_t offset, int64_t numbytes)
+{
+	const sim_params *p = &sim->params;
+	int64_t cost, t, first, last, distance;
+	int i, ret;
+
+	first = offset / 512;
+	last = (offset + numbytes - 1) / 512;
+	ret = 0;
+
+	EnterCriticalSection(&sim->lock);
+
+	cost = (int64_t)(p->overhead_us * 1e3);
+
+	if (offset != sim->head) {
+		distance = offset - sim->head;
+		if (distance < 0)
+			distance = -distance;
+		t = seek_time(p, distance);
+		sim->seek_ns += t;
+		cost += t;
+
+		t = rotate_time(p, offset, sim->clock + cost);
+		sim->rotate_ns += t;
+		cost += t;
+
+		++sim->seeks;
+	}
+
+	t = (int64_t)(numbytes * 1e3 / p->bandwidth);
+	sim->transfer_ns += t;
+	cost += t;
+
+	for (i = 0; i < sim->nfaults; ++i) {
+		const struct sim_fault *f = &sim->faults[i];
+
+		if (last < f->sector || first >= f->sector + f->count)
+			continue;
+		if (f->fail) {
+			ret = -1;
+		} else {
+			cost += (int64_t)(f->delay_ms * 1e6);
+			++sim->slow;
+		}
+	}
+	if (ret)
+		++sim->failed;
+
+	++sim->requests;
+	sim->clock += cost;
+	sim->head = offset + numbytes;
+
+	// sleep in whole milliseconds, carrying the rest over
+	if (p->realtime) {
+		sim->debt += cost;
+		if (sim->debt >= 1000000) {
+			Sleep((DWORD)(sim->debt / 1000000));
+			sim->debt %= 1000000;
+		}
+	}
+
+	LeaveCriticalSection(&sim->lock);
+
+	if (ret)
+		fprintf(stderr, "simdisk: read error in sectors %I64d-%I64d\n",
+		    first, last);
+
+	return ret;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SIMDISK_H_
+#define _SIMDISK_H_
+
+#include <windows.h>
+#include <stdint.h>
+
+// a timing model of a disk, attached to a device with device->sim. every
+// request read_sectors() issues is charged to a virtual clock: a fixed
+// per-request overhead, a seek that grows with the square root of the
+// distance, the rotational wait for the target sector and the transfer
+// at media rate. a request starting where the last one ended doesn't seek
+// or wait. the data itself still comes from the device, so results are
+// the same and the timing repeats exactly from run to run.
+//
+// clones share their device's model, as they share the disk head. the
+// model belongs to whoever attached it, close_device() leaves it alone.
+//
+// it needs no disk, but it is Win32 code like the rest of the tree
+// (CRITICAL_SECTION, Sleep, _strtoi64), so it builds and runs on Windows
+// only.
+
+#define SIM_MAX_FAULTS	16
+
+typedef struct _sim_params_ {
+	int64_t capacity;		/* bytes the seek curve spans */
+	double seek_track_ms;		/* shortest seek */
+	double seek_full_ms;		/* full stroke */
+	double rpm;			/* 0 for no rotational wait */
+	int64_t track_bytes;		/* bytes per track */
+	double overhead_us;		/* per request, controller or bridge */
+	double bandwidth;		/* media rate in MB/s */
+	int realtime;			/* also sleep for the modeled time */
+} sim_params;
+
+struct sim_fault {
+	int64_t sector;			/* first 512 byte sector */
+	int64_t count;
+	double delay_ms;		/* extra time, or */
+	int fail;			/* fail the request */
+};
+
+typedef struct _sim_disk_ {
+	sim_params params;
+	struct sim_fault faults[SIM_MAX_FAULTS];
+	int nfaults;
+	CRITICAL_SECTION lock;
+	int64_t head;			/* byte offset the last request ended */
+	int64_t clock;			/* virtual ns since sim_create() */
+	int64_t debt;			/* modeled ns not slept yet */
+	int64_t requests;
+	int64_t seeks;			/* requests that moved the head */
+	int64_t seek_ns;
+	int64_t rotate_ns;
+	int64_t transfer_ns;
+	int64_t slow;			/* requests delayed by a fault */
+	int64_t failed;			/* requests failed by a fault */
+} sim_disk;
+
+extern sim_disk *sim_create(const char *spec);
+extern void sim_free(sim_disk *sim);
+extern int sim_request(sim_disk *sim, int64_t offset, int64_t numbytes);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "extents.h"
+#include "walk.h"
+#include "stats.h"
+
+// a file ranked by print_extents
+struct ranked_file {
+	char *path;
+	int64_t size;
+	int64_t extents;
+	int64_t discontig;
+};
+
+struct extent_rank {
+	disk_device *device;
+	struct fs *fs;
+	struct ranked_file *files;	/* most discontiguous first */
+	int nfiles;
+	int top;
+	int64_t scanned;
+	int64_t fragmented;		/* files with any discontiguity */
+};
+
+int64_t ufs_get_extents(disk_device *device, struct fs *fs,
+    ufs_dinode *dinode, ufs_extent **extents)
+{
+	ufs_block_list *list;
+	ufs_extent *ext;
+	int64_t nblocks, b, n, frag, len, physical;
+	int64_t t;
+
+	*extents = NULL;
+	nblocks = howmany((int64_t)dinode->size, fs->fs_bsize);
+	if (!nblocks || ((dinode->mode & IFMT) == IFLNK &&
+	    (fs->fs_magic == FS_UFS1_MAGIC ? dinode->din.ufs1.di_blocks :
+	    dinode->din.ufs2.di_blocks) == 0))
+		return 0;
+
+	t = stats_begin();
+	list = ufs_get_block_list(device, fs, dinode);
+	stats_end(STATS_BLOCKMAP, t);
+	if (list == NULL)
+		return -1;
+
+	// at most one per block, trimmed below
+	ext = malloc(nblocks * sizeof(*ext));
+	for (b = 0, n = 0; b < nblocks; ++b) {
+		frag = ufs_block_at(fs, list, b);
+		len = sblksize(fs, (int64_t)dinode->size, b);
+		physical = frag ? ufs_fragtobytes(fs, frag) : -1;
+
+		if (n && (physical < 0 ? ext[n - 1].physical < 0 :
+		    ext[n - 1].physical >= 0 && ext[n - 1].physical +
+		    ext[n - 1].length == physical)) {
+			ext[n - 1].length += len;
+			continue;
+		}
+		ext[n].logical = b * fs->fs_bsize;
+		ext[n].physical = physical;
+		ext[n].length = len;
+		n++;
+	}
+	ufs_free_block_list(list);
+
+	*extents = realloc(ext, n * sizeof(*ext));
+	return n;
+}
+
+int64_t ufs_discontiguities(const ufs_extent *extents, int64_t n)
+{
+	int64_t i, end, count;
+
+	for (i = 0, end = -1, count = 0; i < n; ++i) {
+		if (extents[i].physical < 0)
+			continue;
+		if (end >= 0 && extents[i].physical != end)
+			count++;
+		end = extents[i].physical + extents[i].length;
+	}
+
+	return count;
+}
+
+// keep the top most discontiguous regular files
+static int rank_file(void *arg, walk_event event, walk_entry *entry)
+{
+	struct extent_rank *rank = arg;
+	struct ranked_file file;
+	ufs_extent *extents;
+	ufs_dinode dinode;
+	int i;
+
+	if (event != WALK_ENTRY || (entry->dinode->mode & IFMT) != IFREG)
+		return WALK_CONTINUE;
+
+	dinode = *entry->dinode;
+	file.extents = ufs_get_extents(rank->device, rank->fs, &dinode,
+	    &extents);
+	if (file.extents < 0)
+		return WALK_CONTINUE;
+	file.discontig = ufs_discontiguities(extents, file.extents);
+	file.size = dinode.size;
+	free(extents);
+
+	rank->scanned++;
+	if (file.discontig)
+		rank->fragmented++;
+	if (!file.discontig || (rank->nfiles == rank->top &&
+	    file.discontig <= rank->files[rank->nfiles - 1].discontig))
+		return WALK_CONTINUE;
+
+	if (rank->nfiles == rank->top)
+		free(rank->files[--rank->nfiles].path);
+	for (i = rank->nfiles; i > 0 &&
+	    rank->files[i - 1].discontig < file.discontig; --i)
+		rank->files[i] = rank->files[i - 1];
+	file.path = strdup(entry->path);
+	rank->files[i] = file;
+	rank->nfiles++;
+
+	return WALK_CONTINUE;
+}
+
+static int print_ranking(disk_device *device, struct fs *fs, ufs_inop ino,
+    ufs_dinode *dinode, char *path, int top, FILE *out)
+{
+	struct extent_rank rank;
+	int i, ret;
+
+	memset(&rank, 0, sizeof(rank));
+	rank.device = device;
+	rank.fs = fs;
+	rank.top = top;
+	rank.files = calloc(top, sizeof(*rank.files));
+
+	ret = ufs_walk(device, fs, ino, dinode, path, NULL, NULL, rank_file,
+	    &rank);
+
+	fprintf(out, "%I64d files, %I64d not contiguous\n", rank.scanned,
+	    rank.fragmented);
+	if (rank.nfiles) {
+		fprintf(out, "\ndiscontig  extents          size  path\n");
+		for (i = 0; i < rank.nfiles; ++i) {
+			fprintf(out, "%9I64d %8I64d %13I64d  %s\n",
+			    rank.files[i].discontig, rank.files[i].extents,
+			    rank.files[i].size, rank.files[i].path);
+			free(rank.files[i].path);
+		}
+	}
+	free(rank.files);
+
+	return ret;
+}
+
+int print_extents(disk_device *device, struct fs *fs, char *path,
+    int top, FILE *out)
+{
+	ufs_extent *extents;
+	ufs_dinode dinode;
+	ufs_inop ino;
+	int64_t i, n, holes;
+	int64_t t;
+
+	t = stats_begin();
+	ino = ufs_lookup_path(device, fs, path, 1, ROOTINO);
+	stats_end(STATS_LOOKUP, t);
+	if (!ino) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", path);
+		return -1;
+	}
+	ufs_read_inode(device, fs, ino, &dinode);
+
+	if ((dinode.mode & IFMT) == IFDIR)
+		return print_ranking(device, fs, ino, &dinode, path, top, out);
+
+	n = ufs_get_extents(device, fs, &dinode, &extents);
+	if (n < 0) {
+		fprintf(stderr, "ufs2tool: cannot map \"%s\"\n", path);
+		return -1;
+	}
+
+	for (i = 0, holes = 0; i < n; ++i)
+		holes += extents[i].physical < 0;
+	fprintf(out, "%s: %I64d bytes, %I64d extents, %I64d holes, %I64d "
+	    "discontiguities\n", path, (int64_t)dinode.size, n - holes, holes,
+	    ufs_discontiguities(extents, n));
+
+	if (n) {
+		fprintf(out, "\nin %d byte fragments\n", fs->fs_fsize);
+		fprintf(out, "ext        logical     physical       length\n");
+	}
+	for (i = 0; i < n; ++i) {
+		if (extents[i].physical < 0) {
+			fprintf(out, "%-6I64d %11I64d %12s %12I64d\n", i,
+			    extents[i].logical >> fs->fs_fshift, "hole",
+			    extents[i].length >> fs->fs_fshift);
+		} else {
+			fprintf(out, "%-6I64d %11I64d %12I64d %12I64d\n", i,
+			    extents[i].logical >> fs->fs_fshift,
+			    extents[i].physical >> fs->fs_fshift,
+			    extents[i].length >> fs->fs_fshift);
+		}
+	}
+	free(extents);
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EXTENTS_H_
+#define _EXTENTS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+
+// a run of a file that is contiguous on disk, or a hole
+typedef struct _ufs_extent_ {
+	int64_t logical;		/* byte offset in the file */
+	int64_t physical;		/* byte offset in the partition, -1
+					   for a hole */
+	int64_t length;			/* bytes, to the end of the last
+					   fragment */
+} ufs_extent;
+
+// the extents of a file, from its block map alone. sets *extents to an
+// array to free() and returns how many, or -1 if there's no block map.
+// a symlink kept in its inode has none.
+extern int64_t ufs_get_extents(disk_device *device, struct fs *fs,
+    ufs_dinode *dinode, ufs_extent **extents);
+
+// data extents that don't start where the one before ended
+extern int64_t ufs_discontiguities(const ufs_extent *extents, int64_t n);
+
+// print the extents of path, or for a directory the files under it with
+// the most discontiguities, top of them
+extern int print_extents(disk_device *device, struct fs *fs, char *path,
+    int top, FILE *out);
+
+#endif
@@ -0,0 +1,1304 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <winioctl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "misc.h"
+#include "extents.h"
+#include "extract.h"
+#include "stream.h"
+#include "walk.h"
+#include "stats.h"
+#include "trace.h"
+
+// most partitions extract_partitions() will handle on one disk
+#define MAX_DISK_PARTITIONS 64
+
+// bound on queued file copies per partition, to keep memory flat on
+// directories with millions of entries
+#define MAX_QUEUED_JOBS 1024
+
+// most directory entries whose inodes are read together
+#define INODE_BATCH 4096
+
+// what copy_file finds at its destination, with EXTRACT_UPDATE
+enum dest_state {
+	DEST_STALE,			/* missing or different, write it */
+	DEST_CURRENT,			/* size and mtime match, skip it */
+	DEST_COMPARE			/* same size, compare the contents */
+};
+
+// a directory being copied. with EXTRACT_DELETE the names its source
+// has are kept, to tell what else is at the destination.
+struct extract_dir {
+	char *dest;
+	char **names;
+	int nnames;
+	int maxnames;
+};
+
+struct extract_job {
+	struct extract_job *next;
+	ufs_inop ino;
+	ufs_dinode dinode;		/* already read by the walk */
+	char *srcpath;
+	char *destpath;
+};
+
+// a set of workers copying the files one directory walk finds
+struct extract_pool {
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE ready;	/* a job was queued, or finishing */
+	CONDITION_VARIABLE space;	/* a job was taken off the queue */
+	struct extract_job *head;
+	struct extract_job *tail;
+	int queued;
+	int finishing;
+	int nworkers;
+	HANDLE *threads;
+	extract_ctx *workers;
+};
+
+// remove path, and everything under it if it's a directory. links to
+// directories are removed, not followed.
+static int remove_path(const char *path)
+{
+	WIN32_FIND_DATA fd;
+	HANDLE h;
+	char sub[MAX_PATH];
+	DWORD attr;
+	int ret;
+
+	if ((attr = GetFileAttributes(path)) == INVALID_FILE_ATTRIBUTES)
+		return -1;
+	if (attr & FILE_ATTRIBUTE_READONLY)
+		SetFileAttributes(path, attr & ~FILE_ATTRIBUTE_READONLY);
+	if (!(attr & FILE_ATTRIBUTE_DIRECTORY))
+		return DeleteFile(path) ? 0 : -1;
+
+	ret = 0;
+	if (!(attr & FILE_ATTRIBUTE_REPARSE_POINT)) {
+		sprintf(sub, "%s/*", path);
+		h = FindFirstFile(sub, &fd);
+		while (h != INVALID_HANDLE_VALUE) {
+			if (strcmp(fd.cFileName, ".") &&
+			    strcmp(fd.cFileName, "..")) {
+				sprintf(sub, "%s/%s", path, fd.cFileName);
+				if (remove_path(sub))
+					ret = -1;
+			}
+			if (!FindNextFile(h, &fd)) {
+				FindClose(h);
+				break;
+			}
+		}
+	}
+	if (!RemoveDirectory(path))
+		ret = -1;
+
+	return ret;
+}
+
+// whether path already holds what dinode has, as far as EXTRACT_UPDATE
+// can tell without reading it. with EXTRACT_DELETE a directory in the
+// way is removed.
+static enum dest_state dest_state(extract_ctx *ctx, ufs_dinode *dinode,
+    const char *path)
+{
+	struct _stat64 sb;
+
+	if (_stat64(path, &sb))
+		return DEST_STALE;
+	if ((sb.st_mode & S_IFMT) == S_IFDIR) {
+		if ((ctx->update & EXTRACT_DELETE) && !remove_path(path))
+			ctx->removed++;
+		return DEST_STALE;
+	}
+	if (!(ctx->update & (EXTRACT_UPDATE | EXTRACT_CHECKSUM)) ||
+	    (sb.st_mode & S_IFMT) != S_IFREG || sb.st_size != dinode->size)
+		return DEST_STALE;
+	if (ctx->update & EXTRACT_CHECKSUM)
+		return DEST_COMPARE;
+
+	return sb.st_mtime == dinode->mtime ? DEST_CURRENT : DEST_STALE;
+}
+
+// write len bytes of buf to of, at offset. while *comparing, of is read
+// and compared instead, and written only from the first difference on.
+static void put_data(FILE *of, char *buf, int64_t len, int64_t offset,
+    char *cmpbuf, int *comparing)
+{
+	int64_t t;
+
+	t = stats_begin();
+	if (*comparing) {
+		if (fread(cmpbuf, 1, (size_t)len, of) == (size_t)len &&
+		    !memcmp(buf, cmpbuf, (size_t)len)) {
+			stats_end(STATS_WRITE, t);
+			return;
+		}
+		*comparing = 0;
+		_fseeki64(of, offset, SEEK_SET);
+	}
+	fwrite(buf, 1, (size_t)len, of);
+	stats_end(STATS_WRITE, t);
+}
+
+// write len bytes of the partition at physical to of at offset, read
+// into *buf, which is allocated on first use
+static int copy_range(extract_ctx *ctx, FILE *of, int64_t physical,
+    int64_t offset, int64_t len, char **buf)
+{
+	disk_device *device = ctx->device;
+	int64_t n, t, start;
+
+	// big enough for the largest read the device will take
+	if (!*buf) {
+		device_io_size(device);
+		*buf = malloc((size_t)device->tune.max);
+	}
+	for (; len > 0; len -= n) {
+		n = device_io_size(device);
+		if (n > len)
+			n = len;
+
+		t = stats_begin();
+		start = device_clock(device);
+		if (seek_device(device, physical, SEEK_SET) ||
+		    read_device(device, *buf, n)) {
+			stats_end(STATS_READ, t);
+			return -1;
+		}
+		stats_end(STATS_READ, t);
+		device_io_done(device, n, start);
+
+		t = stats_begin();
+		_fseeki64(of, offset, SEEK_SET);
+		fwrite(*buf, 1, (size_t)n, of);
+		stats_end(STATS_WRITE, t);
+		physical += n;
+		offset += n;
+	}
+
+	return 0;
+}
+
+// where the image's volume can clone blocks (ReFS), clone each extent of
+// the file into of, as far as it lines up with the volume's clusters,
+// and read and write only the rest. of is sized first and made sparse,
+// so holes are never written. -1 if the file has no extents or something
+// failed part way.
+static int clone_file(extract_ctx *ctx, ufs_dinode *dinode, FILE *of)
+{
+	disk_device *device = ctx->device;
+	ufs_extent *extents, *e;
+	int64_t n, i, unit, size, from, to, head, tail, t;
+	HANDLE handle;
+	DWORD returned;
+	char *buf;
+	int ret;
+
+	t = stats_begin();
+	n = ufs_get_extents(device, ctx->fs, dinode, &extents);
+	stats_end(STATS_BLOCKMAP, t);
+	if (n < 0)
+		return -1;
+
+	// cloning needs the destination as long as what's cloned into it
+	t = stats_begin();
+	handle = (HANDLE)_get_osfhandle(_fileno(of));
+	DeviceIoControl(handle, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned,
+	    NULL);
+	ret = _chsize_s(_fileno(of), dinode->size) ? -1 : 0;
+	stats_end(STATS_WRITE, t);
+
+	size = dinode->size;
+	buf = NULL;
+	for (i = 0; i < n && !ret; ++i) {
+		e = &extents[i];
+		if (e->physical < 0 || e->logical >= size)
+			continue;
+		from = e->logical;
+		to = from + e->length < size ? from + e->length : size;
+
+		// the whole clusters in the middle, if the extent sits at the
+		// same place in a cluster of the image as of the file
+		head = tail = to;
+		unit = device->clone_unit;
+		if (unit && (device_absolute(device, e->physical) - from) %
+		    unit == 0) {
+			head = roundup(from, unit);
+			tail = to / unit * unit;
+			if (head >= tail)
+				head = tail = to;
+		}
+
+		if (head > from)
+			ret = copy_range(ctx, of, e->physical, from,
+			    head - from, &buf);
+		if (!ret && tail > head) {
+			t = stats_begin();
+			if (!device_clone_range(device, e->physical +
+			    (head - from), handle, head, tail - head)) {
+				stats_end(STATS_WRITE, t);
+				STATS_ADD(cloned, tail - head);
+			} else {
+				stats_end(STATS_WRITE, t);
+				ret = copy_range(ctx, of, e->physical +
+				    (head - from), head, tail - head, &buf);
+			}
+		}
+		if (!ret && to > tail)
+			ret = copy_range(ctx, of, e->physical + (tail - from),
+			    tail, to - tail, &buf);
+	}
+
+	free(buf);
+	free(extents);
+
+	return ret;
+}
+
+struct stdout_sink {
+	extract_ctx *ctx;
+	HANDLE out;
+	int64_t size;
+};
+
+// write what ufs_stream_file lends straight to stdout
+static int write_stdout(void *arg, const char *buf, int64_t len,
+    int64_t offset)
+{
+	struct stdout_sink *sink = arg;
+	DWORD written;
+	int64_t t;
+
+	t = stats_begin();
+	while (len > 0) {
+		if (!WriteFile(sink->out, buf, (DWORD)len, &written, NULL) ||
+		    !written) {
+			stats_end(STATS_WRITE, t);
+			return STREAM_STOP;
+		}
+		buf += written;
+		len -= written;
+		offset += written;
+	}
+	stats_end(STATS_WRITE, t);
+
+	if (!sink->ctx->quiet)
+		fprintf(stderr, "%I64d of %I64d bytes copied (%lld%%)\r",
+		    offset, sink->size, offset * 100 / sink->size);
+
+	return STREAM_CONTINUE;
+}
+
+// write a file to stdout, most often a pipe, with WriteFile straight from
+// the buffer its data is read into, rather than through the crt. holes
+// aren't read at all, they're written from zeros.
+static int stream_file(extract_ctx *ctx, ufs_dinode *dinode)
+{
+	struct stdout_sink state;
+	ufs_sink sink;
+
+	state.ctx = ctx;
+	state.size = dinode->size;
+	state.out = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (state.out == NULL || state.out == INVALID_HANDLE_VALUE)
+		return -1;
+	fflush(stdout);
+
+	memset(&sink, 0, sizeof(sink));
+	sink.data = write_stdout;
+	sink.arg = &state;
+
+	return ufs_stream_file(ctx->device, ctx->fs, dinode, &sink) ==
+	    STREAM_CONTINUE ? 0 : -1;
+}
+
+static int copy_file(extract_ctx *ctx, ufs_inop ino, ufs_dinode *dinode,
+    char *srcpath, char *newdest, int using_con)
+{
+	disk_device *device = ctx->device;
+	struct fs *fs = ctx->fs;
+	int i;
+	int64_t totalsize, readsize, read, chunk, bufsize, start;
+	ufs_block_list *block_list;
+	char *buf, *cmpbuf, *tmp;
+	FILE *of;
+	struct utimbuf filetime;
+	enum dest_state state;
+	int comparing, ret;
+	int64_t t;
+
+	readsize = 0;
+	read = 0;
+	totalsize = dinode->size;
+
+	if (!ctx->discard) {
+		tmp = valid_filename(newdest, using_con);
+		strcpy(newdest, tmp);
+		free(tmp);
+	}
+
+	// an earlier copy that is still current is left alone, unread
+	state = DEST_STALE;
+	if (ctx->update && !ctx->discard && !using_con) {
+		t = stats_begin();
+		state = dest_state(ctx, dinode, newdest);
+		stats_end(STATS_WRITE, t);
+		if (state == DEST_CURRENT) {
+			ctx->unchanged++;
+			STATS_ADD(unchanged, 1);
+			return 0;
+		}
+	}
+	comparing = (state == DEST_COMPARE);
+
+	if (!ctx->quiet)
+		fprintf(stderr, "retrieving \"%s\"\n", srcpath);
+	TRACE_FILE_START(srcpath, totalsize);
+
+	if (using_con && !ctx->discard) {
+		ret = stream_file(ctx, dinode);
+		if (!ctx->quiet)
+			fprintf(stderr, totalsize ? "\n" : "(empty file)\n");
+		if (ret) {
+			fprintf(stderr, "ufs2tool: cannot copy to stdout\n");
+			TRACE_FILE_DONE(srcpath, (int64_t)0, -1);
+			return -1;
+		}
+		STATS_ADD(files, 1);
+		STATS_ADD(written, totalsize);
+		ctx->files++;
+		ctx->bytes += totalsize;
+		TRACE_FILE_DONE(srcpath, totalsize, 0);
+		return 0;
+	}
+
+	of = NULL;
+	if (!ctx->discard) {
+		t = stats_begin();
+		of = fopen(newdest, comparing ? "r+b" : "wb");
+		stats_end(STATS_WRITE, t);
+		if (!of) {
+			fprintf(stderr, "ufs2tool: cannot open file %s\n",
+			    newdest);
+			TRACE_FILE_DONE(srcpath, (int64_t)0, -1);
+			return -1;
+		}
+	}
+
+	// a file at least a cluster long is cloned if it can be, which
+	// leaves nothing for the read loop. if that fails part way, the file
+	// is read and written over from the start.
+	if (of && !comparing && device->clone_unit &&
+	    totalsize >= device->clone_unit) {
+		if (!clone_file(ctx, dinode, of))
+			readsize = totalsize;
+		else
+			_fseeki64(of, 0, SEEK_SET);
+	}
+
+	// a cloned file is already mapped and written
+	block_list = NULL;
+	buf = cmpbuf = NULL;
+	if (readsize < totalsize) {
+		t = stats_begin();
+		block_list = ufs_get_block_list(device, fs, dinode);
+		stats_end(STATS_BLOCKMAP, t);
+
+		// the read size can change between reads, up to the
+		// device's bound
+		device_io_size(device);
+		bufsize = fragroundup(fs, totalsize);
+		if (bufsize > device->tune.max)
+			bufsize = device->tune.max;
+		buf = malloc(bufsize ? bufsize : fs->fs_fsize);
+		cmpbuf = comparing ? malloc(bufsize ? bufsize :
+		    fs->fs_fsize) : NULL;
+	}
+
+	for (i = 0; readsize < totalsize; i += read / fs->fs_fsize) {
+		chunk = device_io_size(device) / fs->fs_fsize;
+		if (chunk < 1)
+			chunk = 1;
+		if (totalsize - readsize < fs->fs_fsize * chunk) {
+			read = (totalsize - readsize) / fs->fs_fsize;
+			t = stats_begin();
+			read = ufs_read_data(device, fs, dinode, block_list,
+			    buf, i, read ? read : 1);
+			stats_end(STATS_READ, t);
+			if (readsize + read > totalsize) {
+				read = totalsize - readsize; // EOF
+			}
+			if (of)
+				put_data(of, buf, read, readsize, cmpbuf,
+				    &comparing);
+			readsize += read;
+		} else {
+			t = stats_begin();
+			start = device_clock(device);
+			read = ufs_read_data(device, fs, dinode, block_list,
+			    buf, i, chunk);
+			stats_end(STATS_READ, t);
+			if (read > 0)
+				device_io_done(device, read, start);
+			if (of)
+				put_data(of, buf, read, readsize, cmpbuf,
+				    &comparing);
+			readsize += read;
+		}
+		if (!ctx->quiet)
+			fprintf(stderr, "%I64d of %I64d bytes copied (%lld%%)\r",
+			    readsize, totalsize, readsize * 100 / totalsize);
+	}
+
+	if (!ctx->quiet) {
+		if (!totalsize)
+			fprintf(stderr, "(empty file)");
+		fprintf(stderr, "\n");
+	}
+
+	if (of) {
+		t = stats_begin();
+		fclose(of);
+		stats_end(STATS_WRITE, t);
+
+		t = stats_begin();
+		filetime.actime = dinode->atime;
+		filetime.modtime = dinode->mtime;
+		utime(newdest, &filetime);
+		stats_end(STATS_UTIME, t);
+
+		if (!comparing) {
+			STATS_ADD(files, 1);
+			STATS_ADD(written, totalsize);
+		}
+	}
+
+	free(cmpbuf);
+	free(buf);
+	if (block_list)
+		ufs_free_block_list(block_list);
+
+	// the contents were the same all through, only the times were set
+	if (comparing) {
+		ctx->unchanged++;
+		STATS_ADD(unchanged, 1);
+	} else {
+		ctx->files++;
+		ctx->bytes += totalsize;
+	}
+	TRACE_FILE_DONE(srcpath, readsize, 0);
+
+	return 0;
+}
+
+static DWORD WINAPI pool_worker(LPVOID arg)
+{
+	extract_ctx *ctx = arg;
+	struct extract_pool *pool = ctx->pool;
+	struct extract_job *job;
+
+	for (;;) {
+		EnterCriticalSection(&pool->lock);
+		while (!pool->head && !pool->finishing)
+			SleepConditionVariableCS(&pool->ready, &pool->lock,
+			    INFINITE);
+		job = pool->head;
+		if (job) {
+			pool->head = job->next;
+			if (!pool->head)
+				pool->tail = NULL;
+			pool->queued--;
+			WakeConditionVariable(&pool->space);
+		}
+		LeaveCriticalSection(&pool->lock);
+
+		if (!job)
+			break;
+
+		if (copy_file(ctx, job->ino, &job->dinode, job->srcpath,
+		    job->destpath, 0))
+			ctx->errors++;
+
+		free(job->srcpath);
+		free(job->destpath);
+		free(job);
+	}
+
+	return 0;
+}
+
+// workers copy files for ctx, each from its own clone of ctx's device.
+// NULL if none could be started, to copy on the walking thread instead.
+static struct extract_pool *pool_create(extract_ctx *ctx, int nworkers)
+{
+	struct extract_pool *pool;
+	int i;
+
+	pool = calloc(1, sizeof(*pool));
+	InitializeCriticalSection(&pool->lock);
+	InitializeConditionVariable(&pool->ready);
+	InitializeConditionVariable(&pool->space);
+
+	pool->threads = calloc(nworkers, sizeof(*pool->threads));
+	pool->workers = calloc(nworkers, sizeof(*pool->workers));
+
+	for (i = 0; i < nworkers; ++i) {
+		pool->workers[i].device = clone_device(ctx->device);
+		if (pool->workers[i].device == NULL)
+			break;
+		pool->workers[i].fs = ctx->fs;
+		pool->workers[i].quiet = 1;
+		pool->workers[i].discard = ctx->discard;
+		pool->workers[i].update = ctx->update;
+		pool->workers[i].pool = pool;
+
+		pool->threads[i] = CreateThread(NULL, 0, pool_worker,
+		    &pool->workers[i], 0, NULL);
+		if (pool->threads[i] == NULL) {
+			close_device(pool->workers[i].device);
+			break;
+		}
+	}
+	pool->nworkers = i;
+
+	if (!pool->nworkers) {
+		DeleteCriticalSection(&pool->lock);
+		free(pool->threads);
+		free(pool->workers);
+		free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+static int pool_add(struct extract_pool *pool, ufs_inop ino,
+    const ufs_dinode *dinode, char *srcpath, char *destpath)
+{
+	struct extract_job *job;
+
+	job = malloc(sizeof(*job));
+	job->next = NULL;
+	job->ino = ino;
+	job->dinode = *dinode;
+	job->srcpath = strdup(srcpath);
+	job->destpath = malloc(MAX_PATH);
+	strcpy(job->destpath, destpath);
+
+	EnterCriticalSection(&pool->lock);
+	while (pool->queued >= MAX_QUEUED_JOBS)
+		SleepConditionVariableCS(&pool->space, &pool->lock, INFINITE);
+	if (pool->tail)
+		pool->tail->next = job;
+	else
+		pool->head = job;
+	pool->tail = job;
+	pool->queued++;
+	WakeConditionVariable(&pool->ready);
+	LeaveCriticalSection(&pool->lock);
+
+	return 0;
+}
+
+// wait for the queue to drain and add the workers' totals to ctx
+static void pool_finish(struct extract_pool *pool, extract_ctx *ctx)
+{
+	int i;
+
+	EnterCriticalSection(&pool->lock);
+	pool->finishing = 1;
+	WakeAllConditionVariable(&pool->ready);
+	LeaveCriticalSection(&pool->lock);
+
+	for (i = 0; i < pool->nworkers; ++i) {
+		WaitForSingleObject(pool->threads[i], INFINITE);
+		CloseHandle(pool->threads[i]);
+		close_device(pool->workers[i].device);
+
+		ctx->files += pool->workers[i].files;
+		ctx->bytes += pool->workers[i].bytes;
+		ctx->unchanged += pool->workers[i].unchanged;
+		ctx->removed += pool->workers[i].removed;
+		ctx->errors += pool->workers[i].errors;
+	}
+
+	DeleteCriticalSection(&pool->lock);
+	free(pool->threads);
+	free(pool->workers);
+	free(pool);
+}
+
+// the directory to copy one into, made unless discarding. NULL if there
+// is something else by that name (and EXTRACT_DELETE can't remove it)
+// or it can't be made.
+static char *make_dir(extract_ctx *ctx, char *path)
+{
+	char *dirdest;
+	struct stat sb;
+	int64_t t;
+
+	t = stats_begin();
+	if (!ctx->discard && (ctx->update & EXTRACT_DELETE) &&
+	    !stat(path, &sb) && (sb.st_mode & S_IFMT) != S_IFDIR &&
+	    !remove_path(path))
+		ctx->removed++;
+
+	if (ctx->discard) {
+		dirdest = strdup(path);
+	} else if (!stat(path, &sb)) {
+		dirdest = (sb.st_mode & S_IFMT) == S_IFDIR ? strdup(path) : NULL;
+	} else if (mkdir(path) == -1) {
+		// check for invalid filename
+		dirdest = valid_filename(path, 0);
+		if (mkdir(dirdest) == -1) {
+			free(dirdest);
+			dirdest = NULL;
+		}
+	} else {
+		dirdest = strdup(path);
+	}
+	stats_end(STATS_WRITE, t);
+
+	return dirdest;
+}
+
+static struct extract_dir *new_dir(char *dest)
+{
+	struct extract_dir *dir;
+
+	dir = calloc(1, sizeof(*dir));
+	dir->dest = dest;
+
+	return dir;
+}
+
+// note a name the source directory has, and the name it's copied under
+// if that had to be changed
+static void dir_add_name(struct extract_dir *dir, const char *name)
+{
+	char *valid, *base;
+
+	if (dir->nnames + 2 > dir->maxnames) {
+		dir->maxnames = dir->maxnames ? dir->maxnames * 2 : 64;
+		dir->names = realloc(dir->names,
+		    dir->maxnames * sizeof(*dir->names));
+	}
+	dir->names[dir->nnames++] = strdup(name);
+
+	valid = valid_filename((char *)name, 0);
+	base = basename(valid);
+	if (strcmp(base, name))
+		dir->names[dir->nnames++] = base;
+	else
+		free(base);
+	free(valid);
+}
+
+// windows names are case-insensitive, so anything the source has in
+// some case is kept
+static int compare_names(const void *a, const void *b)
+{
+	return stricmp(*(char * const *)a, *(char * const *)b);
+}
+
+// remove what is at dir's destination but not in its source
+static void prune_dir(extract_ctx *ctx, struct extract_dir *dir)
+{
+	WIN32_FIND_DATA fd;
+	HANDLE h;
+	char path[MAX_PATH];
+	char *name;
+
+	qsort(dir->names, dir->nnames, sizeof(*dir->names), compare_names);
+
+	sprintf(path, "%s/*", dir->dest);
+	h = FindFirstFile(path, &fd);
+	while (h != INVALID_HANDLE_VALUE) {
+		name = fd.cFileName;
+		if (strcmp(name, ".") && strcmp(name, "..") &&
+		    !bsearch(&name, dir->names, dir->nnames,
+		    sizeof(*dir->names), compare_names)) {
+			sprintf(path, "%s/%s", dir->dest, name);
+			if (!ctx->quiet)
+				fprintf(stderr, "removing \"%s\"\n", path);
+			if (remove_path(path)) {
+				fprintf(stderr, "ufs2tool: cannot remove "
+				    "%s\n", path);
+				ctx->errors++;
+			} else {
+				ctx->removed++;
+			}
+		}
+		if (!FindNextFile(h, &fd)) {
+			FindClose(h);
+			break;
+		}
+	}
+}
+
+// every entry of dir was handed out. unless some of the source couldn't
+// be read, what it doesn't have can go.
+static void finish_dir(extract_ctx *ctx, struct extract_dir *dir,
+    int incomplete)
+{
+	int64_t t;
+	int i;
+
+	if (dir == NULL)
+		return;
+
+	t = stats_begin();
+	if ((ctx->update & EXTRACT_DELETE) && !ctx->discard && !incomplete)
+		prune_dir(ctx, dir);
+	stats_end(STATS_WRITE, t);
+
+	for (i = 0; i < dir->nnames; ++i)
+		free(dir->names[i]);
+	free(dir->names);
+	free(dir->dest);
+	free(dir);
+}
+
+static int read_entry(extract_ctx *ctx, ufs_inop root_ino, ufs_inop ino,
+    ufs_dinode *dinodep, char *srcpath, char *destpath, int exact);
+
+static int filter_glob(const char *pattern, const char *path,
+    const char *name)
+{
+	return match_glob(pattern, strchr(pattern, '/') ? path : name);
+}
+
+// whether filter lets an entry through. type is DT_UNKNOWN and dinode
+// NULL while only the directory entry is known; then only what can be
+// decided on the name is. directories are only ever excluded.
+static int filter_entry(const extract_filter *filter, struct fs *fs,
+    const char *path, const char *name, int type, const ufs_dinode *dinode)
+{
+	int i;
+
+	if (filter == NULL)
+		return 1;
+
+	for (i = 0; i < filter->nexclude; ++i) {
+		if (filter_glob(filter->exclude[i], path, name))
+			return 0;
+	}
+	if (type == DT_DIR || type == DT_UNKNOWN)
+		return 1;
+
+	for (i = 0; i < filter->ninclude; ++i) {
+		if (filter_glob(filter->include[i], path, name))
+			break;
+	}
+	if (filter->ninclude && i == filter->ninclude)
+		return 0;
+
+	return dinode == NULL || find_match_inode(&filter->tests, fs, dinode);
+}
+
+// ufs_walk's callback for read_entry. a directory's data is its
+// extract_dir; directories are made as they're found and everything else
+// goes through read_entry.
+static int walk_copy(void *arg, walk_event event, walk_entry *entry)
+{
+	extract_ctx *ctx = arg;
+	struct extract_dir *parent = entry->parent_data;
+	char nextdest[MAX_PATH];
+	ufs_dinode dinode;
+	char *srcpath, *dirdest;
+
+	if (event == WALK_NAME) {
+		// even if filtered out, it's not to be removed
+		if (ctx->update & EXTRACT_DELETE)
+			dir_add_name(parent, entry->name);
+		return filter_entry(ctx->filter, ctx->fs, entry->path,
+		    entry->name, entry->type, NULL) ? WALK_CONTINUE : WALK_SKIP;
+	}
+	if (event == WALK_DONE) {
+		finish_dir(ctx, entry->data, entry->incomplete);
+		return WALK_CONTINUE;
+	}
+	if (!filter_entry(ctx->filter, ctx->fs, entry->path, entry->name,
+	    ufs_mode_type(entry->dinode->mode), entry->dinode))
+		return WALK_SKIP;
+
+	strcpy(nextdest, parent->dest);
+	strcat(nextdest, "/");
+	strcat(nextdest, entry->name);
+
+	if ((entry->dinode->mode & IFMT) == IFDIR) {
+		if ((dirdest = make_dir(ctx, nextdest)) == NULL) {
+			ctx->errors++;
+			return WALK_SKIP;
+		}
+		entry->data = new_dir(dirdest);
+		return WALK_CONTINUE;
+	}
+
+	dinode = *entry->dinode;
+	srcpath = strdup(entry->path);
+	if (read_entry(ctx, entry->parent, entry->ino, &dinode, srcpath,
+	    nextdest, 1))
+		ctx->errors++;
+	free(srcpath);
+
+	return WALK_CONTINUE;
+}
+
+// copy ino, whose inode is in dinode. unless exact, an existing directory
+// at destpath is copied into. NOTE: this function is recursive for
+// recursive copying
+static int read_entry(extract_ctx *ctx, ufs_inop root_ino, ufs_inop ino,
+    ufs_dinode *dinodep, char *srcpath, char *destpath, int exact)
+{
+	disk_device *device = ctx->device;
+	struct fs *fs = ctx->fs;
+	int i, j, n, batch;
+	ufs_block_list *block_list;
+	char *buf, *dir;
+	char newdest[MAX_PATH];
+	int using_con;
+	ufs_dinode dinode, *dinodes;
+	ufs_inop *inos;
+	struct direct *entries;
+	struct stat stat_buf;
+	int64_t t;
+
+	ufs_inop symlink_ino;
+
+	using_con = (destpath && (!stricmp(destpath, "CON") ||
+	    !(strnicmp(destpath, "CON.", 4))));
+
+	if (!root_ino || !ino) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", srcpath);
+		return -1;
+	}
+
+	// this checks for a recursive symlink loop
+	dinode = *dinodep;
+	if ((dinode.mode & IFMT) == IFLNK) {
+		t = stats_begin();
+		ino = ufs_lookup_path(device, fs, srcpath, 1, ROOTINO);
+		dir = dirname(srcpath);
+		symlink_ino = ufs_lookup_path(device, fs, dir, 1, ROOTINO);
+
+		for (;; symlink_ino = ufs_lookup_path(device, fs, "..", 0,
+		    symlink_ino)) {
+			if (symlink_ino == ino) {
+				fprintf(stderr, "(\"%s\" is a recursive symlink loop)\n", srcpath);
+				free(dir);
+				return -1;
+			}
+
+			if (symlink_ino == ROOTINO)
+				break;
+		}
+
+		stats_end(STATS_LOOKUP, t);
+		free(dir);
+		ufs_read_inode(device, fs, ino, &dinode);
+	}
+
+	if (destpath == NULL) {
+		char *base = basename(srcpath);
+		strcpy(newdest, "./");
+		strcat(newdest, base);
+		free(base);
+	} else {
+		while (destpath[strlen(destpath) - 1] == '/')
+			destpath[strlen(destpath) - 1] = '\0';
+
+		if (!exact && !stat(destpath, &stat_buf) &&
+		    (stat_buf.st_mode & S_IFDIR)) {
+			char *base;
+			strcpy(newdest, destpath);
+			strcat(newdest, "/");
+			base = basename(srcpath);
+			strcat(newdest, base);
+			free(base);
+		} else {
+			strcpy(newdest, destpath);
+		}
+	}
+
+	if (dinode.mode & IFDIR) {
+		struct extract_dir *into;
+		char *dirdest, *tmp;
+		char nextsrc[256];
+		char nextdest[MAX_PATH];
+		int ret;
+		struct direct directtmp;
+
+		if (using_con) {
+			fprintf(stderr, "ufs2tool: cannot copy directory to console\n");
+			return -1;
+		}
+
+		if ((dirdest = make_dir(ctx, newdest)) == NULL)
+			return -1;
+
+		// the whole tree at once, with its reads overlapped
+		if (walk_default_limits.max_io > 0)
+			return ufs_walk(device, fs, ino, &dinode, srcpath,
+			    new_dir(dirdest), NULL, walk_copy, ctx);
+		into = new_dir(dirdest);
+
+		t = stats_begin();
+		block_list = ufs_get_block_list(device, fs, &dinode);
+		stats_end(STATS_BLOCKMAP, t);
+
+		t = stats_begin();
+		buf = malloc(dinode.size + sizeof(struct direct));
+		ufs_read_data(device, fs, &dinode, block_list, buf, 0, 0);
+		stats_end(STATS_READ, t);
+		STATS_ADD(directories, 1);
+		STATS_ADD(dirblocks, lblkno(fs, blkroundup(fs, dinode.size)));
+
+		// count the entries, to size the batches
+		tmp = buf;
+		for (n = 0;; ++n) {
+			ret = ufs_read_direntry(tmp, &directtmp);
+			if (tmp - buf >= dinode.size || !ret)
+				break;
+			tmp += ret;
+		}
+		batch = n < INODE_BATCH ? n : INODE_BATCH;
+		entries = malloc((batch ? batch : 1) * sizeof(*entries));
+		inos = malloc((batch ? batch : 1) * sizeof(*inos));
+		dinodes = malloc((batch ? batch : 1) * sizeof(*dinodes));
+
+		// read the inodes of a batch of entries together, then
+		// copy each entry in directory order
+		tmp = buf;
+		for (i = 0; i < n; i += batch) {
+			for (j = 0; j < batch && i + j < n; ++j) {
+				tmp += ufs_read_direntry(tmp, &entries[j]);
+				inos[j] = entries[j].d_ino;
+			}
+			ufs_read_inodes(device, fs, inos, j, dinodes);
+
+			for (j = 0; j < batch && i + j < n; ++j) {
+				if (!strcmp(entries[j].d_name, ".") ||
+				    !strcmp(entries[j].d_name, ".."))
+					continue;
+				if (ctx->update & EXTRACT_DELETE)
+					dir_add_name(into, entries[j].d_name);
+
+				strcpy(nextsrc, srcpath);
+				if (srcpath[strlen(srcpath) - 1] != '/')
+					strcat(nextsrc, "/");
+				strcat(nextsrc, entries[j].d_name);
+
+				strcpy(nextdest, dirdest);
+				strcat(nextdest, "/");
+				strcat(nextdest, entries[j].d_name);
+
+				if (!entries[j].d_ino) {
+					fprintf(stderr, "ufs2tool: \"%s\" does "
+					    "not exist\n", nextsrc);
+					continue;
+				}
+				if (!filter_entry(ctx->filter, fs, nextsrc,
+				    entries[j].d_name,
+				    ufs_mode_type(dinodes[j].mode), &dinodes[j]))
+					continue;
+				if (read_entry(ctx, ino, entries[j].d_ino,
+				    &dinodes[j], nextsrc, nextdest, 1))
+					ctx->errors++;
+			}
+		}
+
+		free(dinodes);
+		free(inos);
+		free(entries);
+		ufs_free_block_list(block_list);
+		free(buf);
+		finish_dir(ctx, into, 0);
+
+		return 0;
+	}
+
+	if (ctx->pool && !using_con)
+		return pool_add(ctx->pool, ino, &dinode, srcpath, newdest);
+
+	return copy_file(ctx, ino, &dinode, srcpath, newdest, using_con);
+}
+
+int read_file(extract_ctx *ctx, ufs_inop root_ino, ufs_inop ino,
+    char *srcpath, char *destpath)
+{
+	ufs_dinode dinode;
+
+	if (!root_ino || !ino) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", srcpath);
+		return -1;
+	}
+
+	ufs_read_inode(ctx->device, ctx->fs, ino, &dinode);
+
+	return read_entry(ctx, root_ino, ino, &dinode, srcpath, destpath, 0);
+}
+
+// whether path has a ".." component, which would put it outside the
+// destination. '\\' counts as a separator, as it does to Windows.
+static int climbs_out(const char *path)
+{
+	const char *p;
+
+	for (p = path; *p != '\0'; ) {
+		if (p[0] == '.' && p[1] == '.' &&
+		    (p[2] == '\0' || p[2] == '/' || p[2] == '\\'))
+			return 1;
+		p += strcspn(p, "/\\");
+		if (*p != '\0')
+			++p;
+	}
+
+	return 0;
+}
+
+// copy each of paths to destpath/path. the paths are resolved together
+// and their inodes read in disk order, a batch at a time.
+int extract_paths(extract_ctx *ctx, char **paths, int64_t npaths,
+    char *destpath)
+{
+	disk_device *device = ctx->device;
+	struct fs *fs = ctx->fs;
+	ufs_inop *inos;
+	ufs_dinode *dinodes;
+	char dest[MAX_PATH];
+	char *rel, *p;
+	int64_t i, j, batch, t;
+	int ret;
+
+	if (destpath == NULL || destpath[0] == '\0')
+		destpath = ".";
+
+	inos = malloc((npaths ? npaths : 1) * sizeof(*inos));
+	batch = npaths < INODE_BATCH ? npaths : INODE_BATCH;
+	dinodes = malloc((batch ? batch : 1) * sizeof(*dinodes));
+
+	t = stats_begin();
+	ret = ufs_lookup_paths(device, fs, paths, npaths, 0, ROOTINO, inos);
+	stats_end(STATS_LOOKUP, t);
+
+	for (i = 0; i < npaths; ++i) {
+		if (i % batch == 0)
+			ufs_read_inodes(device, fs, inos + i, npaths - i < batch ?
+			    npaths - i : batch, dinodes);
+		j = i % batch;
+
+		if (!inos[i]) {
+			fprintf(stderr, "ufs2tool: \"%s\" does not exist\n",
+			    paths[i]);
+			continue;
+		}
+
+		for (rel = paths[i]; *rel == '/'; ++rel)
+			;
+		if (climbs_out(rel)) {
+			fprintf(stderr, "ufs2tool: \"%s\" leads out of \"%s\"\n",
+			    paths[i], destpath);
+			ret = -1;
+			continue;
+		}
+		if (strlen(destpath) + strlen(rel) + 2 > sizeof(dest)) {
+			fprintf(stderr, "ufs2tool: \"%s\" is too long\n",
+			    paths[i]);
+			ret = -1;
+			continue;
+		}
+		sprintf(dest, "%s/%s", destpath, rel);
+
+		// the directories leading to it
+		for (p = dest + strlen(destpath) + 1; !ctx->discard &&
+		    (p = strchr(p, '/')) != NULL; ++p) {
+			*p = '\0';
+			mkdir(dest);
+			*p = '/';
+		}
+
+		if (read_entry(ctx, ROOTINO, inos[i], &dinodes[j], paths[i],
+		    dest, 1))
+			ret = -1;
+	}
+
+	free(dinodes);
+	free(inos);
+
+	return ret;
+}
+
+struct partition_job {
+	struct disk_partition part;
+	extract_ctx ctx;
+	int nworkers;
+	char name[16];
+	char destpath[MAX_PATH];
+	HANDLE thread;
+};
+
+static DWORD WINAPI extract_partition(LPVOID arg)
+{
+	struct partition_job *pj = arg;
+
+	pj->ctx.pool = pool_create(&pj->ctx, pj->nworkers);
+	if (read_file(&pj->ctx, ROOTINO, ROOTINO, "/", pj->destpath))
+		pj->ctx.errors++;
+	if (pj->ctx.pool)
+		pool_finish(pj->ctx.pool, &pj->ctx);
+	pj->ctx.pool = NULL;
+
+	return 0;
+}
+
+// extract every UFS partition on a disk (or only those of one slice, if
+// slice is non-zero) concurrently, each into destpath/s<slice><letter>.
+// the slice table and labels are only read once, each partition gets a
+// share of the jobs proportional to its size.
+int extract_partitions(disk_device *disk, int slice, char *destpath,
+    int jobs, const extract_filter *filter, int update)
+{
+	struct disk_partition parts[MAX_DISK_PARTITIONS];
+	struct partition_job *pjs;
+	struct stat sb;
+	int64_t totalsize, t;
+	int i, n, npj, ret;
+
+	if (destpath == NULL || destpath[0] == '\0')
+		destpath = ".";
+	if (stat(destpath, &sb) && mkdir(destpath) == -1) {
+		fprintf(stderr, "ufs2tool: cannot create \"%s\"\n", destpath);
+		return -1;
+	}
+
+	t = stats_begin();
+	n = find_partitions(disk, parts, MAX_DISK_PARTITIONS);
+	stats_end(STATS_PROBE, t);
+	if (n == 0 && !slice) {
+		// no tables at all, maybe a bare file system image
+		memset(&parts[0], 0, sizeof(parts[0]));
+		n = 1;
+	}
+	pjs = calloc(n ? n : 1, sizeof(*pjs));
+
+	npj = 0;
+	totalsize = 0;
+	for (i = 0; i < n; ++i) {
+		struct partition_job *pj = &pjs[npj];
+
+		if (slice && parts[i].dp_slice != slice)
+			continue;
+
+		pj->part = parts[i];
+		pj->ctx.device = clone_device(disk);
+		if (pj->ctx.device == NULL)
+			continue;
+		pj->ctx.device->partition_offset = parts[i].dp_offset;
+
+		t = stats_begin();
+		pj->ctx.fs = ufs_init(pj->ctx.device);
+		stats_end(STATS_PROBE, t);
+		if (pj->ctx.fs == NULL) {
+			close_device(pj->ctx.device);
+			continue;
+		}
+		pj->ctx.quiet = 1;
+		pj->ctx.filter = filter;
+		pj->ctx.update = update;
+
+		if (parts[i].dp_slice)
+			sprintf(pj->name, "s%d%c", parts[i].dp_slice,
+			    'a' + parts[i].dp_partition);
+		else
+			sprintf(pj->name, "%c", 'a' + parts[i].dp_partition);
+		sprintf(pj->destpath, "%s/%s", destpath, pj->name);
+
+		totalsize += parts[i].dp_size;
+		++npj;
+	}
+
+	if (npj == 0) {
+		fprintf(stderr, "ufs2tool: no UFS partitions found\n");
+		free(pjs);
+		return -1;
+	}
+
+	for (i = 0; i < npj; ++i) {
+		pjs[i].nworkers = totalsize ? (int)((int64_t)jobs *
+		    pjs[i].part.dp_size / totalsize) : jobs;
+		if (pjs[i].nworkers < 1)
+			pjs[i].nworkers = 1;
+
+		fprintf(stderr, "extracting %s (%d workers) to \"%s\"\n",
+		    pjs[i].name, pjs[i].nworkers, pjs[i].destpath);
+
+		pjs[i].thread = CreateThread(NULL, 0, extract_partition,
+		    &pjs[i], 0, NULL);
+		if (pjs[i].thread == NULL)
+			extract_partition(&pjs[i]);
+	}
+
+	ret = 0;
+	for (i = 0; i < npj; ++i) {
+		if (pjs[i].thread) {
+			WaitForSingleObject(pjs[i].thread, INFINITE);
+			CloseHandle(pjs[i].thread);
+		}
+
+		fprintf(stderr, "%s: %I64d files, %I64d bytes", pjs[i].name,
+		    pjs[i].ctx.files, pjs[i].ctx.bytes);
+		if (update)
+			fprintf(stderr, ", %I64d unchanged, %I64d removed",
+			    pjs[i].ctx.unchanged, pjs[i].ctx.removed);
+		fprintf(stderr, "%s\n", pjs[i].ctx.errors ?
+		    ", with errors" : "");
+		if (pjs[i].ctx.errors)
+			ret = -1;
+
+		free(pjs[i].ctx.fs);
+		close_device(pjs[i].ctx.device);
+	}
+
+	free(pjs);
+
+	return ret;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EXTRACT_H_
+#define _EXTRACT_H_
+
+#include <stdint.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "find.h"
+
+struct extract_pool;
+
+// what of a tree is copied. globs with a '/' are matched against the
+// whole source path, others against the name. excluded directories are
+// never read; files are tested on their directory entry, then on their
+// inode, before anything else of them is read.
+typedef struct _extract_filter_ {
+	char **include;			/* a file must match one, if any */
+	int ninclude;
+	char **exclude;			/* nothing matching any is copied */
+	int nexclude;
+	find_query tests;		/* size and mtime bounds */
+} extract_filter;
+
+// extract_ctx update flags, for copying again over an earlier copy
+#define EXTRACT_UPDATE		0x01	/* skip files whose size and mtime
+					   are already the inode's */
+#define EXTRACT_CHECKSUM	0x02	/* compare the contents of files of
+					   the same size instead, and write
+					   only from the first difference */
+#define EXTRACT_DELETE		0x04	/* remove what a copied directory
+					   no longer has */
+
+// state of one extraction. every thread gets its own context, since the
+// device cursor can't be shared.
+typedef struct _extract_ctx_ {
+	disk_device *device;
+	struct fs *fs;
+	int quiet;			/* no per-file progress */
+	int discard;			/* read the data, write nothing */
+	struct extract_pool *pool;	/* queue file copies here if set */
+	const extract_filter *filter;	/* everything if NULL */
+	int update;			/* EXTRACT_ flags */
+	int64_t files;			/* regular files copied */
+	int64_t bytes;			/* bytes copied */
+	int64_t unchanged;		/* files already there, left alone */
+	int64_t removed;		/* names removed with EXTRACT_DELETE */
+	int errors;
+} extract_ctx;
+
+extern int read_file(extract_ctx *ctx, ufs_inop root_ino, ufs_inop ino,
+    char *srcpath, char *destpath);
+
+// copy a list of paths, each to destpath/path
+extern int extract_paths(extract_ctx *ctx, char **paths, int64_t npaths,
+    char *destpath);
+
+extern int extract_partitions(disk_device *disk, int slice, char *destpath,
+    int jobs, const extract_filter *filter, int update);
+
+#endif
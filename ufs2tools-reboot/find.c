@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "misc.h"
+#include "find.h"
+#include "walk.h"
+#include "stats.h"
+
+struct find_state {
+	struct fs *fs;
+	const find_query *query;
+	int needs_inode;		/* some test looks at the inode */
+	FILE *out;
+	int64_t found;
+};
+
+void find_init(find_query *query)
+{
+	memset(query, 0, sizeof(*query));
+	query->type = DT_UNKNOWN;
+	query->min_size = query->max_size = -1;
+	query->min_mtime = INT64_MIN;
+	query->max_mtime = INT64_MAX;
+	query->uid = -1;
+}
+
+int find_type(find_query *query, const char *arg)
+{
+	static const char letters[] = "fdlpcbs";
+	static const int types[] = {
+		DT_REG, DT_DIR, DT_LNK, DT_FIFO, DT_CHR, DT_BLK, DT_SOCK
+	};
+	const char *p;
+
+	if (!arg[0] || arg[1] || (p = strchr(letters, arg[0])) == NULL)
+		return -1;
+	query->type = types[p - letters];
+
+	return 0;
+}
+
+// [+-]n with an optional unit, and which way it bounds
+static int parse_bound(const char *arg, int64_t *value, int *sign,
+    const char *units, const int64_t *scales)
+{
+	const char *p;
+	char *end;
+
+	*sign = (*arg == '+') - (*arg == '-');
+	if (*sign)
+		++arg;
+	if (*arg < '0' || *arg > '9')
+		return -1;
+
+	*value = _strtoi64(arg, &end, 10);
+	if (*end) {
+		if (end[1] || (p = strchr(units, *end)) == NULL)
+			return -1;
+		*value *= scales[p - units];
+	}
+
+	return 0;
+}
+
+int find_size(find_query *query, const char *arg)
+{
+	static const int64_t scales[] = { 1, 1 << 10, 1 << 20, 1 << 30 };
+	int64_t n;
+	int sign;
+
+	if (parse_bound(arg, &n, &sign, "ckmg", scales))
+		return -1;
+
+	// more than n, less than n, or exactly n
+	if (sign >= 0)
+		query->min_size = sign ? n + 1 : n;
+	if (sign <= 0)
+		query->max_size = sign ? (n ? n - 1 : 0) : n;
+
+	return 0;
+}
+
+int find_mtime(find_query *query, const char *arg, time_t now)
+{
+	static const int64_t scales[] = { 1 };
+	int64_t days, when;
+	int sign;
+
+	if (parse_bound(arg, &days, &sign, "d", scales) ||
+	    days > INT64_MAX / 86400 - 1)
+		return -1;
+	when = (int64_t)now - days * 86400;
+
+	// as find(1) counts, in whole days of age: +n is more than n, so at
+	// least n + 1; -n is less than n; n is exactly n
+	if (sign > 0) {
+		query->max_mtime = when - 86400;
+	} else if (sign < 0) {
+		query->min_mtime = when + 1;
+	} else {
+		query->min_mtime = when - 86400 + 1;
+		query->max_mtime = when;
+	}
+
+	return 0;
+}
+
+static int match_name(const find_query *query, const char *name, int type)
+{
+	if (query->name && !match_glob(query->name, name))
+		return 0;
+	if (query->type != DT_UNKNOWN && type != query->type)
+		return 0;
+
+	return 1;
+}
+
+int find_match_inode(const find_query *query, struct fs *fs,
+    const ufs_dinode *dinode)
+{
+	int64_t uid;
+
+	if (query->min_size >= 0 && (int64_t)dinode->size < query->min_size)
+		return 0;
+	if (query->max_size >= 0 && (int64_t)dinode->size > query->max_size)
+		return 0;
+	if (dinode->mtime < query->min_mtime ||
+	    dinode->mtime > query->max_mtime)
+		return 0;
+
+	uid = fs->fs_magic == FS_UFS1_MAGIC ? dinode->din.ufs1.di_uid :
+	    dinode->din.ufs2.di_uid;
+	if (query->uid >= 0 && uid != query->uid)
+		return 0;
+
+	return 1;
+}
+
+static void print_found(struct find_state *state, const char *path)
+{
+	fputs(path, state->out);
+	fputc(state->query->print0 ? '\0' : '\n', state->out);
+	state->found++;
+}
+
+// directory data is its depth below the path searched
+static int find_entry(void *arg, walk_event event, walk_entry *entry)
+{
+	struct find_state *state = arg;
+	const find_query *query = state->query;
+	int depth, type, below;
+
+	if (event == WALK_DONE)
+		return WALK_CONTINUE;
+
+	depth = (int)(intptr_t)entry->parent_data + 1;
+	below = !query->maxdepth || depth < query->maxdepth;
+
+	if (event == WALK_NAME) {
+		if (entry->type == DT_UNKNOWN)
+			return WALK_CONTINUE;
+		if (entry->type == DT_DIR && query->prune &&
+		    match_glob(query->prune, entry->name))
+			return WALK_SKIP;
+		if (entry->type == DT_DIR && below)
+			return WALK_CONTINUE;
+
+		// nothing to go into: settle it on the name if we can
+		if (!match_name(query, entry->name, entry->type))
+			return WALK_SKIP;
+		if (state->needs_inode)
+			return WALK_CONTINUE;
+		print_found(state, entry->path);
+		return WALK_SKIP;
+	}
+
+	type = ufs_mode_type(entry->dinode->mode);
+	if (type == DT_DIR && query->prune &&
+	    match_glob(query->prune, entry->name))
+		return WALK_SKIP;
+
+	if (match_name(query, entry->name, type) &&
+	    find_match_inode(query, state->fs, entry->dinode))
+		print_found(state, entry->path);
+
+	if (type != DT_DIR || !below)
+		return WALK_SKIP;
+	entry->data = (void *)(intptr_t)depth;
+
+	return WALK_CONTINUE;
+}
+
+int ufs_find(disk_device *device, struct fs *fs, char *path,
+    const find_query *query, FILE *out)
+{
+	struct find_state state;
+	ufs_dinode dinode;
+	ufs_inop ino;
+	char *name;
+	int64_t t;
+	int ret;
+
+	memset(&state, 0, sizeof(state));
+	state.fs = fs;
+	state.query = query;
+	state.out = out;
+	state.needs_inode = query->min_size >= 0 || query->max_size >= 0 ||
+	    query->min_mtime != INT64_MIN || query->max_mtime != INT64_MAX ||
+	    query->uid >= 0;
+
+	t = stats_begin();
+	ino = ufs_lookup_path(device, fs, path, 1, ROOTINO);
+	stats_end(STATS_LOOKUP, t);
+	if (!ino) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", path);
+		return -1;
+	}
+	ufs_read_inode(device, fs, ino, &dinode);
+
+	if ((dinode.mode & IFMT) != IFDIR) {
+		name = basename(path);
+		if (match_name(query, name, ufs_mode_type(dinode.mode)) &&
+		    find_match_inode(query, fs, &dinode))
+			print_found(&state, path);
+		free(name);
+		return 0;
+	}
+
+	ret = ufs_walk(device, fs, ino, &dinode, path, NULL, NULL,
+	    find_entry, &state);
+	fflush(out);
+
+	return ret;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FIND_H_
+#define _FIND_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+
+// what ufs_find looks for. names and types are tested on the directory
+// entry, so an inode is only read when a test needs it or the entry is
+// a directory to go into.
+typedef struct _find_query_ {
+	const char *name;		/* glob the name matches, or NULL */
+	const char *prune;		/* glob of directories not gone into */
+	int type;			/* DT_ type, DT_UNKNOWN for any */
+	int64_t min_size;		/* bytes, -1 for no bound */
+	int64_t max_size;
+	int64_t min_mtime;		/* seconds since 1970, INT64_MIN */
+	int64_t max_mtime;		/* and INT64_MAX for none */
+	int64_t uid;			/* owner, -1 for any */
+	int maxdepth;			/* levels below path, 0 for all */
+	int print0;			/* end paths with NUL, not newline */
+} find_query;
+
+extern void find_init(find_query *query);
+
+// parse find(1) style arguments into query: a type letter (f, d, l, p,
+// c, b, s), a size of [+-]n[kmg] bytes, and a modification age of
+// [+-]n days before now. -1 if arg is no good.
+extern int find_type(find_query *query, const char *arg);
+extern int find_size(find_query *query, const char *arg);
+extern int find_mtime(find_query *query, const char *arg, time_t now);
+
+// whether an inode passes query's size, time and owner tests
+extern int find_match_inode(const find_query *query, struct fs *fs,
+    const ufs_dinode *dinode);
+
+// print the path of everything under path that query matches
+extern int ufs_find(disk_device *device, struct fs *fs, char *path,
+    const find_query *query, FILE *out);
+
+#endif
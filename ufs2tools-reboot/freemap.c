@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "freemap.h"
+#include "stats.h"
+
+// free run lengths by power of two of fragments
+#define RUN_BUCKETS 48
+
+// what one or more groups' maps hold
+typedef struct _free_space_ {
+	int64_t frags;			/* free fragments */
+	int64_t runs;			/* free runs */
+	int64_t largest;		/* longest run, in fragments */
+	int64_t largest_cg;
+	int64_t short_frags;		/* free in runs shorter than a cluster */
+	int64_t runs_by_size[RUN_BUCKETS];
+	int64_t frags_by_size[RUN_BUCKETS];
+	int64_t clusters[FS_MAXCONTIG + 1];	/* from the cluster summary */
+	int bad;			/* groups that couldn't be read */
+} free_space;
+
+struct freemap_worker {
+	disk_device *device;
+	struct fs *fs;
+	volatile LONG *next;		/* next group to take */
+	free_space total;
+	free_space *cgs;		/* per group, if wanted */
+	HANDLE thread;
+};
+
+// index of the lowest set bit of a nonzero word
+static int lowest_bit(uint64_t x)
+{
+	static const int debruijn[64] = {
+		 0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+	};
+
+	return debruijn[((x & (0 - x)) * 0x03F79D71B4CB0A89ULL) >> 58];
+}
+
+static int popcount(uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+
+static void add_run(struct fs *fs, free_space *fsp, int64_t len)
+{
+	int bucket;
+
+	for (bucket = 0; bucket < RUN_BUCKETS - 1 &&
+	    ((int64_t)2 << bucket) <= len; ++bucket)
+		;
+	fsp->runs++;
+	fsp->runs_by_size[bucket]++;
+	fsp->frags_by_size[bucket] += len;
+	if (len > fsp->largest)
+		fsp->largest = len;
+	if (len < (int64_t)fs->fs_maxcontig * fs->fs_frag)
+		fsp->short_frags += len;
+}
+
+// free runs of a group's map, nbits long. whole words of all free or
+// all allocated fragments are taken at once; mixed ones are walked from
+// one change to the next.
+static void scan_map(struct fs *fs, const uint8_t *map, int64_t nbits,
+    free_space *fsp)
+{
+	uint64_t w, rest;
+	int64_t i, run;
+	int pos, n;
+
+	run = 0;
+	for (i = 0; i < nbits; i += 64) {
+		if (nbits - i >= 64) {
+			memcpy(&w, map + i / NBBY, sizeof(w));
+		} else {
+			w = 0;
+			memcpy(&w, map + i / NBBY, (size_t)howmany(nbits - i,
+			    NBBY));
+			w &= ((uint64_t)1 << (nbits - i)) - 1;
+		}
+
+		if (w == 0) {
+			if (run)
+				add_run(fs, fsp, run);
+			run = 0;
+			continue;
+		}
+		if (w == ~(uint64_t)0) {
+			fsp->frags += 64;
+			run += 64;
+			continue;
+		}
+
+		fsp->frags += popcount(w);
+		for (pos = 0; pos < 64; pos += n) {
+			rest = w >> pos;
+			if (rest & 1) {
+				// free up to the next allocated fragment
+				n = lowest_bit(~rest);
+				run += n;
+				if (pos + n < 64) {
+					add_run(fs, fsp, run);
+					run = 0;
+				}
+			} else {
+				if (run)
+					add_run(fs, fsp, run);
+				run = 0;
+				n = rest ? lowest_bit(rest) : 64 - pos;
+			}
+		}
+	}
+	if (run)
+		add_run(fs, fsp, run);
+}
+
+static void merge_space(free_space *to, const free_space *from, int64_t cg)
+{
+	int i;
+
+	to->frags += from->frags;
+	to->runs += from->runs;
+	to->short_frags += from->short_frags;
+	if (from->largest > to->largest) {
+		to->largest = from->largest;
+		to->largest_cg = cg < 0 ? from->largest_cg : cg;
+	}
+	for (i = 0; i < RUN_BUCKETS; ++i) {
+		to->runs_by_size[i] += from->runs_by_size[i];
+		to->frags_by_size[i] += from->frags_by_size[i];
+	}
+	for (i = 0; i <= FS_MAXCONTIG; ++i)
+		to->clusters[i] += from->clusters[i];
+	to->bad += from->bad;
+}
+
+// read one group and scan its maps
+static int scan_cg(disk_device *device, struct fs *fs, int c,
+    struct cg *cgp, free_space *fsp)
+{
+	int32_t *sum;
+	int64_t t;
+	int i, n;
+
+	memset(fsp, 0, sizeof(*fsp));
+
+	t = stats_begin();
+	if (seek_device(device, ufs_fragtobytes(fs, cgtod(fs, c)), SEEK_SET) ||
+	    read_device(device, (char *)cgp, fs->fs_cgsize)) {
+		stats_end(STATS_READ, t);
+		fsp->bad = 1;
+		return -1;
+	}
+	stats_end(STATS_READ, t);
+
+	if (!cg_chkmagic(cgp) || cgp->cg_cgx != c || cgp->cg_ndblk < 0 ||
+	    cgp->cg_freeoff < 0 || cgp->cg_freeoff +
+	    howmany(cgp->cg_ndblk, NBBY) > fs->fs_cgsize) {
+		fsp->bad = 1;
+		return -1;
+	}
+
+	scan_map(fs, cg_blksfree(cgp), cgp->cg_ndblk, fsp);
+
+	// free clusters of each length, the last counting all longer ones
+	n = fs->fs_contigsumsize < FS_MAXCONTIG ? fs->fs_contigsumsize :
+	    FS_MAXCONTIG;
+	if (n > 0 && cgp->cg_clustersumoff > 0 && cgp->cg_clustersumoff +
+	    (n + 1) * (int)sizeof(int32_t) <= fs->fs_cgsize) {
+		sum = cg_clustersum(cgp);
+		for (i = 1; i <= n; ++i)
+			fsp->clusters[i] = sum[i];
+	}
+
+	return 0;
+}
+
+static DWORD WINAPI freemap_worker(LPVOID arg)
+{
+	struct freemap_worker *worker = arg;
+	struct fs *fs = worker->fs;
+	free_space space;
+	struct cg *cgp;
+	LONG c;
+
+	// the groups are left to the other workers
+	if ((cgp = malloc(fs->fs_cgsize)) == NULL)
+		return 1;
+	while ((c = InterlockedIncrement(worker->next) - 1) < fs->fs_ncg) {
+		scan_cg(worker->device, fs, c, cgp, &space);
+		merge_space(&worker->total, &space, c);
+		if (worker->cgs)
+			worker->cgs[c] = space;
+	}
+	free(cgp);
+
+	return 0;
+}
+
+int print_free_space(disk_device *device, struct fs *fs, int jobs,
+    int cgs, FILE *out)
+{
+	struct freemap_worker *workers;
+	free_space total, *percg;
+	volatile LONG next;
+	int64_t start, elapsed, maps;
+	int i, n, c;
+
+	start = stats_now();
+	if (jobs > fs->fs_ncg)
+		jobs = fs->fs_ncg;
+	if (jobs < 1)
+		jobs = 1;
+
+	workers = calloc(jobs, sizeof(*workers));
+	percg = cgs ? calloc(fs->fs_ncg, sizeof(*percg)) : NULL;
+	if (workers == NULL || (cgs && percg == NULL)) {
+		fprintf(stderr, "ufs2tool: not enough memory to scan the group "
+		    "maps\n");
+		free(percg);
+		free(workers);
+		return -1;
+	}
+	next = 0;
+
+	// the first worker scans on this thread with device itself
+	for (n = 0; n < jobs; ++n) {
+		workers[n].device = n ? clone_device(device) : device;
+		if (workers[n].device == NULL)
+			break;
+		workers[n].fs = fs;
+		workers[n].next = &next;
+		workers[n].cgs = percg;
+		if (n && (workers[n].thread = CreateThread(NULL, 0,
+		    freemap_worker, &workers[n], 0, NULL)) == NULL) {
+			close_device(workers[n].device);
+			break;
+		}
+	}
+	freemap_worker(&workers[0]);
+
+	memset(&total, 0, sizeof(total));
+	for (i = 0; i < n; ++i) {
+		if (i) {
+			WaitForSingleObject(workers[i].thread, INFINITE);
+			CloseHandle(workers[i].thread);
+			close_device(workers[i].device);
+		}
+		merge_space(&total, &workers[i].total, -1);
+	}
+	elapsed = stats_now() - start;
+
+	// no worker had a buffer to scan with
+	if (next < fs->fs_ncg) {
+		fprintf(stderr, "ufs2tool: not enough memory to scan the group "
+		    "maps\n");
+		free(percg);
+		free(workers);
+		return -1;
+	}
+
+	fprintf(out, "free        %I64d KB in %I64d runs\n",
+	    ufs_fragtobytes(fs, total.frags) >> 10, total.runs);
+	fprintf(out, "largest     %I64d KB, in group %I64d\n",
+	    ufs_fragtobytes(fs, total.largest) >> 10, total.largest_cg);
+	fprintf(out, "fragmented  %.1f%% of free space in runs shorter than "
+	    "%d blocks\n", total.frags ? 100.0 * total.short_frags /
+	    total.frags : 0.0, fs->fs_maxcontig);
+
+	// in fragments, as a KB bound rounds to 0 below 1 KB fragments
+	fprintf(out, "\nfree run (frags)        runs     frags  of %d bytes\n",
+	    fs->fs_fsize);
+	for (i = 0; i < RUN_BUCKETS; ++i) {
+		if (!total.runs_by_size[i])
+			continue;
+		fprintf(out, ">= %-17I64d %7I64d %9I64d\n", (int64_t)1 << i,
+		    total.runs_by_size[i], total.frags_by_size[i]);
+	}
+
+	if (fs->fs_contigsumsize > 0) {
+		fprintf(out, "\nfree clusters (blocks)  count\n");
+		for (i = 1; i <= FS_MAXCONTIG && i <= fs->fs_contigsumsize;
+		    ++i) {
+			fprintf(out, "%s%-21d %I64d\n", i ==
+			    fs->fs_contigsumsize ? ">=" : "  ", i,
+			    total.clusters[i]);
+		}
+	}
+
+	if (cgs) {
+		fprintf(out, "\ngroup   free KB     runs  largest KB  "
+		    "fragmented\n");
+		for (c = 0; c < fs->fs_ncg; ++c) {
+			if (percg[c].bad) {
+				fprintf(out, "%-7d (bad header)\n", c);
+				continue;
+			}
+			fprintf(out, "%-7d %7I64d %8I64d %11I64d  %8.1f%%\n",
+			    c, ufs_fragtobytes(fs, percg[c].frags) >> 10,
+			    percg[c].runs,
+			    ufs_fragtobytes(fs, percg[c].largest) >> 10,
+			    percg[c].frags ? 100.0 *
+			    percg[c].short_frags / percg[c].frags : 0.0);
+		}
+	}
+
+	maps = (int64_t)fs->fs_ncg * fs->fs_cgsize;
+	fprintf(out, "\nscanned %d groups, %I64d KB of maps, in %.1f ms "
+	    "with %d threads\n", fs->fs_ncg, maps >> 10, elapsed / 1e6, n);
+	if (total.bad)
+		fprintf(out, "(%d groups had a bad header)\n", total.bad);
+
+	free(percg);
+	free(workers);
+
+	return total.bad ? -1 : 0;
+}
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <winioctl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "image.h"
+#include "sha256.h"
+#include "stats.h"
+
+// reads in flight to the writer
+#define IMAGE_BUFFERS	4
+
+// allocated runs this close together are read as one. the free space
+// between them is copied too, which costs less than another request.
+#define IMAGE_GAP	(256 * 1024)
+
+struct image_buf {
+	char *data;
+	int64_t offset;			/* in the partition */
+	int64_t len;
+};
+
+typedef struct _image_ctx_ {
+	disk_device *device;
+	struct fs *fs;
+	HANDLE out;			/* INVALID_HANDLE_VALUE to only hash */
+	sha256_ctx hash;
+	int64_t gap;			/* IMAGE_GAP, in fragments */
+	// allocated fragments not yet read
+	int64_t run_start;
+	int64_t run_len;
+	// read buffers, the oldest filled one at head
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE filled;
+	CONDITION_VARIABLE emptied;
+	struct image_buf bufs[IMAGE_BUFFERS];
+	int head;
+	int count;
+	int done;
+	int error;
+	int64_t copied;			/* bytes read */
+	int64_t frags;			/* fragments in the file system */
+	int64_t size;			/* bytes in the file system */
+	int bad;			/* groups copied whole */
+} image_ctx;
+
+// hash and write filled buffers in order, while the next ones are read
+static DWORD WINAPI image_writer(LPVOID arg)
+{
+	image_ctx *ctx = arg;
+	struct image_buf *b;
+	LARGE_INTEGER pos;
+	DWORD written;
+	int64_t t;
+	int failed;
+
+	EnterCriticalSection(&ctx->lock);
+	for (;;) {
+		while (!ctx->count && !ctx->done)
+			SleepConditionVariableCS(&ctx->filled, &ctx->lock,
+			    INFINITE);
+		if (!ctx->count)
+			break;
+		b = &ctx->bufs[ctx->head];
+		LeaveCriticalSection(&ctx->lock);
+
+		sha256_update(&ctx->hash, b->data, (size_t)b->len);
+		failed = 0;
+		if (ctx->out != INVALID_HANDLE_VALUE) {
+			t = stats_begin();
+			pos.QuadPart = b->offset;
+			if (!SetFilePointerEx(ctx->out, pos, NULL,
+			    FILE_BEGIN) || !WriteFile(ctx->out, b->data, (DWORD)b->len,
+			    &written, NULL) || written != b->len)
+				failed = 1;
+			stats_end(STATS_WRITE, t);
+			STATS_ADD(written, b->len);
+		}
+
+		EnterCriticalSection(&ctx->lock);
+		if (failed)
+			ctx->error = 1;
+		ctx->head = (ctx->head + 1) % IMAGE_BUFFERS;
+		ctx->count--;
+		WakeConditionVariable(&ctx->emptied);
+	}
+	LeaveCriticalSection(&ctx->lock);
+
+	return 0;
+}
+
+// read the pending run into buffers for the writer
+static int flush_run(image_ctx *ctx)
+{
+	struct fs *fs = ctx->fs;
+	struct image_buf *b;
+	int64_t offset, end, len, t, start;
+
+	offset = ufs_fragtobytes(fs, ctx->run_start);
+	end = ufs_fragtobytes(fs, ctx->run_start + ctx->run_len);
+	ctx->run_len = 0;
+
+	while (offset < end) {
+		EnterCriticalSection(&ctx->lock);
+		while (ctx->count == IMAGE_BUFFERS && !ctx->error)
+			SleepConditionVariableCS(&ctx->emptied, &ctx->lock,
+			    INFINITE);
+		b = &ctx->bufs[(ctx->head + ctx->count) % IMAGE_BUFFERS];
+		LeaveCriticalSection(&ctx->lock);
+		if (ctx->error) {
+			fprintf(stderr, "\nufs2tool: cannot write image\n");
+			return -1;
+		}
+
+		len = device_io_size(ctx->device) / fs->fs_fsize * fs->fs_fsize;
+		if (len < fs->fs_fsize)
+			len = fs->fs_fsize;
+		if (len > end - offset)
+			len = end - offset;
+
+		t = stats_begin();
+		start = device_clock(ctx->device);
+		if (seek_device(ctx->device, offset, SEEK_SET) ||
+		    read_device(ctx->device, b->data, len)) {
+			stats_end(STATS_READ, t);
+			fprintf(stderr, "\nufs2tool: cannot read at %I64d\n",
+			    offset);
+			return -1;
+		}
+		stats_end(STATS_READ, t);
+		device_io_done(ctx->device, len, start);
+
+		b->offset = offset;
+		b->len = len;
+		EnterCriticalSection(&ctx->lock);
+		ctx->count++;
+		WakeConditionVariable(&ctx->filled);
+		LeaveCriticalSection(&ctx->lock);
+
+		offset += len;
+		ctx->copied += len;
+		fprintf(stderr, "%I64d of %I64d MB (%lld%%)\r", offset >> 20,
+		    ctx->size >> 20, offset * 100 / ctx->size);
+	}
+
+	return 0;
+}
+
+// copy fragments start to start + len, with the pending run if it's near
+static int add_run(image_ctx *ctx, int64_t start, int64_t len)
+{
+	if (len <= 0)
+		return 0;
+	if (ctx->run_len &&
+	    start - (ctx->run_start + ctx->run_len) <= ctx->gap) {
+		ctx->run_len = start + len - ctx->run_start;
+		return 0;
+	}
+	if (ctx->run_len && flush_run(ctx))
+		return -1;
+	ctx->run_start = start;
+	ctx->run_len = len;
+
+	return 0;
+}
+
+// a group's metadata and allocated fragments, or all of it if its header
+// can't be trusted
+static int image_cg(image_ctx *ctx, int c, struct cg *cgp)
+{
+	struct fs *fs = ctx->fs;
+	const uint8_t *map;
+	int64_t base, end, i, n, nbits, t;
+
+	base = cgbase(fs, c);
+	end = base + fs->fs_fpg;
+	if (end > ctx->frags)
+		end = ctx->frags;
+
+	t = stats_begin();
+	if (seek_device(ctx->device, ufs_fragtobytes(fs, cgtod(fs, c)),
+	    SEEK_SET) || read_device(ctx->device, (char *)cgp,
+	    fs->fs_cgsize)) {
+		stats_end(STATS_READ, t);
+		fprintf(stderr, "\nufs2tool: cannot read cylinder group %d\n",
+		    c);
+		return -1;
+	}
+	stats_end(STATS_READ, t);
+
+	if (!cg_chkmagic(cgp) || cgp->cg_cgx != c || cgp->cg_ndblk < 0 ||
+	    cgp->cg_freeoff < 0 || cgp->cg_freeoff +
+	    howmany(cgp->cg_ndblk, NBBY) > fs->fs_cgsize) {
+		ctx->bad++;
+		return add_run(ctx, base, end - base);
+	}
+
+	// everything up to the first data fragment: the boot blocks and
+	// superblock in group 0, then a superblock copy, header and inodes
+	i = cgdmin(fs, c) - base;
+	if (i > end - base)
+		i = end - base;
+	if (add_run(ctx, base, i))
+		return -1;
+
+	map = cg_blksfree(cgp);
+	nbits = cgp->cg_ndblk < end - base ? cgp->cg_ndblk : end - base;
+	while (i < nbits) {
+		// whole bytes of free fragments are passed over at once
+		if (i % NBBY == 0 && nbits - i >= NBBY &&
+		    map[i / NBBY] == 0xff) {
+			i += NBBY;
+			continue;
+		}
+		if (isset(map, i)) {
+			++i;
+			continue;
+		}
+		for (n = i + 1; n < nbits && isclr(map, n); ++n)
+			;
+		if (add_run(ctx, base + i, n - i))
+			return -1;
+		i = n;
+	}
+
+	return 0;
+}
+
+int image_partition(disk_device *device, struct fs *fs,
+    const char *destpath, FILE *out)
+{
+	image_ctx ctx;
+	struct cg *cgp;
+	HANDLE writer;
+	LARGE_INTEGER pos;
+	uint8_t digest[SHA256_SIZE];
+	char hex[2 * SHA256_SIZE + 1];
+	int64_t t, started;
+	DWORD n;
+	int c, i, ret;
+
+	started = stats_now();
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.device = device;
+	ctx.fs = fs;
+	ctx.out = INVALID_HANDLE_VALUE;
+	ctx.gap = IMAGE_GAP / fs->fs_fsize;
+	ctx.frags = ufs_old_fields(fs) ? fs->fs_old_size : fs->fs_size;
+	ctx.size = ufs_fragtobytes(fs, ctx.frags);
+	sha256_init(&ctx.hash);
+
+	if (destpath) {
+		t = stats_begin();
+		ctx.out = CreateFile(destpath, GENERIC_WRITE, 0, NULL,
+		    CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (ctx.out == INVALID_HANDLE_VALUE) {
+			stats_end(STATS_WRITE, t);
+			fprintf(stderr, "ufs2tool: cannot create %s\n",
+			    destpath);
+			return -1;
+		}
+		// what's never written then takes no space, where the file
+		// system has sparse files. where it hasn't, it reads as zeros
+		// all the same.
+		DeviceIoControl(ctx.out, FSCTL_SET_SPARSE, NULL, 0, NULL, 0,
+		    &n, NULL);
+		stats_end(STATS_WRITE, t);
+	}
+
+	// buffers big enough for the largest read the device will take
+	device_io_size(device);
+	for (i = 0; i < IMAGE_BUFFERS; ++i)
+		ctx.bufs[i].data = malloc((size_t)device->tune.max);
+	cgp = malloc(fs->fs_cgsize);
+
+	InitializeCriticalSection(&ctx.lock);
+	InitializeConditionVariable(&ctx.filled);
+	InitializeConditionVariable(&ctx.emptied);
+	writer = CreateThread(NULL, 0, image_writer, &ctx, 0, NULL);
+
+	ret = 0;
+	for (c = 0; c < fs->fs_ncg && !ret; ++c)
+		ret = image_cg(&ctx, c, cgp);
+	if (!ret && ctx.run_len)
+		ret = flush_run(&ctx);
+
+	EnterCriticalSection(&ctx.lock);
+	ctx.done = 1;
+	WakeConditionVariable(&ctx.filled);
+	LeaveCriticalSection(&ctx.lock);
+	WaitForSingleObject(writer, INFINITE);
+	CloseHandle(writer);
+	if (!ret && ctx.error) {
+		fprintf(stderr, "\nufs2tool: cannot write image\n");
+		ret = -1;
+	}
+
+	if (ctx.out != INVALID_HANDLE_VALUE) {
+		// the file ends where the file system does, past any last hole
+		t = stats_begin();
+		pos.QuadPart = ctx.size;
+		if (!ret && (!SetFilePointerEx(ctx.out, pos, NULL,
+		    FILE_BEGIN) || !SetEndOfFile(ctx.out))) {
+			fprintf(stderr, "ufs2tool: cannot write image\n");
+			ret = -1;
+		}
+		CloseHandle(ctx.out);
+		stats_end(STATS_WRITE, t);
+		if (ret)
+			DeleteFile(destpath);
+	}
+
+	if (!ret) {
+		sha256_final(&ctx.hash, digest);
+		sha256_hex(digest, hex);
+		fprintf(stderr, "\n%I64d of %I64d MB copied (%.1f%%) in "
+		    "%.1f s", ctx.copied >> 20, ctx.size >> 20,
+		    ctx.copied * 100.0 / ctx.size,
+		    (stats_now() - started) / 1e9);
+		if (ctx.bad)
+			fprintf(stderr, ", %d damaged cylinder groups copied "
+			    "whole", ctx.bad);
+		fprintf(stderr, "\n");
+		fprintf(out, "sha256 %s\n", hex);
+	}
+
+	DeleteCriticalSection(&ctx.lock);
+	for (i = 0; i < IMAGE_BUFFERS; ++i)
+		free(ctx.bufs[i].data);
+	free(cgp);
+
+	return ret;
+}
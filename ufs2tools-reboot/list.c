@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "list.h"
+#include "stats.h"
+
+// entries whose inodes are read together
+#define LIST_BATCH 4096
+
+// sorting function for directory listing
+int sort_direct(const void *first, const void *second)
+{
+	const struct direct *a = first;
+	const struct direct *b = second;
+
+	if (!strcmp(a->d_name, ".")) {
+		return -1;
+	} else if (!strcmp(b->d_name, ".")) {
+		return 1;
+	} else if (!strcmp(a->d_name, "..")) {
+		return -1;
+	} else if (!strcmp(b->d_name, "..")) {
+		return 1;
+	} else {
+		return strcmp(a->d_name, b->d_name);
+	}
+}
+
+int print_dir_listing(disk_device *device, struct fs *fs, char *path,
+    FILE *out)
+{
+	int i, j, ret, numentries, batch;
+	ufs_inop ino, *inos;
+	ufs_block_list *block_list;
+	char *tmp, *buf;
+	char timestring[64];
+	char sizestring[32];
+	char symlinkstring[280];
+	struct direct directtmp;
+	struct direct *direct;
+	ufs_dinode dinode, *dinodes;
+	struct tm *tm;
+	int64_t t;
+
+	t = stats_begin();
+	ino = ufs_lookup_path(device, fs, path, 1, ROOTINO);
+	stats_end(STATS_LOOKUP, t);
+	if (!ino) {
+		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", path);
+		return -1;
+	}
+
+	ufs_read_inode(device, fs, ino, &dinode);
+
+	if (!(dinode.mode & IFDIR)) {
+		fprintf(stderr, "ufs2tool: \"%s\" is not a directory\n", path);
+		return -1;
+	}
+
+	buf = malloc(dinode.size + sizeof(struct direct));
+	t = stats_begin();
+	block_list = ufs_get_block_list(device, fs, &dinode);
+	stats_end(STATS_BLOCKMAP, t);
+	t = stats_begin();
+	ufs_read_data(device, fs, &dinode, block_list, buf, 0, 0);
+	stats_end(STATS_READ, t);
+	ufs_free_block_list(block_list);
+	STATS_ADD(directories, 1);
+	STATS_ADD(dirblocks, lblkno(fs, blkroundup(fs, dinode.size)));
+
+	// this gets number of dir entries
+	tmp = buf;
+	for (numentries = 0; tmp - buf < dinode.size; ++numentries) {
+		ret = ufs_read_direntry(tmp, &directtmp);
+		tmp += ret;
+	}
+
+	direct = malloc(numentries * sizeof(*direct));
+
+	tmp = buf;
+	for (i = 0; i < numentries; ++i) {
+		ret = ufs_read_direntry(tmp, &direct[i]);
+		tmp += ret;
+	}
+	free(buf);
+
+	qsort(direct, numentries, sizeof(*direct), sort_direct);
+
+	batch = numentries < LIST_BATCH ? numentries : LIST_BATCH;
+	inos = malloc((batch ? batch : 1) * sizeof(*inos));
+	dinodes = malloc((batch ? batch : 1) * sizeof(*dinodes));
+
+	for (i = 0; i < numentries; ++i) {
+		// name order is no order on disk, so fetch a batch at a time
+		if (i % batch == 0) {
+			for (j = 0; j < batch && i + j < numentries; ++j)
+				inos[j] = direct[i + j].d_ino;
+			ufs_read_inodes(device, fs, inos, j, dinodes);
+		}
+		dinode = dinodes[i % batch];
+		tm = localtime((const time_t*)(&dinode.mtime));
+
+		if ((dinode.mode & IFMT) == IFDIR) {
+			sprintf(sizestring, "<DIR>");
+		} else {
+			sprintf(sizestring, "%I64u", dinode.size);
+		}
+
+		if ((dinode.mode & IFMT) == IFLNK) {
+			char tmpname[MAX_PATH];
+
+			block_list = ufs_get_block_list(device, fs, &dinode);
+			ufs_read_data(device, fs, &dinode, block_list, tmpname, 0, 0);
+			ufs_free_block_list(block_list);
+			tmpname[dinode.size] = '\0';
+
+			sprintf(symlinkstring, " -> %s", tmpname);
+		} else {
+			symlinkstring[0] = '\0';
+		}
+
+		strftime(timestring, 64, "%b %d,%Y  %H:%M:%S", tm);
+		fprintf(out, "%s %10s %s%s\n", timestring, sizestring,
+		    direct[i].d_name, symlinkstring);
+	}
+
+	free(dinodes);
+	free(inos);
+	free(direct);
+
+	return 0;
+}
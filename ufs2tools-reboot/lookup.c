@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "stats.h"
+#include "trace.h"
+
+// a path component wanted by ufs_lookup_paths. the components of all
+// the paths make a trie, nodes[0] and nodes[1] being the roots of the
+// absolute and relative ones; a parent always comes before its children.
+struct trie_node {
+	char *name;
+	int64_t parent;
+	int64_t first;			/* children, as a range of kids */
+	int64_t count;
+	int64_t next;			/* next in its hash chain, -1 at end */
+	ufs_inop ino;			/* as its directory has it, 0 if not */
+	ufs_inop target;		/* ino with symlinks followed */
+	int type;			/* DT_ type from its directory */
+	int terminal;			/* a path ends here */
+};
+
+// a node among its siblings, sorted by name
+struct trie_kid {
+	int64_t parent;
+	const char *name;
+	int64_t node;
+};
+
+typedef struct _path_trie_ {
+	struct trie_node *nodes;
+	int64_t nnodes;
+	struct trie_kid *kids;
+	int64_t *buckets;		/* (parent, name) hash to first node */
+	int64_t nbuckets;
+} path_trie;
+
+static uint64_t hash_component(int64_t parent, const char *name, size_t len)
+{
+	uint64_t h = 14695981039346656037ULL ^ (uint64_t)parent;
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		h = (h ^ (unsigned char)name[i]) * 1099511628211ULL;
+
+	return h;
+}
+
+// the child of parent called name (len bytes), added if it's new
+static int64_t trie_child(path_trie *trie, int64_t parent, const char *name,
+    size_t len)
+{
+	struct trie_node *node;
+	int64_t *bucket, i;
+
+	bucket = &trie->buckets[hash_component(parent, name, len) &
+	    (trie->nbuckets - 1)];
+	for (i = *bucket; i >= 0; i = trie->nodes[i].next) {
+		node = &trie->nodes[i];
+		if (node->parent == parent && !strncmp(node->name, name, len) &&
+		    node->name[len] == '\0')
+			return i;
+	}
+
+	i = trie->nnodes++;
+	node = &trie->nodes[i];
+	memset(node, 0, sizeof(*node));
+	node->name = malloc(len + 1);
+	memcpy(node->name, name, len);
+	node->name[len] = '\0';
+	node->parent = parent;
+	node->next = *bucket;
+	*bucket = i;
+
+	return i;
+}
+
+static int compare_kids(const void *first, const void *second)
+{
+	const struct trie_kid *a = first;
+	const struct trie_kid *b = second;
+
+	if (a->parent != b->parent)
+		return a->parent < b->parent ? -1 : 1;
+	return strcmp(a->name, b->name);
+}
+
+// the child of node called name, -1 if no path goes there
+static int64_t find_kid(const path_trie *trie, const struct trie_node *node,
+    const char *name)
+{
+	int64_t lo, hi, mid;
+	int cmp;
+
+	lo = node->first;
+	hi = node->first + node->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		cmp = strcmp(trie->kids[mid].name, name);
+		if (!cmp)
+			return trie->kids[mid].node;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return -1;
+}
+
+// read the directory of node once, finding all of its wanted children
+// in one pass over the entries
+static void resolve_dir(disk_device *device, struct fs *fs, path_trie *trie,
+    int64_t n, int follow)
+{
+	struct trie_node *node = &trie->nodes[n];
+	struct trie_node *kid;
+	ufs_block_list *block_list;
+	struct direct direct;
+	ufs_dinode dinode;
+	char *buf;
+	int64_t i, k, pos;
+	uint16_t reclen;
+
+	ufs_read_inode(device, fs, node->target, &dinode);
+	if ((dinode.mode & IFMT) != IFDIR)
+		return;
+
+	block_list = ufs_get_block_list(device, fs, &dinode);
+	buf = malloc((size_t)dinode.size + sizeof(struct direct));
+	ufs_read_data(device, fs, &dinode, block_list, buf, 0, 0);
+	ufs_free_block_list(block_list);
+	STATS_ADD(directories, 1);
+	STATS_ADD(dirblocks, lblkno(fs, blkroundup(fs, dinode.size)));
+
+	for (pos = 0; pos < (int64_t)dinode.size; pos += reclen) {
+		reclen = ufs_read_direntry(buf + pos, &direct);
+		if (!reclen)
+			break;
+		k = find_kid(trie, node, direct.d_name);
+		if (k < 0 || trie->nodes[k].ino)
+			continue;
+		trie->nodes[k].ino = direct.d_ino;
+		trie->nodes[k].type = fs->fs_maxsymlinklen <= 0 ? DT_UNKNOWN :
+		    direct.d_type;
+		TRACE_LOOKUP(direct.d_name, direct.d_ino);
+	}
+	free(buf);
+
+	// as ufs_lookup_path does, follow symlinks on the way, and at the
+	// end if asked to. the type says which can't be one.
+	for (i = node->first; i < node->first + node->count; ++i) {
+		kid = &trie->nodes[trie->kids[i].node];
+		if (!kid->ino || !(kid->count || (kid->terminal && follow)))
+			continue;
+		if (kid->type == DT_LNK || kid->type == DT_UNKNOWN)
+			kid->target = ufs_follow_symlinks(device, fs,
+			    node->target, kid->ino);
+		else
+			kid->target = kid->ino;
+	}
+}
+
+int ufs_lookup_paths(disk_device *device, struct fs *fs, char **paths,
+    int64_t npaths, int follow, ufs_inop root_ino, ufs_inop *inos)
+{
+	path_trie trie;
+	int64_t *ends, i, n, max, parent;
+	struct trie_node *node;
+	const char *p, *slash;
+	int ret;
+
+	// every component of every path, at most
+	for (i = 0, max = 2; i < npaths; ++i) {
+		for (p = paths[i]; *p; ++p)
+			max += *p == '/';
+		max++;
+	}
+
+	memset(&trie, 0, sizeof(trie));
+	trie.nodes = malloc(max * sizeof(*trie.nodes));
+	for (trie.nbuckets = 1; trie.nbuckets < 2 * max; trie.nbuckets *= 2)
+		;
+	trie.buckets = malloc(trie.nbuckets * sizeof(*trie.buckets));
+	memset(trie.buckets, 0xff, trie.nbuckets * sizeof(*trie.buckets));
+	ends = malloc((npaths ? npaths : 1) * sizeof(*ends));
+
+	// the roots never match a component, their parent being -1
+	for (i = 0; i < 2; ++i) {
+		memset(&trie.nodes[i], 0, sizeof(trie.nodes[i]));
+		trie.nodes[i].name = strdup("");
+		trie.nodes[i].parent = -1;
+		trie.nodes[i].next = -1;
+		trie.nodes[i].type = DT_DIR;
+	}
+	trie.nodes[0].ino = trie.nodes[0].target = ROOTINO;
+	trie.nodes[1].ino = trie.nodes[1].target = root_ino;
+	trie.nnodes = 2;
+
+	// as with ufs_lookup_path, a path with an empty component before its
+	// end, like a//b, isn't found; ends[] is -1 for it
+	for (i = 0; i < npaths; ++i) {
+		p = paths[i];
+		parent = *p == '/' ? 0 : 1;
+		if (*p == '/')
+			++p;
+		while (*p && *p != '/') {
+			slash = strchr(p, '/');
+			n = slash ? slash - p : (int64_t)strlen(p);
+			parent = trie_child(&trie, parent, p, (size_t)n);
+			p += n;
+			if (*p)
+				++p;
+		}
+		if (*p) {
+			ends[i] = -1;
+			continue;
+		}
+		trie.nodes[parent].terminal = 1;
+		ends[i] = parent;
+	}
+
+	trie.kids = malloc(trie.nnodes * sizeof(*trie.kids));
+	for (i = 0; i < trie.nnodes; ++i) {
+		trie.kids[i].parent = trie.nodes[i].parent;
+		trie.kids[i].name = trie.nodes[i].name;
+		trie.kids[i].node = i;
+	}
+	qsort(trie.kids, (size_t)trie.nnodes, sizeof(*trie.kids),
+	    compare_kids);
+	for (i = 0; i < trie.nnodes; ++i) {
+		if (trie.kids[i].parent < 0)
+			continue;
+		node = &trie.nodes[trie.kids[i].parent];
+		if (!node->count)
+			node->first = i;
+		node->count++;
+	}
+
+	// parents come first, so each directory is known when it's reached
+	for (i = 0; i < trie.nnodes; ++i) {
+		if (trie.nodes[i].count && trie.nodes[i].target)
+			resolve_dir(device, fs, &trie, i, follow);
+	}
+
+	ret = 0;
+	for (i = 0; i < npaths; ++i) {
+		node = ends[i] < 0 ? NULL : &trie.nodes[ends[i]];
+		if (node == NULL)
+			inos[i] = 0;
+		else
+			inos[i] = ends[i] < 2 || follow ? node->target :
+			    node->ino;
+		if (!inos[i])
+			ret = -1;
+	}
+
+	for (i = 0; i < trie.nnodes; ++i)
+		free(trie.nodes[i].name);
+	free(trie.nodes);
+	free(trie.kids);
+	free(trie.buckets);
+	free(ends);
+
+	return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MEMCOUNT_H_
+#define _MEMCOUNT_H_
+
+// with UFS_COUNT_ALLOCS defined (ufsbench is built that way), every
+// malloc, calloc, realloc and strdup made by code that includes this is
+// counted in ufs_allocs, which the including program defines. it has to
+// come after the C library headers.
+#ifdef UFS_COUNT_ALLOCS
+
+#include <stdint.h>
+
+extern volatile int64_t ufs_allocs;
+
+static __inline void *ufs_count_alloc(void *p)
+{
+	ufs_allocs++;
+	return p;
+}
+
+#define malloc(n)	ufs_count_alloc(malloc(n))
+#define calloc(n, s)	ufs_count_alloc(calloc(n, s))
+#define realloc(p, n)	ufs_count_alloc(realloc(p, n))
+#define strdup(s)	ufs_count_alloc(strdup(s))
+
+#endif
+
+#endif
@@ -1,165 +1,244 @@
-/*
- * Copyright (c) 2004 Nehal Mistry
- * All rights reserved.
- * 
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission.
- * 
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
- * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
- * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
- * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
- * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include <windows.h>
-#include <string.h>
-
-// invalid names (case-insensitive), including an appended '.'
-// omitting "CON"
-char *reserved_names[] = {
-	"PRN",
-	"AUX",
-	"NUL",
-	"COM1",
-	"COM2",
-	"COM3",
-	"COM4",
-	"COM5",
-	"COM6",
-	"COM7",
-	"COM8",
-	"COM9",
-	"LPT1",
-	"LPT2",
-	"LPT3",
-	"LPT4",
-	"LPT5",
-	"LPT6",
-	"LPT7",
-	"LPT8",
-	"LPT9",
-	"CLOCK$"
-};
-
-// invalid chars, also 0-31
-char reserved_chars[] = {
-	'<',
-	'>',
-	':',
-	'"',
-	'/',
-	'\\',
-	'|'
-};
-
-char *basename(const char *path)
-{
-	char *base, *f;
-
-	if (path == NULL || path[0] == '\0') {
-		base = strdup(".");
-	} else {
-		base = strdup(path);
-		if ((f = strrchr(base, '/'))) {
-			base = strdup(++f);
-		} else {
-			base = strdup(path);
-		}
-	}
-
-	return base;
-}
-
-char *dirname(const char *path)
-{
-	char *dir;
-
-	if (path == NULL || path[0] == '\0' || strchr(path, '/') == NULL) {
-		dir = strdup(".");
-	} else {
-		char *s;
-		dir = strdup(path);
-		s = strrchr(dir, '/');
-		while (*--s == '/');
-		*++s = '\0';
-	}
-
-	return dir;
-}
-
-char *valid_filename(char *path, int allowcon)
-{
-	char *dir, *base;
-	char *validname;
-	char tmp[MAX_PATH];
-	char invext[64];
-	int i, j;
-	int invalid;
-	int skip;
-
-	validname = malloc(MAX_PATH);
-
-	dir = dirname(path);
-	base = basename(path);
-
-	strcpy(validname, dir);
-	strcat(validname, "/");
-
-	invalid = 0;
-	for (i = 0; i < sizeof(reserved_names) / sizeof(*reserved_names)
-	    && !invalid; ++i) {
-		strcpy(invext, reserved_names[i]);
-		strcat(invext, ".");
-
-		if (!stricmp(base, reserved_names[i]) ||
-		    !strnicmp(base, invext, strlen(invext))) {
-			invalid = 1;
-		}
-	}
-
-	if (!allowcon && (!stricmp(base, "CON") || !(strnicmp(base, "CON.", 4))))
-		invalid = 1;
-
-	tmp[0] = '\0';
-	for (i = 0; base[i] != '\0'; ++i) {
-		skip = 0;
-		if (base[i] >= 0 && base[i] <= 31) {
-			invalid = 1;
-			skip = 1;
-		}
-		for (j = 0; !skip && j < sizeof(reserved_chars) /
-		    sizeof(*reserved_chars); j++) {
-			if (base[i] == reserved_chars[j] ||
-			    (base[i] >= 0 && base[i] <= 31)) {
-				invalid = 1;
-				skip = 1;
-			}
-		}
-		if (!skip) {
-			strncat(tmp, &base[i], 1);
-		}
-	}
-
-	if (invalid)
-		strcat(validname, "__");
-	strcat(validname, tmp);
-
-	free(dir);
-	free(base);
-
-	return validname;
-}
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+
+// invalid names (case-insensitive), including an appended '.'
+// omitting "CON"
+char *reserved_names[] = {
+	"PRN",
+	"AUX",
+	"NUL",
+	"COM1",
+	"COM2",
+	"COM3",
+	"COM4",
+	"COM5",
+	"COM6",
+	"COM7",
+	"COM8",
+	"COM9",
+	"LPT1",
+	"LPT2",
+	"LPT3",
+	"LPT4",
+	"LPT5",
+	"LPT6",
+	"LPT7",
+	"LPT8",
+	"LPT9",
+	"CLOCK$"
+};
+
+// invalid chars, also 0-31
+char reserved_chars[] = {
+	'<',
+	'>',
+	':',
+	'"',
+	'/',
+	'\\',
+	'|'
+};
+
+char *basename(const char *path)
+{
+	char *base, *f;
+
+	if (path == NULL || path[0] == '\0') {
+		base = strdup(".");
+	} else {
+		if ((f = strrchr(path, '/'))) {
+			base = strdup(++f);
+		} else {
+			base = strdup(path);
+		}
+	}
+
+	return base;
+}
+
+char *dirname(const char *path)
+{
+	char *dir;
+
+	if (path == NULL || path[0] == '\0' || strchr(path, '/') == NULL) {
+		dir = strdup(".");
+	} else {
+		char *s;
+		dir = strdup(path);
+		s = strrchr(dir, '/');
+		while (*--s == '/');
+		*++s = '\0';
+	}
+
+	return dir;
+}
+
+char *valid_filename(char *path, int allowcon)
+{
+	char *dir, *base;
+	char *validname;
+	char tmp[MAX_PATH];
+	char invext[64];
+	int i, j;
+	int invalid;
+	int skip;
+
+	validname = malloc(MAX_PATH);
+
+	dir = dirname(path);
+	base = basename(path);
+
+	strcpy(validname, dir);
+	strcat(validname, "/");
+
+	invalid = 0;
+	for (i = 0; i < sizeof(reserved_names) / sizeof(*reserved_names)
+	    && !invalid; ++i) {
+		strcpy(invext, reserved_names[i]);
+		strcat(invext, ".");
+
+		if (!stricmp(base, reserved_names[i]) ||
+		    !strnicmp(base, invext, strlen(invext))) {
+			invalid = 1;
+		}
+	}
+
+	if (!allowcon && (!stricmp(base, "CON") || !(strnicmp(base, "CON.", 4))))
+		invalid = 1;
+
+	tmp[0] = '\0';
+	for (i = 0; base[i] != '\0'; ++i) {
+		skip = 0;
+		if (base[i] >= 0 && base[i] <= 31) {
+			invalid = 1;
+			skip = 1;
+		}
+		for (j = 0; !skip && j < sizeof(reserved_chars) /
+		    sizeof(*reserved_chars); j++) {
+			if (base[i] == reserved_chars[j] ||
+			    (base[i] >= 0 && base[i] <= 31)) {
+				invalid = 1;
+				skip = 1;
+			}
+		}
+		if (!skip) {
+			strncat(tmp, &base[i], 1);
+		}
+	}
+
+	if (invalid)
+		strcat(validname, "__");
+	strcat(validname, tmp);
+
+	free(dir);
+	free(base);
+
+	return validname;
+}
+
+// does the character class at *pattern, after its '[', take c. sets
+// *pattern past the closing ']'.
+static int match_class(const char **pattern, unsigned char c)
+{
+	const unsigned char *p = (const unsigned char *)*pattern;
+	int negate, match;
+
+	negate = (*p == '!' || *p == '^');
+	if (negate)
+		++p;
+
+	// a ']' first is part of the class
+	for (match = 0; *p && (*p != ']' || p == (const unsigned char *)
+	    *pattern + negate); ++p) {
+		if (p[1] == '-' && p[2] && p[2] != ']') {
+			if (c >= p[0] && c <= p[2])
+				match = 1;
+			p += 2;
+		} else if (*p == c) {
+			match = 1;
+		}
+	}
+	*pattern = (const char *)(*p ? p + 1 : p);
+
+	return match != negate;
+}
+
+// shell style match of name against pattern: '*', '?', '[...]', and '\'
+// to take the next character as it is. case-sensitive, as UFS is.
+int match_glob(const char *pattern, const char *name)
+{
+	const char *star, *resume;
+
+	star = resume = NULL;
+	while (*name) {
+		if (*pattern == '*') {
+			// remember where, and try matching nothing first
+			star = ++pattern;
+			resume = name;
+			continue;
+		}
+
+		if (*pattern == '?') {
+			++pattern;
+			++name;
+			continue;
+		}
+
+		if (*pattern == '[') {
+			++pattern;
+			if (match_class(&pattern, *name)) {
+				++name;
+				continue;
+			}
+		} else {
+			if (*pattern == '\\' && pattern[1])
+				++pattern;
+			if (*pattern && *pattern == *name) {
+				++pattern;
+				++name;
+				continue;
+			}
+		}
+
+		// no match here, let the last '*' take one more character
+		if (!star)
+			return 0;
+		pattern = star;
+		name = ++resume;
+	}
+
+	while (*pattern == '*')
+		++pattern;
+
+	return *pattern == '\0';
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sha256.h"
+
+// FIPS 180-4
+static const uint32_t k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(sha256_ctx *ctx, const uint8_t *p)
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; ++i, p += 4)
+		w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+		    (uint32_t)p[2] << 8 | p[3];
+	for (; i < 64; ++i)
+		w[i] = (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^
+		    (w[i - 2] >> 10)) + w[i - 7] + (ROTR(w[i - 15], 7) ^
+		    ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	for (i = 0; i < 64; ++i) {
+		t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) +
+		    ((e & f) ^ (~e & g)) + k[i] + w[i];
+		t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) +
+		    ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+	ctx->state[5] += f;
+	ctx->state[6] += g;
+	ctx->state[7] += h;
+}
+
+void sha256_init(sha256_ctx *ctx)
+{
+	static const uint32_t initial[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	memcpy(ctx->state, initial, sizeof(initial));
+	ctx->count = 0;
+}
+
+void sha256_update(sha256_ctx *ctx, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	size_t have, n;
+
+	have = (size_t)(ctx->count % 64);
+	ctx->count += len;
+
+	if (have) {
+		n = 64 - have < len ? 64 - have : len;
+		memcpy(ctx->buf + have, p, n);
+		p += n;
+		len -= n;
+		if (have + n < 64)
+			return;
+		sha256_block(ctx, ctx->buf);
+	}
+	// whole blocks straight from the caller's buffer
+	for (; len >= 64; p += 64, len -= 64)
+		sha256_block(ctx, p);
+	memcpy(ctx->buf, p, len);
+}
+
+void sha256_final(sha256_ctx *ctx, uint8_t digest[SHA256_SIZE])
+{
+	uint64_t bits = ctx->count * 8;
+	size_t have = (size_t)(ctx->count % 64);
+	int i;
+
+	ctx->buf[have++] = 0x80;
+	if (have > 56) {
+		memset(ctx->buf + have, 0, 64 - have);
+		sha256_block(ctx, ctx->buf);
+		have = 0;
+	}
+	memset(ctx->buf + have, 0, 56 - have);
+	for (i = 0; i < 8; ++i)
+		ctx->buf[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+	sha256_block(ctx, ctx->buf);
+
+	for (i = 0; i < 8; ++i) {
+		digest[4 * i] = (uint8_t)(ctx->state[i] >> 24);
+		digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+		digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+		digest[4 * i + 3] = (uint8_t)ctx->state[i];
+	}
+}
+
+void sha256_hex(const uint8_t digest[SHA256_SIZE], char *hex)
+{
+	int i;
+
+	for (i = 0; i < SHA256_SIZE; ++i)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+}
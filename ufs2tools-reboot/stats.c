@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <psapi.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "stats.h"
+
+int stats_enabled;
+ufs_stats stats;
+
+static const char *phase_names[STATS_NPHASES] = {
+	"probe",
+	"lookup",
+	"blockmap",
+	"read",
+	"write",
+	"utime"
+};
+
+static int64_t stats_start;
+
+// periodic snapshots
+static HANDLE snapshot_thread;
+static HANDLE snapshot_stop;
+static FILE *snapshot_file;
+static int snapshot_interval;
+
+// monotonic time in nanoseconds
+int64_t stats_now(void)
+{
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+
+	return (int64_t)((double)now.QuadPart * 1e9 / freq.QuadPart);
+}
+
+int64_t stats_begin(void)
+{
+	if (!stats_enabled)
+		return 0;
+
+	return stats_now();
+}
+
+void stats_end(stats_phase phase, int64_t start)
+{
+	if (!stats_enabled || !start)
+		return;
+
+	InterlockedExchangeAdd64(&stats.phase_time[phase], stats_now() - start);
+	InterlockedExchangeAdd64(&stats.phase_calls[phase], 1);
+}
+
+static int log2_floor(uint64_t n)
+{
+	int i;
+
+	for (i = 0; n > 1; ++i)
+		n >>= 1;
+
+	return i;
+}
+
+// a read_device call
+void stats_read(int64_t numbytes)
+{
+	int bucket;
+
+	if (!stats_enabled)
+		return;
+
+	bucket = numbytes > 0 ? log2_floor(numbytes) : 0;
+	if (bucket >= STATS_SIZE_BUCKETS)
+		bucket = STATS_SIZE_BUCKETS - 1;
+
+	InterlockedExchangeAdd64(&stats.reads, 1);
+	InterlockedExchangeAdd64(&stats.sizes[bucket], 1);
+}
+
+// a request to the device, which started at start
+void stats_request(int64_t numbytes, int64_t start)
+{
+	int64_t ns;
+	int bucket, shift;
+
+	if (!stats_enabled)
+		return;
+
+	ns = stats_now() - start;
+	if (ns < 1)
+		ns = 1;
+
+	// the power of two, then the next two bits below it
+	shift = log2_floor(ns);
+	bucket = shift * 4;
+	if (shift >= 2)
+		bucket += (int)(ns >> (shift - 2)) & 3;
+
+	InterlockedExchangeAdd64(&stats.requests, 1);
+	InterlockedExchangeAdd64(&stats.bytes, numbytes);
+	InterlockedExchangeAdd64(&stats.latency[bucket], 1);
+}
+
+void stats_enable(void)
+{
+	stats_start = stats_now();
+	stats_enabled = 1;
+}
+
+// upper bound of a latency bucket, in ns
+static int64_t latency_bound(int bucket)
+{
+	int shift;
+
+	shift = bucket / 4;
+	if (shift < 2)
+		return (int64_t)2 << shift;
+
+	return ((int64_t)1 << shift) + ((int64_t)(bucket % 4 + 1) <<
+	    (shift - 2));
+}
+
+// latency below which fraction of the requests completed, in ns
+static int64_t latency_percentile(double fraction)
+{
+	int64_t total, seen;
+	int i;
+
+	total = 0;
+	for (i = 0; i < STATS_LATENCY_BUCKETS; ++i)
+		total += stats.latency[i];
+	if (!total)
+		return 0;
+
+	seen = 0;
+	for (i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+		seen += stats.latency[i];
+		if (seen >= total * fraction)
+			return latency_bound(i);
+	}
+
+	return latency_bound(STATS_LATENCY_BUCKETS - 1);
+}
+
+static int64_t peak_memory(void)
+{
+	PROCESS_MEMORY_COUNTERS pmc;
+
+	memset(&pmc, 0, sizeof(pmc));
+	GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+
+	return (int64_t)pmc.PeakWorkingSetSize;
+}
+
+void stats_print(FILE *out)
+{
+	int i;
+
+	fprintf(out, "\nelapsed     %.3f s\n",
+	    (stats_now() - stats_start) / 1e9);
+	fprintf(out, "seeks       %I64d\n", stats.seeks);
+	fprintf(out, "reads       %I64d (%I64d requests, %I64d not "
+	    "contiguous)\n", stats.reads, stats.requests, stats.discontig);
+	fprintf(out, "bytes read  %I64d (%I64d through the bounce buffer)\n",
+	    stats.bytes, stats.bounced);
+	fprintf(out, "inodes      %I64d\n", stats.inodes);
+	fprintf(out, "directories %I64d (%I64d blocks)\n", stats.directories,
+	    stats.dirblocks);
+	fprintf(out, "blocks      %I64d\n", stats.blocks);
+	fprintf(out, "written     %I64d files, %I64d bytes\n", stats.files,
+	    stats.written);
+	if (stats.unchanged)
+		fprintf(out, "unchanged   %I64d files\n", stats.unchanged);
+	if (stats.cloned)
+		fprintf(out, "cloned      %I64d bytes\n", stats.cloned);
+	if (stats.ra_fetched) {
+		fprintf(out, "read-ahead  %I64d bytes, %I64d used, %I64d "
+		    "wasted\n", stats.ra_fetched, stats.ra_used,
+		    stats.ra_wasted);
+	}
+	if (stats.walk_depth)
+		fprintf(out, "walk        %I64d reads in flight at most\n",
+		    stats.walk_depth);
+	fprintf(out, "peak memory %I64d KB\n", peak_memory() >> 10);
+	if (stats.io_start) {
+		fprintf(out, "copy size   %I64d KB, started at %I64d KB, "
+		    "changed %I64d times\n", stats.io_size >> 10,
+		    stats.io_start >> 10, stats.io_changes);
+		fprintf(out, "device      minimum %I64d, optimal %I64d, %s\n",
+		    stats.io_min, stats.io_opt, stats.rotational < 0 ?
+		    "unknown if rotational" : stats.rotational ?
+		    "rotational" : "not rotational");
+	}
+
+	fprintf(out, "\nlatency     p50 %.1f us, p90 %.1f us, p99 %.1f us, "
+	    "max %.1f us\n", latency_percentile(0.5) / 1e3,
+	    latency_percentile(0.9) / 1e3, latency_percentile(0.99) / 1e3,
+	    latency_percentile(1.0) / 1e3);
+
+	fprintf(out, "\nread size   count\n");
+	for (i = 0; i < STATS_SIZE_BUCKETS; ++i) {
+		if (stats.sizes[i])
+			fprintf(out, ">= %-8I64d %I64d\n", (int64_t)1 << i,
+			    stats.sizes[i]);
+	}
+
+	// summed over threads, so with -a this can exceed the elapsed time
+	fprintf(out, "\nphase       seconds   calls\n");
+	for (i = 0; i < STATS_NPHASES; ++i) {
+		fprintf(out, "%-10s %8.3f %7I64d\n", phase_names[i],
+		    stats.phase_time[i] / 1e9, stats.phase_calls[i]);
+	}
+}
+
+// the counters as one line of json
+void stats_json(FILE *out)
+{
+	int i;
+
+	fprintf(out, "{\"elapsed\": %.6f, \"seeks\": %I64d, \"reads\": %I64d, "
+	    "\"requests\": %I64d, \"discontiguous\": %I64d, \"bytes\": %I64d, "
+	    "\"bounced\": %I64d, \"inodes\": %I64d, \"directories\": %I64d, "
+	    "\"dirblocks\": %I64d, \"blocks\": %I64d, \"files\": %I64d, "
+	    "\"written\": %I64d, \"unchanged\": %I64d, \"cloned\": %I64d, "
+	    "\"peak_memory\": %I64d, ",
+	    (stats_now() - stats_start) / 1e9, stats.seeks, stats.reads,
+	    stats.requests, stats.discontig, stats.bytes, stats.bounced,
+	    stats.inodes, stats.directories, stats.dirblocks, stats.blocks,
+	    stats.files, stats.written, stats.unchanged, stats.cloned,
+	    peak_memory());
+
+	fprintf(out, "\"readahead\": {\"fetched\": %I64d, \"used\": %I64d, "
+	    "\"wasted\": %I64d}, ", stats.ra_fetched, stats.ra_used,
+	    stats.ra_wasted);
+	fprintf(out, "\"walk_depth\": %I64d, ", stats.walk_depth);
+	fprintf(out, "\"io_size\": {\"size\": %I64d, \"start\": %I64d, "
+	    "\"changes\": %I64d, \"device_min\": %I64d, \"device_opt\": %I64d, "
+	    "\"rotational\": %I64d}, ", stats.io_size, stats.io_start,
+	    stats.io_changes, stats.io_min, stats.io_opt, stats.rotational);
+
+	fprintf(out, "\"latency_us\": {\"p50\": %.1f, \"p90\": %.1f, "
+	    "\"p99\": %.1f, \"max\": %.1f}, ", latency_percentile(0.5) / 1e3,
+	    latency_percentile(0.9) / 1e3, latency_percentile(0.99) / 1e3,
+	    latency_percentile(1.0) / 1e3);
+
+	fprintf(out, "\"read_sizes\": [");
+	for (i = 0; i < STATS_SIZE_BUCKETS; ++i)
+		fprintf(out, "%s%I64d", i ? ", " : "", stats.sizes[i]);
+	fprintf(out, "], \"phases\": {");
+	for (i = 0; i < STATS_NPHASES; ++i) {
+		fprintf(out, "%s\"%s\": {\"seconds\": %.6f, \"calls\": %I64d}",
+		    i ? ", " : "", phase_names[i], stats.phase_time[i] / 1e9,
+		    stats.phase_calls[i]);
+	}
+	fprintf(out, "}}\n");
+	fflush(out);
+}
+
+static DWORD WINAPI snapshot_worker(LPVOID arg)
+{
+	while (WaitForSingleObject(snapshot_stop, snapshot_interval * 1000) ==
+	    WAIT_TIMEOUT)
+		stats_json(snapshot_file);
+
+	return 0;
+}
+
+// write a json snapshot to path every interval seconds, and a last one
+// from stats_stop_snapshots()
+int stats_start_snapshots(const char *path, int interval)
+{
+	snapshot_file = fopen(path, "w");
+	if (snapshot_file == NULL)
+		return -1;
+
+	snapshot_interval = interval;
+	snapshot_stop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	snapshot_thread = CreateThread(NULL, 0, snapshot_worker, NULL, 0,
+	    NULL);
+
+	return 0;
+}
+
+void stats_stop_snapshots(void)
+{
+	if (snapshot_file == NULL)
+		return;
+
+	SetEvent(snapshot_stop);
+	WaitForSingleObject(snapshot_thread, INFINITE);
+	CloseHandle(snapshot_thread);
+	CloseHandle(snapshot_stop);
+
+	stats_json(snapshot_file);
+	fclose(snapshot_file);
+	snapshot_file = NULL;
+}
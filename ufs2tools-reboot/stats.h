@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// counters behind --stats. everything is global and updated with
+// interlocked adds, so the threads of -a all count into the same place.
+// nothing is counted (or timed) until stats_enable() is called.
+
+// where the time goes. phases are timed around the calls in extract.c and
+// ufs2tool.c, so time spent in one phase doesn't also count in another.
+typedef enum {
+	STATS_PROBE,			/* slice tables, labels, superblock */
+	STATS_LOOKUP,			/* path lookup and symlinks */
+	STATS_BLOCKMAP,			/* building block lists */
+	STATS_READ,			/* file and directory data */
+	STATS_WRITE,			/* creating and writing files */
+	STATS_UTIME,			/* setting file times */
+	STATS_NPHASES
+} stats_phase;
+
+// read sizes by power of two, latencies by quarter power of two of ns
+#define STATS_SIZE_BUCKETS	48
+#define STATS_LATENCY_BUCKETS	(64 * 4)
+
+typedef struct _ufs_stats_ {
+	volatile int64_t seeks;		/* seek_device calls */
+	volatile int64_t reads;		/* read_device calls */
+	volatile int64_t requests;	/* reads issued to the device */
+	volatile int64_t bytes;		/* bytes those requests returned */
+	volatile int64_t discontig;	/* requests not following the last */
+	volatile int64_t bounced;	/* bytes copied via the bounce buffer */
+	volatile int64_t inodes;	/* inodes read */
+	volatile int64_t directories;	/* directories read */
+	volatile int64_t dirblocks;	/* blocks of those directories */
+	volatile int64_t blocks;	/* block pointers mapped */
+	volatile int64_t files;		/* files written */
+	volatile int64_t written;	/* bytes written */
+	volatile int64_t unchanged;	/* files already copied, skipped */
+	volatile int64_t cloned;	/* of written, bytes cloned instead */
+	volatile int64_t ra_fetched;	/* bytes read ahead */
+	volatile int64_t ra_used;	/* of those, bytes read_device took */
+	volatile int64_t ra_wasted;	/* dropped without being read */
+	volatile int64_t walk_depth;	/* most walk reads in flight */
+	// copy read size, as the last device to change it left it
+	volatile int64_t io_min;	/* device reported, 0 if not */
+	volatile int64_t io_opt;
+	volatile int64_t rotational;	/* -1 if not reported */
+	volatile int64_t io_start;	/* first size, 0 if none chosen */
+	volatile int64_t io_size;	/* current size */
+	volatile int64_t io_changes;	/* times it changed */
+	volatile int64_t phase_time[STATS_NPHASES];	/* ns, all threads */
+	volatile int64_t phase_calls[STATS_NPHASES];
+	volatile int64_t sizes[STATS_SIZE_BUCKETS];	/* read_device sizes */
+	volatile int64_t latency[STATS_LATENCY_BUCKETS];	/* per request */
+} ufs_stats;
+
+extern int stats_enabled;
+extern ufs_stats stats;
+
+#define STATS_ADD(counter, n) do {					\
+	if (stats_enabled)						\
+		InterlockedExchangeAdd64(&stats.counter, (n));		\
+} while (0)
+
+// raise counter to n, if n is more, against other threads doing the same
+#define STATS_MAX(counter, n) do {					\
+	int64_t n_ = (n), old_;						\
+	if (stats_enabled)						\
+		while ((old_ = stats.counter) < n_ &&			\
+		    InterlockedCompareExchange64(&stats.counter, n_,	\
+		    old_) != old_)						\
+			;						\
+} while (0)
+
+extern int64_t stats_now(void);
+
+// returns the start time for stats_end(), 0 if stats are off
+extern int64_t stats_begin(void);
+extern void stats_end(stats_phase phase, int64_t start);
+
+extern void stats_read(int64_t numbytes);
+extern void stats_request(int64_t numbytes, int64_t start);
+
+extern void stats_enable(void);
+extern int stats_start_snapshots(const char *path, int interval);
+extern void stats_stop_snapshots(void);
+extern void stats_print(FILE *out);
+extern void stats_json(FILE *out);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "stream.h"
+#include "walk.h"
+#include "stats.h"
+
+// what holes are lent from
+static const char zeros[1 << 16];
+
+struct stream_walk {
+	disk_device *device;
+	struct fs *fs;
+	const ufs_sink *sink;
+	int error;
+};
+
+int ufs_stream_file(disk_device *device, struct fs *fs,
+    ufs_dinode *dinode, const ufs_sink *sink)
+{
+	ufs_block_list *block_list;
+	int64_t size, nblocks, b, end, offset, len, n, chunk, t, start;
+	char *buf;
+	int hole, ret;
+
+	size = dinode->size;
+	nblocks = howmany(size, fs->fs_bsize);
+	if (!nblocks)
+		return STREAM_CONTINUE;
+
+	t = stats_begin();
+	block_list = ufs_get_block_list(device, fs, dinode);
+	stats_end(STATS_BLOCKMAP, t);
+	if (block_list == NULL)
+		return -1;
+
+	// big enough for the largest read the device will take
+	device_io_size(device);
+	buf = malloc((size_t)device->tune.max);
+
+	ret = STREAM_CONTINUE;
+	for (b = 0; b < nblocks && ret == STREAM_CONTINUE; b = end) {
+		// the run of holes, or of blocks with data, from block b
+		hole = ufs_block_at(fs, block_list, b) == 0;
+		for (end = b + 1; end < nblocks &&
+		    (ufs_block_at(fs, block_list, end) == 0) == hole; ++end)
+			;
+		offset = b * fs->fs_bsize;
+		len = (end * fs->fs_bsize < size ? end * fs->fs_bsize :
+		    size) - offset;
+
+		for (; len > 0 && ret == STREAM_CONTINUE; offset += n,
+		    len -= n) {
+			if (hole) {
+				n = len < sizeof(zeros) ? len : sizeof(zeros);
+				ret = sink->data(sink->arg, zeros, n, offset);
+				continue;
+			}
+
+			chunk = device_io_size(device) / fs->fs_fsize;
+			if (chunk < 1)
+				chunk = 1;
+			if (chunk > howmany(len, fs->fs_fsize))
+				chunk = howmany(len, fs->fs_fsize);
+			t = stats_begin();
+			start = device_clock(device);
+			n = ufs_read_data(device, fs, dinode, block_list, buf,
+			    offset / fs->fs_fsize, chunk);
+			stats_end(STATS_READ, t);
+			if (n <= 0) {
+				ret = -1;
+				break;
+			}
+			device_io_done(device, n, start);
+			if (n > len)
+				n = len;
+			ret = sink->data(sink->arg, buf, n, offset);
+		}
+	}
+
+	free(buf);
+	ufs_free_block_list(block_list);
+
+	return ret;
+}
+
+// ask about a regular file, then read it, on the walking thread
+static int stream_one(struct stream_walk *state, const char *path,
+    const ufs_dinode *found)
+{
+	const ufs_sink *sink = state->sink;
+	ufs_dinode dinode;
+	int ret;
+
+	if (sink->file) {
+		ret = sink->file(sink->arg, path, found);
+		if (ret != STREAM_CONTINUE)
+			return ret;
+	}
+
+	dinode = *found;
+	ret = ufs_stream_file(state->device, state->fs, &dinode, sink);
+	if (ret < 0)
+		state->error = -1;
+	if (sink->done)
+		sink->done(sink->arg, path, ret < 0 ? -1 : 0);
+
+	return ret;
+}
+
+static int stream_entry(void *arg, walk_event event, walk_entry *entry)
+{
+	struct stream_walk *state = arg;
+
+	// the type in the entry says whether its inode is wanted at all
+	if (event == WALK_NAME)
+		return entry->type == DT_DIR || entry->type == DT_REG ||
+		    entry->type == DT_UNKNOWN ? WALK_CONTINUE : WALK_SKIP;
+	if (event != WALK_ENTRY || (entry->dinode->mode & IFMT) != IFREG)
+		return WALK_CONTINUE;
+
+	return stream_one(state, entry->path, entry->dinode) ==
+	    STREAM_STOP ? WALK_STOP : WALK_CONTINUE;
+}
+
+int ufs_stream_tree(disk_device *device, struct fs *fs, char *path,
+    const ufs_sink *sink)
+{
+	struct stream_walk state;
+	ufs_dinode dinode;
+	ufs_inop ino;
+	int64_t t;
+	int ret;
+
+	memset(&state, 0, sizeof(state));
+	state.device = device;
+	state.fs = fs;
+	state.sink = sink;
+
+	t = stats_begin();
+	ino = ufs_lookup_path(device, fs, path, 1, ROOTINO);
+	stats_end(STATS_LOOKUP, t);
+	if (!ino || ufs_read_inode(device, fs, ino, &dinode))
+		return -1;
+
+	switch (dinode.mode & IFMT) {
+		case IFREG:
+			stream_one(&state, path, &dinode);
+			break;
+		case IFDIR:
+			ret = ufs_walk(device, fs, ino, &dinode, path, NULL,
+			    NULL, stream_entry, &state);
+			if (ret < 0)
+				state.error = -1;
+			break;
+	}
+
+	return state.error;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <stdint.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+
+// file contents handed to callbacks as they're read, for callers that
+// want the bytes (scanners, indexers) and not a copy on disk. buffers
+// are lent, not copied: data gets the buffer the device read into, or
+// for holes, which are never read, a shared buffer of zeros. either is
+// only good until data returns.
+
+// what the callbacks return
+#define STREAM_CONTINUE	0
+#define STREAM_SKIP	1		/* pass over the rest of this file */
+#define STREAM_STOP	2		/* and every file after it */
+
+typedef struct _ufs_sink_ {
+	// a regular file ufs_stream_tree found, before any of it is read.
+	// may be NULL, to read every file.
+	int (*file)(void *arg, const char *path, const ufs_dinode *dinode);
+	// the file's next len bytes, which start at offset
+	int (*data)(void *arg, const char *buf, int64_t len, int64_t offset);
+	// ufs_stream_tree is done with a file it read: error is 0, or -1 if
+	// it couldn't all be read. may be NULL.
+	void (*done)(void *arg, const char *path, int error);
+	void *arg;
+} ufs_sink;
+
+// a file's contents to sink->data, in order, in reads as long as the
+// copy uses. returns -1 if it couldn't all be read, else STREAM_CONTINUE
+// or what sink->data returned to end it early.
+extern int ufs_stream_file(disk_device *device, struct fs *fs,
+    ufs_dinode *dinode, const ufs_sink *sink);
+
+// every regular file under path, or path itself, through sink->file,
+// sink->data and sink->done, walking the tree as ufs_walk does. files
+// are read on the walking thread, as they're found. -1 if path doesn't
+// exist or a file couldn't be read.
+extern int ufs_stream_tree(disk_device *device, struct fs *fs, char *path,
+    const ufs_sink *sink);
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "summary.h"
+#include "stats.h"
+
+// buckets of the cylinder group fill histogram
+#define FILL_BUCKETS 10
+
+// fragments in cylinder group c, the last one may be short
+static int64_t cg_frags(struct fs *fs, int64_t size, int c)
+{
+	int64_t frags = size - cgbase(fs, c);
+
+	return frags < fs->fs_fpg ? frags : fs->fs_fpg;
+}
+
+static double percent(int64_t part, int64_t whole)
+{
+	return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+int print_fs_summary(disk_device *device, struct fs *fs, int cgs,
+    FILE *out)
+{
+	struct csum *csp;
+	struct csum_total total;
+	struct cg *cgp;
+	int64_t size, dsize, csaddr, used, nfree, frags, ninodes;
+	int64_t fill[FILL_BUCKETS], frsum[MAXFRAG];
+	int64_t t, start;
+	int c, i, bad;
+
+	start = stats_now();
+
+	if (ufs_old_fields(fs)) {
+		size = fs->fs_old_size;
+		dsize = fs->fs_old_dsize;
+		csaddr = fs->fs_old_csaddr;
+		total.cs_ndir = fs->fs_old_cstotal.cs_ndir;
+		total.cs_nbfree = fs->fs_old_cstotal.cs_nbfree;
+		total.cs_nifree = fs->fs_old_cstotal.cs_nifree;
+		total.cs_nffree = fs->fs_old_cstotal.cs_nffree;
+	} else {
+		size = fs->fs_size;
+		dsize = fs->fs_dsize;
+		csaddr = fs->fs_csaddr;
+		total = fs->fs_cstotal;
+	}
+
+	// one read for every group's counts
+	csp = malloc(fs->fs_cssize);
+	t = stats_begin();
+	if (seek_device(device, ufs_fragtobytes(fs, csaddr), SEEK_SET) ||
+	    read_device(device, (char *)csp, fs->fs_cssize)) {
+		stats_end(STATS_READ, t);
+		fprintf(stderr, "ufs2tool: cannot read cylinder group "
+		    "summary\n");
+		free(csp);
+		return -1;
+	}
+	stats_end(STATS_READ, t);
+
+	nfree = blkstofrags(fs, total.cs_nbfree) + total.cs_nffree;
+	used = dsize - nfree;
+	ninodes = (int64_t)fs->fs_ncg * fs->fs_ipg;
+
+	fprintf(out, "filesystem  UFS%d, %d byte blocks, %d byte fragments\n",
+	    fs->fs_magic == FS_UFS2_MAGIC ? 2 : 1, fs->fs_bsize,
+	    fs->fs_fsize);
+	fprintf(out, "size        %I64d KB, %I64d KB for data\n",
+	    ufs_fragtobytes(fs, size) >> 10, ufs_fragtobytes(fs, dsize) >> 10);
+	fprintf(out, "used        %I64d KB (%.1f%%)\n",
+	    ufs_fragtobytes(fs, used) >> 10, percent(used, dsize));
+	fprintf(out, "free        %I64d KB: %I64d blocks, %I64d fragments, "
+	    "%d%% reserved\n", ufs_fragtobytes(fs, nfree) >> 10,
+	    total.cs_nbfree, total.cs_nffree, fs->fs_minfree);
+	fprintf(out, "inodes      %I64d used, %I64d free (%.1f%% used)\n",
+	    ninodes - total.cs_nifree, total.cs_nifree,
+	    percent(ninodes - total.cs_nifree, ninodes));
+	fprintf(out, "directories %I64d\n", total.cs_ndir);
+	fprintf(out, "groups      %d of %d MB\n", fs->fs_ncg,
+	    (int)(ufs_fragtobytes(fs, fs->fs_fpg) >> 20));
+	if (fs->fs_flags & FS_UNCLEAN)
+		fprintf(out, "            (not clean, counts may be stale)\n");
+
+	memset(fill, 0, sizeof(fill));
+	memset(frsum, 0, sizeof(frsum));
+	cgp = cgs ? malloc(fs->fs_cgsize) : NULL;
+	bad = 0;
+
+	if (cgs) {
+		fprintf(out, "\ngroup   used%%  free blocks  free frags  "
+		    "free inodes   dirs  free runs of 1..%d frags\n",
+		    fs->fs_frag - 1);
+	}
+
+	for (c = 0; c < fs->fs_ncg; ++c) {
+		frags = cg_frags(fs, size, c);
+		used = frags - blkstofrags(fs, csp[c].cs_nbfree) -
+		    csp[c].cs_nffree;
+		i = (int)(percent(used, frags) * FILL_BUCKETS / 100);
+		fill[i < FILL_BUCKETS ? (i < 0 ? 0 : i) : FILL_BUCKETS - 1]++;
+
+		if (!cgs)
+			continue;
+
+		fprintf(out, "%-7d %5.1f %12d %11d %12d %6d ", c,
+		    percent(used, frags), csp[c].cs_nbfree, csp[c].cs_nffree,
+		    csp[c].cs_nifree, csp[c].cs_ndir);
+
+		t = stats_begin();
+		if (seek_device(device, ufs_fragtobytes(fs, cgtod(fs, c)),
+		    SEEK_SET) || read_device(device, (char *)cgp,
+		    fs->fs_cgsize) || !cg_chkmagic(cgp)) {
+			stats_end(STATS_READ, t);
+			fprintf(out, " (bad header)\n");
+			bad++;
+			continue;
+		}
+		stats_end(STATS_READ, t);
+
+		for (i = 1; i < fs->fs_frag; ++i) {
+			fprintf(out, " %d", cgp->cg_frsum[i]);
+			frsum[i] += cgp->cg_frsum[i];
+		}
+		fprintf(out, "\n");
+	}
+
+	fprintf(out, "\ngroup fill  groups\n");
+	for (i = 0; i < FILL_BUCKETS; ++i) {
+		fprintf(out, "%3d-%3d%%   %I64d\n", i * 100 / FILL_BUCKETS,
+		    (i + 1) * 100 / FILL_BUCKETS, fill[i]);
+	}
+
+	if (cgs) {
+		fprintf(out, "\nfree run    count\n");
+		for (i = 1; i < fs->fs_frag; ++i)
+			fprintf(out, "%2d frags    %I64d\n", i, frsum[i]);
+		if (bad)
+			fprintf(out, "(%d groups had a bad header)\n", bad);
+	}
+
+	fprintf(out, "\nread in %.1f ms\n", (stats_now() - start) / 1e6);
+
+	free(cgp);
+	free(csp);
+
+	return bad ? -1 : 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "trace.h"
+
+#if defined(UFS_TRACE_ETW)
+
+// {3cc7cb95-45e3-5063-1ea4-61a450681d9b}, the name hash of "ufs2tools",
+// so tools can also enable it as *ufs2tools
+TRACELOGGING_DEFINE_PROVIDER(ufs_trace_provider, "ufs2tools",
+    (0x3cc7cb95, 0x45e3, 0x5063, 0x1e, 0xa4, 0x61, 0xa4, 0x50, 0x68, 0x1d,
+    0x9b));
+
+void trace_register(void)
+{
+	TraceLoggingRegister(ufs_trace_provider);
+}
+
+void trace_unregister(void)
+{
+	TraceLoggingUnregister(ufs_trace_provider);
+}
+
+#else
+
+void trace_register(void)
+{
+}
+
+void trace_unregister(void)
+{
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+// static probes on the read path. with msvc they are TraceLogging events
+// of the "ufs2tools" ETW provider, otherwise nothing. an event nobody
+// listens to costs one test of a flag. define UFS_NO_TRACE to build
+// without them.
+//
+//   seek-entry(offset, whence)		seek_device()
+//   seek-return(position, ret)
+//   read-entry(position, length)	read_device()
+//   read-return(position, length, ret)
+//   inode(ino)				inode fetched
+//   lookup(component, ino)		path component looked up, 0 if none
+//   blockmap-entry(size, nblocks)	block list construction
+//   blockmap-return(nblocks)
+//   file-start(path, size)		file copy in read_file()
+//   file-done(path, bytes, ret)
+//   slice-table(start, offset)		read_slice_table()
+//   slice-table-done(start, entries)
+
+#if defined(UFS_NO_TRACE)
+#define UFS_TRACE_NONE
+#elif defined(_MSC_VER)
+#define UFS_TRACE_ETW
+#else
+#define UFS_TRACE_NONE
+#endif
+
+#if defined(UFS_TRACE_ETW)
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(ufs_trace_provider);
+
+#define TRACE_SEEK_ENTRY(offset, whence)				\
+	TraceLoggingWrite(ufs_trace_provider, "seek-entry",		\
+	    TraceLoggingInt64(offset, "offset"),			\
+	    TraceLoggingInt32(whence, "whence"))
+#define TRACE_SEEK_RETURN(position, ret)				\
+	TraceLoggingWrite(ufs_trace_provider, "seek-return",		\
+	    TraceLoggingInt64(position, "position"),			\
+	    TraceLoggingInt32(ret, "ret"))
+#define TRACE_READ_ENTRY(position, length)				\
+	TraceLoggingWrite(ufs_trace_provider, "read-entry",		\
+	    TraceLoggingInt64(position, "position"),			\
+	    TraceLoggingInt64(length, "length"))
+#define TRACE_READ_RETURN(position, length, ret)			\
+	TraceLoggingWrite(ufs_trace_provider, "read-return",		\
+	    TraceLoggingInt64(position, "position"),			\
+	    TraceLoggingInt64(length, "length"),			\
+	    TraceLoggingInt32(ret, "ret"))
+#define TRACE_INODE(ino)						\
+	TraceLoggingWrite(ufs_trace_provider, "inode",			\
+	    TraceLoggingInt64(ino, "ino"))
+#define TRACE_LOOKUP(component, ino)					\
+	TraceLoggingWrite(ufs_trace_provider, "lookup",			\
+	    TraceLoggingString(component, "component"),		\
+	    TraceLoggingInt64(ino, "ino"))
+#define TRACE_BLOCKMAP_ENTRY(size, nblocks)				\
+	TraceLoggingWrite(ufs_trace_provider, "blockmap-entry",	\
+	    TraceLoggingUInt64(size, "size"),				\
+	    TraceLoggingInt64(nblocks, "nblocks"))
+#define TRACE_BLOCKMAP_RETURN(nblocks)					\
+	TraceLoggingWrite(ufs_trace_provider, "blockmap-return",	\
+	    TraceLoggingInt64(nblocks, "nblocks"))
+#define TRACE_FILE_START(path, size)					\
+	TraceLoggingWrite(ufs_trace_provider, "file-start",		\
+	    TraceLoggingString(path, "path"),				\
+	    TraceLoggingInt64(size, "size"))
+#define TRACE_FILE_DONE(path, bytes, ret)				\
+	TraceLoggingWrite(ufs_trace_provider, "file-done",		\
+	    TraceLoggingString(path, "path"),				\
+	    TraceLoggingInt64(bytes, "bytes"),				\
+	    TraceLoggingInt32(ret, "ret"))
+#define TRACE_SLICE_TABLE(start, offset)				\
+	TraceLoggingWrite(ufs_trace_provider, "slice-table",		\
+	    TraceLoggingUInt32(start, "start"),			\
+	    TraceLoggingUInt32(offset, "offset"))
+#define TRACE_SLICE_TABLE_DONE(start, entries)				\
+	TraceLoggingWrite(ufs_trace_provider, "slice-table-done",	\
+	    TraceLoggingUInt32(start, "start"),			\
+	    TraceLoggingInt32(entries, "entries"))
+
+#else
+
+#define TRACE_SEEK_ENTRY(offset, whence)		((void)0)
+#define TRACE_SEEK_RETURN(position, ret)		((void)0)
+#define TRACE_READ_ENTRY(position, length)		((void)0)
+#define TRACE_READ_RETURN(position, length, ret)	((void)0)
+#define TRACE_INODE(ino)				((void)0)
+#define TRACE_LOOKUP(component, ino)			((void)0)
+#define TRACE_BLOCKMAP_ENTRY(size, nblocks)		((void)0)
+#define TRACE_BLOCKMAP_RETURN(nblocks)			((void)0)
+#define TRACE_FILE_START(path, size)			((void)0)
+#define TRACE_FILE_DONE(path, bytes, ret)		((void)0)
+#define TRACE_SLICE_TABLE(start, offset)		((void)0)
+#define TRACE_SLICE_TABLE_DONE(start, entries)		((void)0)
+
+#endif
+
+// register the ETW provider, a no-op without one
+extern void trace_register(void);
+extern void trace_unregister(void);
+
+#endif
@@ -1,76 +1,125 @@
-/*
- * Copyright (c) 2004 Nehal Mistry
- * All rights reserved.
- * 
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission.
- * 
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
- * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
- * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
- * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
- * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#ifndef _UFS_H_
-#define _UFS_H_
-
-#include "ufs/dinode.h"
-#include "ffs/fs.h"
-#include "ufs/dir.h"
-
-typedef union _ufs_block_list_ {
-	int32_t *ufs1;
-	int64_t *ufs2;
-} ufs_block_list;
-
-typedef struct _ufs_dinode_ {
-	uint16_t mode;
-	uint64_t size;
-	ufs_time_t atime;
-	ufs_time_t mtime;
-
-	union {
-		struct ufs1_dinode ufs1;
-		struct ufs2_dinode ufs2;
-	} din;
-} ufs_dinode;
-
-typedef int64_t ufs_inop;
-
-extern ufs_block_list* (*ufs_get_block_list)(HANDLE device, struct fs *fs,
-    ufs_dinode *ufs_dinode);
-
-extern void (*ufs_free_block_list)(ufs_block_list *list);
-
-extern int (*ufs_read_data)(HANDLE device, struct fs *fs,
-    const ufs_dinode *inode, ufs_block_list *block_list,
-    unsigned char *buf, ufs_inop start_block, ufs_inop num_blocks);
-
-extern int (*ufs_read_inode)(HANDLE device, struct fs *fs, ufs_inop ino,
-    ufs_dinode *inode);
-
-extern uint16_t (*ufs_read_direntry)(void *buf, struct direct *direct);
-
-extern ufs_inop (*ufs_follow_symlinks)(HANDLE device, struct fs *fs,
-    ufs_inop root_ino, ufs_inop ino);
-
-extern ufs_inop (*ufs_lookup_path)(HANDLE device, struct fs *fs, char *path,
-    int follow, ufs_inop root_ino);
-
-struct fs* ufs_init(HANDLE device);
-
-#endif
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _UFS_H_
+#define _UFS_H_
+
+#include "disk/diskio.h"
+
+// the parts of sys/param.h that fs.h and its users expect
+#ifndef NBBY
+#define NBBY		8		/* bits per byte */
+#endif
+#ifndef DEV_BSIZE
+#define DEV_BSIZE	512
+#endif
+#define howmany(x, y)	(((x) + ((y) - 1)) / (y))
+#define roundup(x, y)	((((x) + ((y) - 1)) / (y)) * (y))
+#define setbit(a, i)	(((uint8_t *)(a))[(i) / NBBY] |= 1 << ((i) % NBBY))
+#define clrbit(a, i)	(((uint8_t *)(a))[(i) / NBBY] &= ~(1 << ((i) % NBBY)))
+#define isset(a, i)	(((const uint8_t *)(a))[(i) / NBBY] & (1 << ((i) % NBBY)))
+#define isclr(a, i)	(!isset(a, i))
+
+#include "ufs/dinode.h"
+#include "ffs/fs.h"
+#include "ufs/dir.h"
+
+typedef union _ufs_block_list_ {
+	int32_t *ufs1;
+	int64_t *ufs2;
+} ufs_block_list;
+
+typedef struct _ufs_dinode_ {
+	uint16_t mode;
+	uint64_t size;
+	ufs_time_t atime;
+	ufs_time_t mtime;
+
+	union {
+		struct ufs1_dinode ufs1;
+		struct ufs2_dinode ufs2;
+	} din;
+} ufs_dinode;
+
+typedef int64_t ufs_inop;
+
+// fragment number to byte offset. fs.h's lfragtosize() goes through off_t,
+// which is only 32 bits with msvc.
+#define ufs_fragtobytes(fs, frag) \
+	(((int64_t)(frag)) << (fs)->fs_fshift)
+
+extern ufs_block_list* ufs_get_block_list(disk_device *device, struct fs *fs,
+    ufs_dinode *ufs_dinode);
+
+extern void ufs_free_block_list(ufs_block_list *list);
+
+extern int ufs_read_data(disk_device *device, struct fs *fs,
+    const ufs_dinode *inode, ufs_block_list *block_list,
+    unsigned char *buf, ufs_inop start_block, ufs_inop num_blocks);
+
+extern int ufs_read_inode(disk_device *device, struct fs *fs, ufs_inop ino,
+    ufs_dinode *inode);
+
+// inodes read together sorted by their place on disk, results in the
+// order of inos. bad or unreadable ones are zeroed and make it return -1.
+extern int ufs_read_inodes(disk_device *device, struct fs *fs,
+    const ufs_inop *inos, int64_t n, ufs_dinode *out);
+
+// the first fragment of logical block i in a block list, 0 for a hole
+#define ufs_block_at(fs, list, i) ((fs)->fs_magic == FS_UFS1_MAGIC ? \
+	(int64_t)(list)->ufs1[i] : (list)->ufs2[i])
+
+// the DT_ type of an inode's mode, as directory entries give it
+#define ufs_mode_type(mode)	(((mode) & IFMT) >> 12)
+
+// size of an on-disk inode, and one read from disk made into a dinode
+extern int ufs_dinode_size(struct fs *fs);
+extern void ufs_decode_inode(struct fs *fs, const void *raw,
+    ufs_dinode *dinode);
+
+// a UFS1 superblock not yet updated by a newer kernel keeps its sizes
+// and totals in the old fields
+extern int ufs_old_fields(struct fs *fs);
+
+extern uint16_t ufs_read_direntry(void *buf, struct direct *direct);
+
+extern ufs_inop ufs_follow_symlinks(disk_device *device, struct fs *fs,
+    ufs_inop root_ino, ufs_inop ino);
+
+extern ufs_inop ufs_lookup_path(disk_device *device, struct fs *fs, char *path,
+    int follow, ufs_inop root_ino);
+
+// many paths at once, as ufs_lookup_path would find each. directories
+// the paths share are read once, with one pass over their entries for
+// all the names wanted in them. inos gets the inode of each path in
+// order, 0 if not found, and it returns -1 if any wasn't.
+extern int ufs_lookup_paths(disk_device *device, struct fs *fs, char **paths,
+    int64_t npaths, int follow, ufs_inop root_ino, ufs_inop *inos);
+
+struct fs* ufs_init(disk_device *device);
+
+#endif
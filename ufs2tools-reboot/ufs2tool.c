@@ -1,461 +1,546 @@
-/*
- * Copyright (c) 2004 Nehal Mistry
- * All rights reserved.
- * 
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission.
- * 
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
- * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
- * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
- * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
- * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include <windows.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <stdint.h>
-#include <string.h>
-#include <time.h>
-#include <io.h>
-#include <sys/stat.h>
-#include <sys/utime.h>
-
-#include "disk/diskio.h"
-#include "ufs.h"
-#include "ufs2.h"
-#include "misc.h"
-
-// 512 is optimum for speed
-#define COPY_FBLOCKS 512
-
-typedef enum {
-	command_none,
-	command_list,
-	command_get
-} command_t;
-
-// sorting function for directory listing
-int sort_direct(const void *first, const void *second)
-{
-	const struct direct *a = first;
-	const struct direct *b = second;
-
-	if (!strcmp(a->d_name, ".")) {
-		return -1;
-	} else if (!strcmp(b->d_name, ".")) {
-		return 1;
-	} else if (!strcmp(a->d_name, "..")) {
-		return -1;
-	} else if (!strcmp(b->d_name, "..")) {
-		return 1;
-	} else {
-		return strcmp(a->d_name, b->d_name);
-	}
-}
-
-int print_dir_listing(HANDLE device, struct fs *fs, char *path)
-{
-	int i, ret, numentries;
-	ufs_inop ino;
-	ufs_block_list *block_list;
-	char *tmp, *buf;
-	char timestring[64];
-	char sizestring[32];
-	char symlinkstring[280];
-	struct direct directtmp;
-	struct direct *direct;
-	ufs_dinode dinode;
-	struct tm *tm;
-
-	ino = ufs_lookup_path(device, fs, path, 1, ROOTINO);
-	if (!ino) {
-		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", path);
-		return -1;
-	}
-
-	ufs_read_inode(device, fs, ino, &dinode);
-
-	if (!(dinode.mode & IFDIR)) {
-		fprintf(stderr, "ufs2tool: \"%s\" is not a directory\n", path);
-		return -1;
-	}
-
-	buf = malloc(dinode.size + sizeof(struct direct));
-	block_list = ufs_get_block_list(device, fs, &dinode);
-	ufs_read_data(device, fs, &dinode, block_list, buf, 0, 0);
-	ufs_free_block_list(block_list);
-
-	// this gets number of dir entries
-	tmp = buf;
-	for (numentries = 0; tmp - buf < dinode.size; ++numentries) {
-		ret = ufs_read_direntry(tmp, &directtmp);
-		tmp += ret;
-	}
-
-	direct = malloc(numentries * sizeof(*direct));
-
-	tmp = buf;
-	for (i = 0; i < numentries; ++i) {
-		ret = ufs_read_direntry(tmp, &direct[i]);
-		tmp += ret;
-	}
-	free(buf);
-
-	qsort(direct, numentries, sizeof(*direct), sort_direct);
-
-	for (i = 0; i < numentries; ++i) {
-		ufs_read_inode(device, fs, direct[i].d_ino, &dinode);
-		tm = localtime((const time_t*)(&dinode.mtime));
-
-		if ((dinode.mode & IFMT) == IFDIR) {
-			sprintf(sizestring, "<DIR>");
-		} else {
-			sprintf(sizestring, "%I64u", dinode.size);
-		}
-
-		if ((dinode.mode & IFMT) == IFLNK) {
-			char tmpname[MAX_PATH];
-
-			block_list = ufs_get_block_list(device, fs, &dinode);
-			ufs_read_data(device, fs, &dinode, block_list, tmpname, 0, 0);
-			ufs_free_block_list(block_list);
-			tmpname[dinode.size] = '\0';
-
-			sprintf(symlinkstring, " -> %s", tmpname);
-		} else {
-			symlinkstring[0] = '\0';
-		}
-
-		strftime(timestring, 64, "%b %d,%Y  %H:%M:%S", tm);
-		printf("%s %10s %s%s\n", timestring, sizestring,
-		    direct[i].d_name, symlinkstring);
-	}
-
-	free(direct);
-
-	return 0;
-}
-
-// NOTE: this function is recursive for recursive copying
-int read_file(HANDLE device, struct fs *fs, ufs_inop root_ino,
-	ufs_inop ino, char *srcpath, char *destpath)
-{
-	int i;
-	int64_t totalsize, readsize, read;
-	ufs_block_list *block_list;
-	char *buf, *dir, *tmp;
-	char newdest[MAX_PATH];
-	int using_con;
-	FILE *of;
-	ufs_dinode dinode;
-	struct stat stat_buf;
-	struct utimbuf filetime;
-
-	ufs_inop symlink_ino;
-
-	using_con = (destpath && (!stricmp(destpath, "CON") ||
-	    !(strnicmp(destpath, "CON.", 4))));
-
-	if (!root_ino || !ino) {
-		fprintf(stderr, "ufs2tool: \"%s\" does not exist\n", srcpath);
-		return -1;
-	}
-
-	// this checks for a recursive symlink loop
-	ufs_read_inode(device, fs, ino, &dinode);
-	if ((dinode.mode & IFMT) == IFLNK) {
-		ino = ufs_lookup_path(device, fs, srcpath, 1, ROOTINO);
-		dir = dirname(srcpath);
-		symlink_ino = ufs_lookup_path(device, fs, dir, 1, ROOTINO);
-
-		for (;; symlink_ino = ufs_lookup_path(device, fs, "..", 0,
-		    symlink_ino)) {
-			if (symlink_ino == ino) {
-				fprintf(stderr, "(\"%s\" is a recursive symlink loop)\n", srcpath);
-				free(dir);
-				return -1;
-			}
-
-			if (symlink_ino == ROOTINO)
-				break;
-		}
-
-		free(dir);
-	}
-
-	if (destpath == NULL) {
-		char *base = basename(srcpath);
-		strcpy(newdest, "./");
-		strcat(newdest, base);
-		free(base);
-	} else {
-		while (destpath[strlen(destpath) - 1] == '/')
-			destpath[strlen(destpath) - 1] = '\0';
-
-		if (!stat(destpath, &stat_buf) && (stat_buf.st_mode & S_IFDIR)) {
-			char *base;
-			strcpy(newdest, destpath);
-			strcat(newdest, "/");
-			base = basename(srcpath);
-			strcat(newdest, base);
-			free(base);
-		} else {
-			strcpy(newdest, destpath);
-		}
-	}
-
-	ufs_read_inode(device, fs, ino, &dinode);
-
-	block_list = ufs_get_block_list(device, fs, &dinode);
-	totalsize = dinode.size;
-
-	if (dinode.mode & IFDIR) {
-		char *dirdest, *tmp;
-		char nextsrc[256];
-		char nextdest[MAX_PATH];
-		int ret;
-		struct direct directtmp;
-		struct stat sb;
-
-		if (using_con) {
-			fprintf(stderr, "ufs2tool: cannot copy directory to console\n");
-			ufs_free_block_list(block_list);
-			return -1;
-		}
-
-		if (!stat(newdest, &sb)) {
-			if ((sb.st_mode & S_IFMT) != S_IFDIR)
-				return -1;
-			dirdest = strdup(newdest);
-		} else {
-			// check for invalid filename
-			if (mkdir(newdest) == -1) {
-				dirdest = valid_filename(newdest, 0);
-				if (mkdir(dirdest) == -1) {
-					free(dirdest);
-					return -1;
-				}
-			} else {
-				dirdest = strdup(newdest);
-			}
-		}
-
-		buf = malloc(dinode.size + sizeof(struct direct));
-		ufs_read_data(device, fs, &dinode, block_list, buf, 0, 0);
-
-		tmp = buf;
-		for (i = 0;; ++i) {
-			ret = ufs_read_direntry(tmp, &directtmp);
-			if (tmp - buf >= dinode.size || !ret)
-				break;
-			tmp += ret;
-			if (!strcmp(directtmp.d_name, ".") || !strcmp(directtmp.d_name, ".."))
-				continue;
-
-			strcpy(nextsrc, srcpath);
-			if (srcpath[strlen(srcpath) - 1] != '/')
-				strcat(nextsrc, "/");
-			strcat(nextsrc, directtmp.d_name);
-
-			strcpy(nextdest, dirdest);
-			strcat(nextdest, "/");
-			strcat(nextdest, directtmp.d_name);
-
-			read_file(device, fs, ino, directtmp.d_ino, nextsrc, nextdest);
-		}
-
-		ufs_free_block_list(block_list);
-		free(buf);
-
-		return 0;
-	}
-
-	readsize = 0;
-	read = 0;
-
-	fprintf(stderr, "retrieving \"%s\"\n", srcpath);
-
-	tmp = valid_filename(newdest, using_con);
-	strcpy(newdest, tmp);
-	free(tmp);
-
-	of = fopen(newdest, "wb");
-	if (!of) {
-		fprintf(stderr, "ufs2tool: cannot open file %s\n", newdest);
-		return -1;
-	}
-
-	buf = malloc(COPY_FBLOCKS * fs->fs_fsize);
-
-	for (i = 0; readsize < totalsize; i += read / fs->fs_fsize) {
-		if (totalsize - readsize < fs->fs_fsize * COPY_FBLOCKS) {
-			read = (totalsize - readsize) / fs->fs_fsize;
-			read = ufs_read_data(device, fs, &dinode, block_list,
-			    buf, i, read ? read : 1);
-			if (readsize + read > totalsize) {
-				read = totalsize - readsize; // EOF
-			}
-			fwrite(buf, 1, read, of);
-			readsize += read;
-		} else {
-			// read COPY_FBLOCKS blocks
-			read = COPY_FBLOCKS;
-			read = ufs_read_data(device, fs, &dinode, block_list,
-			    buf, i, read);
-			readsize += read;
-			fwrite(buf, 1, read, of);
-		}
-		fprintf(stderr, "%I64d of %I64d bytes copied (%lld%%)\r", readsize, totalsize, readsize * 100 / totalsize);
-	}
-
-	if (!totalsize)
-		fprintf(stderr, "(empty file)");
-
-	fprintf(stderr, "\n");
-
-	fclose(of);
-	filetime.actime = dinode.atime;
-	filetime.modtime = dinode.mtime;
-	utime(newdest, &filetime);
-
-	free(buf);
-	ufs_free_block_list(block_list);
-
-	return 0;
-}
-
-void usage()
-{
-	fprintf(stderr, "%s\n\n%s\n\n%s\n%s\n%s\n",
-	"    ufs2tool",
-	"    usage: ufs2tool drive[/slice]/partition [-lg] srcpath [destpath]",
-	"    -l		list directory",
-	"    -g		get file to destpath (basename of srcpath if not specified)",
-	""
-	);
-	exit(-1);
-}
-
-int main(int argc, char **argv)
-{
-	HANDLE device;
-	int i, x, ret;
-	command_t command;
-	int drive, slice, partition;
-	ufs_inop ino;
-	char patha[MAX_PATH];
-	char pathb[MAX_PATH];
-	char *tmp;
-	struct fs *fs;
-
-	patha[0] = pathb[0] = '\0';
-
-	if (argc < 3)
-		usage();
-
-	drive = slice = partition = 0;
-
-        device = open_file_device(argv[1]);
-        if (device == INVALID_HANDLE_VALUE) {
-		tmp = argv[1];
-
-		drive = strtol(tmp, &tmp, 0);
-		if (tmp[0] != '/' && tmp[0] != '\0') {
-			usage();
-		}
-		++tmp;
-
-		x = strtol(tmp, &tmp, 0);
-		if (tmp[0] != '/' && tmp[0] != '\0')
-			usage();
-
-		if (tmp[0]) {
-			++tmp;
-			slice = x;
-			partition = strtol(tmp, &tmp, 0);
-		} else {
-			slice = 1;
-			partition = x;
-		}
-	}
-
-	command = command_none;
-
-        for (i = 2; i < argc; ++i) {
-                if (argv[i][0] == '-' && argv[i][2] == '\0') {
-                        switch(argv[i][1]) {
-				case 'g':
-					if (command != command_none)
-						usage();
-					command = command_get;
-					break;
-				case 'l':
-					if (command != command_none)
-						usage();
-					command = command_list;
-					break;
-                                case 'h':
-                                default:
-                                        usage();
-                                        break;
-                        }
-                } else if (!strcmp(argv[i], "--help")) {
-			usage();
-		} else {
-			if (!patha[0]) {
-				strcpy(patha, argv[i]);
-			} else {
-				strcpy(pathb, argv[i]);
-			}
-		}
-	}
-
-	if (device == INVALID_HANDLE_VALUE) {
-		device = open_partition_device(drive, slice, partition);
-		if (device == INVALID_HANDLE_VALUE) {
-			fprintf(stderr, "ufs2tool: could not open device\n");
-			exit(-1);
-		}
-	}
-
-	fs = ufs_init(device);
-
-	if (!fs) {
-		fprintf(stderr, "ufs2tool: UFS partition not found\n");
-		exit(-1);
-	}
-
-	switch (command) {
-		case command_get:
-			ino = ufs_lookup_path(device, fs, patha, 0, ROOTINO);
-			if (!pathb[0]) {
-				ret = read_file(device, fs, ROOTINO, ino, patha, NULL);
-			} else {
-				ret = read_file(device, fs, ROOTINO, ino, patha, pathb);
-			}
-			break;
-		case command_list:
-		case command_none:
-			ret = print_dir_listing(device, fs, patha);
-			break;
-	}
-
-	free(fs);
-
-	return 0;
-}
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "ufs2.h"
+#include "misc.h"
+#include "extract.h"
+#include "list.h"
+#include "extents.h"
+#include "find.h"
+#include "diff.h"
+#include "image.h"
+#include "freemap.h"
+#include "summary.h"
+#include "walk.h"
+#include "stats.h"
+#include "trace.h"
+
+typedef enum {
+	command_none,
+	command_list,
+	command_get,
+	command_all,
+	command_summary,
+	command_free,
+	command_extents,
+	command_find,
+	command_diff,
+	command_image
+} command_t;
+
+static const char *usage_lines[] = {
+	"    ufs2tool",
+	"",
+	"    usage: ufs2tool drive[/slice]/partition [-lg] srcpath [destpath]",
+	"           ufs2tool drive[/slice]/partition -g --files-from file [destpath]",
+	"           ufs2tool drive[/slice] -a [-j jobs] [destpath]",
+	"           ufs2tool drive[/slice]/partition -s|-f [--cgs]",
+	"           ufs2tool drive[/slice]/partition -e [--top n] srcpath",
+	"           ufs2tool drive[/slice]/partition -F [tests] [srcpath]",
+	"           ufs2tool drive[/slice]/partition -d image [srcpath]",
+	"           ufs2tool drive[/slice]/partition -i [image]",
+	"",
+	"    -l		list directory",
+	"    -g		get file to destpath (basename of srcpath if not specified)",
+	"    -a		get every UFS partition on the drive (or slice) to destpath",
+	"    --files-from file",
+	"		with -g, get every path listed in file, one a line, to",
+	"		destpath/path (destpath is the only path given)",
+	"    -j jobs	number of files to copy at once with -a, or threads",
+	"		reading cylinder groups with -f (default 4)",
+	"    -s		summarize space and inode use, from the superblock",
+	"    -f		analyze free space fragmentation, from the group maps",
+	"    --cgs	with -s or -f, also print a line per cylinder group",
+	"    -e		print the extents of a file, or the most fragmented",
+	"		files under a directory (--top n of them, default 20)",
+	"    -d image	print what was added (+), removed (-) or modified (M)",
+	"		under srcpath (or /) in image, a file system image",
+	"		taken after this one",
+	"    -i		copy the partition's allocated blocks to image, a sparse",
+	"		file, and print their sha256 (only the sha256 if no",
+	"		image is given)",
+	"    -F		find what matches every test under srcpath (or /)",
+	"    --name glob	tests for -F: name matches glob,",
+	"    --type t	type is f, d, l, p, c, b or s,",
+	"    --size [+-]n[kmg]",
+	"		size is more than, less than or exactly n bytes,",
+	"    --mtime [+-]n",
+	"		modified more than, less than or exactly n whole days",
+	"		ago, as find(1) counts,",
+	"    --uid n	owned by user n",
+	"    --prune glob",
+	"		with -F, don't go into directories matching glob",
+	"    --maxdepth n",
+	"		with -F, go no more than n levels below srcpath",
+	"    --print0	with -F, end each path with a NUL, for xargs -0",
+	"    --include glob",
+	"		with -g or -a, copy only files matching glob (may be",
+	"		given more than once; --size, --mtime and --uid apply",
+	"		too)",
+	"    --exclude glob",
+	"		with -g or -a, leave out anything matching glob (may",
+	"		be given more than once). a glob with a '/' is matched",
+	"		against the whole path, others against the name",
+	"    --update	with -g or -a, skip files already at the destination",
+	"		with the same size and modification time",
+	"    --checksum	with -g or -a, compare files of the same size with the",
+	"		destination, and write only where they differ",
+	"    --delete	with -g or -a, remove what copied directories no",
+	"		longer have from the destination",
+	"    --stats	print I/O and timing statistics at exit",
+	"    --stats-json file",
+	"		write statistics to file as json lines, every second",
+	"    --no-readahead	don't read files ahead of the copy",
+	"    --walk-io n	directory and inode reads in flight while copying",
+	"		a tree (default 256, 0 to read one at a time)",
+	"    --walk-memory mb",
+	"		buffers the walk may hold before it waits (default 64)",
+	"",
+	NULL
+};
+
+void usage()
+{
+	int i;
+
+	for (i = 0; usage_lines[i]; ++i)
+		fprintf(stderr, "%s\n", usage_lines[i]);
+	exit(-1);
+}
+
+// copy the paths listed in path, one a line, to destpath
+static int get_files_from(extract_ctx *ctx, const char *path,
+    char *destpath)
+{
+	char line[MAX_PATH];
+	char **paths;
+	int64_t n, max, i;
+	size_t len;
+	FILE *f;
+	int ret;
+
+	if ((f = fopen(path, "r")) == NULL) {
+		fprintf(stderr, "ufs2tool: cannot open %s\n", path);
+		return -1;
+	}
+
+	n = 0;
+	max = 1024;
+	paths = malloc(max * sizeof(*paths));
+	while (fgets(line, sizeof(line), f)) {
+		len = strlen(line);
+		while (len && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			line[--len] = '\0';
+		if (!len)
+			continue;
+		if (n == max) {
+			max *= 2;
+			paths = realloc(paths, max * sizeof(*paths));
+		}
+		paths[n++] = strdup(line);
+	}
+	fclose(f);
+
+	ret = extract_paths(ctx, paths, n, destpath);
+
+	for (i = 0; i < n; ++i)
+		free(paths[i]);
+	free(paths);
+
+	return ret;
+}
+
+static void finish_stats(int print)
+{
+	stats_stop_snapshots();
+	if (print)
+		stats_print(stderr);
+}
+
+int main(int argc, char **argv)
+{
+	disk_device *device;
+	int i, x, ret;
+	command_t command;
+	int drive, slice, partition, jobs;
+	ufs_inop ino;
+	char patha[MAX_PATH];
+	char pathb[MAX_PATH];
+	char *tmp;
+	struct fs *fs;
+	extract_ctx ctx;
+	int64_t t;
+	int print_stats, cgs, top, update;
+	find_query query;
+	extract_filter filter;
+	char *stats_path, *files_from, *other;
+	disk_device *other_device;
+	struct fs *other_fs;
+
+	patha[0] = pathb[0] = '\0';
+
+	if (argc < 3)
+		usage();
+
+	command = command_none;
+	jobs = 4;
+	print_stats = cgs = update = 0;
+	top = 20;
+	find_init(&query);
+	memset(&filter, 0, sizeof(filter));
+	filter.include = calloc(argc, sizeof(*filter.include));
+	filter.exclude = calloc(argc, sizeof(*filter.exclude));
+	stats_path = files_from = other = NULL;
+	readahead_enabled = 1;
+
+        for (i = 2; i < argc; ++i) {
+                if (argv[i][0] == '-' && argv[i][1] && argv[i][2] == '\0') {
+                        switch(argv[i][1]) {
+				case 'a':
+					if (command != command_none)
+						usage();
+					command = command_all;
+					break;
+				case 'g':
+					if (command != command_none)
+						usage();
+					command = command_get;
+					break;
+				case 'l':
+					if (command != command_none)
+						usage();
+					command = command_list;
+					break;
+				case 's':
+					if (command != command_none)
+						usage();
+					command = command_summary;
+					break;
+				case 'e':
+					if (command != command_none)
+						usage();
+					command = command_extents;
+					break;
+				case 'F':
+					if (command != command_none)
+						usage();
+					command = command_find;
+					break;
+				case 'f':
+					if (command != command_none)
+						usage();
+					command = command_free;
+					break;
+				case 'd':
+					if (command != command_none ||
+					    ++i == argc)
+						usage();
+					command = command_diff;
+					other = argv[i];
+					break;
+				case 'i':
+					if (command != command_none)
+						usage();
+					command = command_image;
+					break;
+				case 'j':
+					if (++i == argc)
+						usage();
+					jobs = strtol(argv[i], &tmp, 0);
+					if (tmp[0] != '\0' || jobs < 1)
+						usage();
+					break;
+                                case 'h':
+                                default:
+                                        usage();
+                                        break;
+                        }
+                } else if (!strcmp(argv[i], "--help")) {
+			usage();
+		} else if (!strcmp(argv[i], "--cgs")) {
+			cgs = 1;
+		} else if (!strcmp(argv[i], "--name")) {
+			if (++i == argc)
+				usage();
+			query.name = argv[i];
+		} else if (!strcmp(argv[i], "--files-from")) {
+			if (++i == argc)
+				usage();
+			files_from = argv[i];
+		} else if (!strcmp(argv[i], "--include")) {
+			if (++i == argc)
+				usage();
+			filter.include[filter.ninclude++] = argv[i];
+		} else if (!strcmp(argv[i], "--exclude")) {
+			if (++i == argc)
+				usage();
+			filter.exclude[filter.nexclude++] = argv[i];
+		} else if (!strcmp(argv[i], "--update")) {
+			update |= EXTRACT_UPDATE;
+		} else if (!strcmp(argv[i], "--checksum")) {
+			update |= EXTRACT_CHECKSUM;
+		} else if (!strcmp(argv[i], "--delete")) {
+			update |= EXTRACT_DELETE;
+		} else if (!strcmp(argv[i], "--prune")) {
+			if (++i == argc)
+				usage();
+			query.prune = argv[i];
+		} else if (!strcmp(argv[i], "--type")) {
+			if (++i == argc || find_type(&query, argv[i]))
+				usage();
+		} else if (!strcmp(argv[i], "--size")) {
+			if (++i == argc || find_size(&query, argv[i]))
+				usage();
+		} else if (!strcmp(argv[i], "--mtime")) {
+			if (++i == argc || find_mtime(&query, argv[i],
+			    time(NULL)))
+				usage();
+		} else if (!strcmp(argv[i], "--uid")) {
+			if (++i == argc)
+				usage();
+			query.uid = strtol(argv[i], &tmp, 0);
+			if (tmp[0] != '\0' || query.uid < 0)
+				usage();
+		} else if (!strcmp(argv[i], "--maxdepth")) {
+			if (++i == argc)
+				usage();
+			query.maxdepth = strtol(argv[i], &tmp, 0);
+			if (tmp[0] != '\0' || query.maxdepth < 1)
+				usage();
+		} else if (!strcmp(argv[i], "--print0")) {
+			query.print0 = 1;
+		} else if (!strcmp(argv[i], "--top")) {
+			if (++i == argc)
+				usage();
+			top = strtol(argv[i], &tmp, 0);
+			if (tmp[0] != '\0' || top < 1)
+				usage();
+		} else if (!strcmp(argv[i], "--no-readahead")) {
+			readahead_enabled = 0;
+		} else if (!strcmp(argv[i], "--walk-io")) {
+			if (++i == argc)
+				usage();
+			walk_default_limits.max_io = strtol(argv[i], &tmp, 0);
+			if (tmp[0] != '\0' || walk_default_limits.max_io < 0)
+				usage();
+		} else if (!strcmp(argv[i], "--walk-memory")) {
+			if (++i == argc)
+				usage();
+			walk_default_limits.max_memory =
+			    (int64_t)strtol(argv[i], &tmp, 0) << 20;
+			if (tmp[0] != '\0' || walk_default_limits.max_memory < 1)
+				usage();
+		} else if (!strcmp(argv[i], "--stats")) {
+			print_stats = 1;
+		} else if (!strcmp(argv[i], "--stats-json")) {
+			if (++i == argc)
+				usage();
+			stats_path = argv[i];
+		} else {
+			if (!patha[0]) {
+				strcpy(patha, argv[i]);
+			} else {
+				strcpy(pathb, argv[i]);
+			}
+		}
+	}
+
+	if (print_stats || stats_path)
+		stats_enable();
+	if (stats_path && stats_start_snapshots(stats_path, 1)) {
+		fprintf(stderr, "ufs2tool: cannot open %s\n", stats_path);
+		exit(-1);
+	}
+
+	trace_register();
+
+	drive = slice = partition = 0;
+
+	t = stats_begin();
+        device = open_file_device(argv[1]);
+        if (device == NULL) {
+		tmp = argv[1];
+
+		drive = strtol(tmp, &tmp, 0);
+		if (tmp[0] != '/' && tmp[0] != '\0')
+			usage();
+
+		if (command == command_all) {
+			// drive[/slice]
+			if (tmp[0]) {
+				++tmp;
+				slice = strtol(tmp, &tmp, 0);
+				if (tmp[0] != '\0')
+					usage();
+			}
+			device = open_device(drive);
+		} else {
+			if (tmp[0] == '\0')
+				usage();
+			++tmp;
+
+			x = strtol(tmp, &tmp, 0);
+			if (tmp[0] != '/' && tmp[0] != '\0')
+				usage();
+
+			if (tmp[0]) {
+				++tmp;
+				slice = x;
+				partition = strtol(tmp, &tmp, 0);
+			} else {
+				slice = 1;
+				partition = x;
+			}
+			device = open_partition_device(drive, slice, partition);
+		}
+
+		if (device == NULL) {
+			fprintf(stderr, "ufs2tool: could not open device\n");
+			exit(-1);
+		}
+	}
+
+	if (command == command_all) {
+		if (pathb[0])
+			usage();
+		stats_end(STATS_PROBE, t);
+		filter.tests = query;
+		ret = extract_partitions(device, slice, patha, jobs, &filter,
+		    update);
+		close_device(device);
+		finish_stats(print_stats);
+		trace_unregister();
+		return ret ? -1 : 0;
+	}
+
+	fs = ufs_init(device);
+	stats_end(STATS_PROBE, t);
+
+	if (!fs) {
+		fprintf(stderr, "ufs2tool: UFS partition not found\n");
+		exit(-1);
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.device = device;
+	ctx.fs = fs;
+	filter.tests = query;
+	ctx.filter = &filter;
+	ctx.update = update;
+
+	ret = 0;
+	switch (command) {
+		case command_get:
+			if (files_from) {
+				ret = get_files_from(&ctx, files_from, patha);
+			} else {
+				t = stats_begin();
+				ino = ufs_lookup_path(device, fs, patha, 0,
+				    ROOTINO);
+				stats_end(STATS_LOOKUP, t);
+				ret = read_file(&ctx, ROOTINO, ino, patha,
+				    pathb[0] ? pathb : NULL);
+			}
+			// what failed under a directory copied
+			if (ctx.errors)
+				ret = -1;
+			if (update)
+				fprintf(stderr, "%I64d files copied, %I64d "
+				    "unchanged, %I64d removed\n", ctx.files,
+				    ctx.unchanged, ctx.removed);
+			break;
+		case command_summary:
+			ret = print_fs_summary(device, fs, cgs, stdout);
+			break;
+		case command_free:
+			ret = print_free_space(device, fs, jobs, cgs, stdout);
+			break;
+		case command_extents:
+			ret = print_extents(device, fs, patha, top, stdout);
+			break;
+		case command_find:
+			if (!patha[0])
+				strcpy(patha, "/");
+			ret = ufs_find(device, fs, patha, &query, stdout);
+			break;
+		case command_diff:
+			if (!patha[0])
+				strcpy(patha, "/");
+			other_device = open_file_device(other);
+			if (other_device == NULL) {
+				fprintf(stderr, "ufs2tool: cannot open %s\n",
+				    other);
+				ret = -1;
+				break;
+			}
+			t = stats_begin();
+			other_fs = ufs_init(other_device);
+			stats_end(STATS_PROBE, t);
+			if (other_fs == NULL) {
+				fprintf(stderr, "ufs2tool: UFS partition not "
+				    "found in %s\n", other);
+				close_device(other_device);
+				ret = -1;
+				break;
+			}
+			ret = ufs_diff(device, fs, other_device, other_fs,
+			    patha, stdout);
+			free(other_fs);
+			close_device(other_device);
+			break;
+		case command_image:
+			ret = image_partition(device, fs, patha[0] ? patha :
+			    NULL, stdout);
+			break;
+		case command_list:
+		case command_none:
+			ret = print_dir_listing(device, fs, patha, stdout);
+			break;
+		case command_all:
+			// handled above, before the partition is mounted
+			break;
+	}
+
+	free(fs);
+	close_device(device);
+	finish_stats(print_stats);
+	trace_unregister();
+
+	return ret ? -1 : 0;
+}
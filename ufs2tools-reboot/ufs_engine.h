@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// the read engine for one on-disk format. this is not an ordinary
+// header, ufs1.c and ufs2.c each include it once with these defined:
+//
+//   UFSX(name)		name of a function for this format, eg. ufs1_##name
+//   UFSX_DIN		member of ufs_dinode.din and ufs_block_list
+//   ufsx_dinode	on-disk dinode struct
+//   ufsx_daddr_t	on-disk block pointer type
+//
+// so the pointer width and dinode size are constants, and the block
+// arithmetic is done with the superblock's shifts and masks.
+
+#if !defined(UFSX) || !defined(UFSX_DIN) || !defined(ufsx_dinode) || \
+    !defined(ufsx_daddr_t)
+#error "ufs_engine.h needs UFSX, UFSX_DIN, ufsx_dinode and ufsx_daddr_t"
+#endif
+
+// logical blocks in a file of size bytes
+#define ufsx_nblocks(fs, size) \
+	lblkno(fs, blkroundup(fs, (int64_t)(size)))
+
+// read_inodes reads inodes up to this many bytes apart together, and at
+// most this much at once
+#define INODE_GAP	(64 << 10)
+#define INODE_READ_MAX	(1 << 20)
+
+// collect the data block pointers below indirect block blkno, level 0
+// being a block of data block pointers. bufs holds one block per level.
+static int UFSX(indir_blocks)(disk_device *device, struct fs *fs,
+    ufsx_daddr_t blkno, int level, ufsx_daddr_t **bufs,
+    ufsx_daddr_t *list, int64_t *count, int64_t nblocks)
+{
+	ufsx_daddr_t *buf = bufs[level];
+	int i;
+
+	// a hole, everything below it is a hole too
+	if (blkno == 0) {
+		memset(buf, 0, fs->fs_bsize);
+	} else if (seek_device(device, ufs_fragtobytes(fs, blkno),
+	    SEEK_SET) || read_device(device, (char*)buf, fs->fs_bsize)) {
+		return -1;
+	}
+
+	for (i = 0; i < NINDIR(fs) && *count < nblocks; ++i) {
+		if (level == 0)
+			list[(*count)++] = buf[i];
+		else if (UFSX(indir_blocks)(device, fs, buf[i], level - 1,
+		    bufs, list, count, nblocks))
+			return -1;
+	}
+
+	return 0;
+}
+
+ufs_block_list* UFSX(get_block_list)(disk_device *device, struct fs *fs,
+    ufs_dinode *ufs_dinode)
+{
+	int i;
+	ufsx_daddr_t *block_list;
+	ufsx_daddr_t *bufs[NIADDR];
+	ufs_block_list *list;
+	struct ufsx_dinode *dinode;
+	int64_t count, nblocks;
+
+	dinode = &ufs_dinode->din.UFSX_DIN;
+	nblocks = ufsx_nblocks(fs, dinode->di_size);
+	STATS_ADD(blocks, nblocks);
+	TRACE_BLOCKMAP_ENTRY(dinode->di_size, nblocks);
+
+	block_list = malloc((nblocks + 1) * sizeof(*block_list));
+	list = malloc(sizeof(*list));
+	list->UFSX_DIN = block_list;
+
+	// direct blocks
+	count = 0;
+	for (i = 0; i < NDADDR && count < nblocks; ++i)
+		block_list[count++] = dinode->di_db[i];
+
+	// single, double and triple indirect blocks
+	if (count < nblocks) {
+		bufs[0] = malloc(NIADDR * fs->fs_bsize);
+		for (i = 1; i < NIADDR; ++i)
+			bufs[i] = bufs[0] + i * NINDIR(fs);
+
+		for (i = 0; i < NIADDR && count < nblocks; ++i) {
+			if (UFSX(indir_blocks)(device, fs, dinode->di_ib[i],
+			    i, bufs, block_list, &count, nblocks))
+				break;
+		}
+
+		free(bufs[0]);
+	}
+
+	// unreadable indirect blocks read back as holes
+	while (count < nblocks)
+		block_list[count++] = 0;
+
+	TRACE_BLOCKMAP_RETURN(nblocks);
+
+	return list;
+}
+
+// after a read of num_blocks fragments at start_block that ended before
+// logical block i, queue what a reader going on in order asks for next.
+// extents are cut where read_data's requests of the same size would be;
+// when the size changes, a request takes the extents it spans.
+static void UFSX(read_ahead)(disk_device *device, struct fs *fs,
+    const ufs_dinode *dinode, ufs_block_list *block_list,
+    ufs_inop start_block, ufs_inop num_blocks, int64_t i)
+{
+	const struct ufsx_dinode *di = &dinode->din.UFSX_DIN;
+	ufsx_daddr_t *bl = block_list->UFSX_DIN;
+	int64_t window, size, per, end, b, run, len;
+
+	if (device->ra == NULL && (device->ra = ra_create(device)) == NULL)
+		return;
+
+	size = ufs_fragtobytes(fs, num_blocks);
+	window = ra_access(device->ra, block_list, start_block, num_blocks,
+	    size);
+	if (!window)
+		return;
+
+	per = lblkno(fs, size);
+	if (per < 1)
+		per = 1;
+	end = i + lblkno(fs, window);
+	if (end > ufsx_nblocks(fs, di->di_size))
+		end = ufsx_nblocks(fs, di->di_size);
+
+	for (b = i; b < end; b += run) {
+		len = sblksize(fs, (int64_t)di->di_size, b);
+		for (run = 1; bl[b] != 0 && b + run < end &&
+		    (b + run - i) % per != 0 &&
+		    bl[b + run] == bl[b] + run * fs->fs_frag; ++run)
+			len += sblksize(fs, (int64_t)di->di_size, b + run);
+
+		if (bl[b] != 0)
+			ra_queue(device->ra, ufs_fragtobytes(fs, bl[b]), len,
+			    blkstofrags(fs, b + run));
+	}
+}
+
+int UFSX(read_data)(disk_device *device, struct fs *fs,
+    const ufs_dinode *dinode, ufs_block_list *block_list,
+    unsigned char *buf, ufs_inop start_block, ufs_inop num_blocks)
+{
+	const struct ufsx_dinode *di;
+	int64_t i, nblocks, total, read, len, offset, pos, run;
+	ufsx_daddr_t *bl;
+
+	di = &dinode->din.UFSX_DIN;
+	bl = block_list->UFSX_DIN;
+
+	if (!num_blocks) {
+		len = di->di_size;
+	} else {
+		len = ufs_fragtobytes(fs, num_blocks);
+	}
+
+	// a short symlink keeps its target in di_db. a file of only holes
+	// has no blocks either, and is read as zeros below.
+	if ((di->di_mode & IFMT) == IFLNK &&
+	    (int64_t)di->di_size < fs->fs_maxsymlinklen) {
+		memcpy(buf, di->di_db, di->di_size);
+		return di->di_size;
+	}
+
+	// find start position. only the last block can be short, so this
+	// doesn't need to walk the blocks before it.
+	pos = ufs_fragtobytes(fs, start_block);
+	i = lblkno(fs, pos);
+	offset = blkoff(fs, pos);
+	nblocks = ufsx_nblocks(fs, di->di_size);
+
+	for (total = 0; total < len && i < nblocks; i += run) {
+		read = sblksize(fs, (int64_t)di->di_size, i) - offset;
+
+		// blocks that follow each other on disk go in one request
+		for (run = 1; bl[i] != 0 && read + total < len &&
+		    i + run < nblocks &&
+		    bl[i + run] == bl[i] + run * fs->fs_frag; ++run)
+			read += sblksize(fs, (int64_t)di->di_size, i + run);
+
+		if (read + total > len)
+			read = len - total;
+
+		if (bl[i] == 0) {
+			memset(buf, 0, read);
+		} else if (seek_device(device, ufs_fragtobytes(fs, bl[i]) +
+		    offset, SEEK_SET) < 0 || read_device(device, buf, read) < 0) {
+			return -1;
+		}
+
+		offset = 0;
+		total += read;
+		buf += read;
+	}
+
+	if (readahead_enabled && num_blocks && i < nblocks && !device->memory)
+		UFSX(read_ahead)(device, fs, dinode, block_list, start_block,
+		    num_blocks, i);
+
+	return total;
+}
+
+// an inode wanted by read_inodes, and where in the caller's order
+struct UFSX(inode_ref) {
+	ufs_inop ino;
+	int64_t index;
+};
+
+static int UFSX(compare_refs)(const void *first, const void *second)
+{
+	const struct UFSX(inode_ref) *a = first;
+	const struct UFSX(inode_ref) *b = second;
+
+	if (a->ino != b->ino)
+		return a->ino < b->ino ? -1 : 1;
+	return a->index < b->index ? -1 : a->index > b->index;
+}
+
+// fill in a dinode whose on-disk copy is in din
+static void UFSX(dinode_fields)(ufs_dinode *dinode)
+{
+	const struct ufsx_dinode *di = &dinode->din.UFSX_DIN;
+
+	dinode->mode = di->di_mode;
+	dinode->size = di->di_size;
+	dinode->atime = di->di_atime;
+	dinode->mtime = di->di_mtime;
+}
+
+// an inode as it is on disk, in raw
+void UFSX(decode_inode)(const void *raw, ufs_dinode *dinode)
+{
+	memcpy(&dinode->din.UFSX_DIN, raw, sizeof(struct ufsx_dinode));
+	UFSX(dinode_fields)(dinode);
+}
+
+int UFSX(read_inode)(disk_device *device, struct fs *fs, ufs_inop ino,
+    ufs_dinode *dinode)
+{
+	struct ufsx_dinode *di;
+	int64_t cg;
+
+	di = &dinode->din.UFSX_DIN;
+
+	// fs_ipg needn't be a power of 2, this is the one divide
+	cg = ino / fs->fs_ipg;
+	if (seek_device(device, ufs_fragtobytes(fs, cgimin(fs, cg)) +
+	    (ino - cg * fs->fs_ipg) * sizeof(*di), SEEK_SET))
+		return -1;
+
+	if (read_device(device, (char*)di, sizeof(*di)))
+		return -1;
+	STATS_ADD(inodes, 1);
+	TRACE_INODE(ino);
+	UFSX(dinode_fields)(dinode);
+
+	return 0;
+}
+
+// inode numbers grow with their place on disk, so in sorted order the
+// inodes of one cylinder group's table come together. inodes no more
+// than INODE_GAP bytes apart are read in one request with what lies
+// between them, so each inode block is read once.
+int UFSX(read_inodes)(disk_device *device, struct fs *fs,
+    const ufs_inop *inos, int64_t n, ufs_dinode *out)
+{
+	struct UFSX(inode_ref) *refs;
+	int64_t i, j, k, cg, start, end, pos, ninodes;
+	int64_t isize = sizeof(struct ufsx_dinode);
+	char *buf;
+	int ret;
+
+	if (n <= 0)
+		return 0;
+
+	refs = malloc(n * sizeof(*refs));
+	for (i = 0; i < n; ++i) {
+		refs[i].ino = inos[i];
+		refs[i].index = i;
+	}
+	qsort(refs, (size_t)n, sizeof(*refs), UFSX(compare_refs));
+
+	buf = malloc(INODE_READ_MAX);
+	ninodes = (int64_t)fs->fs_ncg * fs->fs_ipg;
+	ret = 0;
+
+	for (i = 0; i < n; i = j) {
+		if (refs[i].ino < 0 || refs[i].ino >= ninodes) {
+			memset(&out[refs[i].index], 0, sizeof(*out));
+			ret = -1;
+			j = i + 1;
+			continue;
+		}
+
+		// the run of wanted inodes in this group's table, from the
+		// sector holding the first to the sector holding the last
+		cg = refs[i].ino / fs->fs_ipg;
+		start = (refs[i].ino - cg * fs->fs_ipg) * isize;
+		start -= start % DEV_BSIZE;
+		end = (refs[i].ino - cg * fs->fs_ipg + 1) * isize;
+		for (j = i + 1; j < n && refs[j].ino < ninodes &&
+		    refs[j].ino / fs->fs_ipg == cg; ++j) {
+			pos = (refs[j].ino - cg * fs->fs_ipg) * isize;
+			if (pos - end > INODE_GAP ||
+			    pos + isize - start > INODE_READ_MAX)
+				break;
+			end = pos + isize;
+		}
+		end = (end + DEV_BSIZE - 1) / DEV_BSIZE * DEV_BSIZE;
+
+		if (seek_device(device, ufs_fragtobytes(fs, cgimin(fs, cg)) +
+		    start, SEEK_SET) || read_device(device, buf, end - start)) {
+			for (k = i; k < j; ++k)
+				memset(&out[refs[k].index], 0, sizeof(*out));
+			ret = -1;
+			continue;
+		}
+
+		for (k = i; k < j; ++k) {
+			UFSX(decode_inode)(buf + (refs[k].ino - cg *
+			    fs->fs_ipg) * isize - start, &out[refs[k].index]);
+			STATS_ADD(inodes, 1);
+			TRACE_INODE(refs[k].ino);
+		}
+	}
+
+	free(buf);
+	free(refs);
+
+	return ret;
+}
+
+ufs_inop UFSX(follow_symlinks)(disk_device *device, struct fs *fs,
+    ufs_inop root_ino, ufs_inop ino)
+{
+	ufs_dinode dinode;
+	struct ufsx_dinode *di = &dinode.din.UFSX_DIN;
+
+	ufs_block_list *block_list;
+
+	UFSX(read_inode)(device, fs, ino, &dinode);
+	while ((di->di_mode & IFMT) == IFLNK) {
+		char tmpname[MAX_PATH];
+
+		block_list = UFSX(get_block_list)(device, fs, &dinode);
+		UFSX(read_data)(device, fs, &dinode, block_list, tmpname, 0, 0);
+		ufs_free_block_list(block_list);
+
+		tmpname[di->di_size] = '\0';
+		ino = UFSX(lookup_path)(device, fs, tmpname,
+		    0, root_ino);
+
+		UFSX(read_inode)(device, fs, ino, &dinode);
+	}
+
+	return ino;
+}
+
+ufs_inop UFSX(lookup_path)(disk_device *device, struct fs *fs, char *path,
+    int follow, ufs_inop root_ino)
+{
+	int ret, i;
+	char *nexts, *nexte, *tmp, *s, *sorig;
+	ufs_dinode dinode;
+	struct direct direct;
+	ufs_block_list *block_list;
+	int64_t found_ino;
+
+	s = malloc(MAX_PATH);
+	sorig = s;
+
+	if (path[0] == '/') {
+		strcpy(s, &path[1]);
+		root_ino = ROOTINO;
+	} else {
+		strcpy(s, path);
+	}
+
+	for (nexts = s; nexts && nexts[0]; nexts = s) {
+		if ((s = strchr(s, '/'))) {
+			*s = '\0';
+			s++;
+		}
+
+		UFSX(read_inode)(device, fs, root_ino, &dinode);
+
+		block_list = UFSX(get_block_list)(device, fs, &dinode);
+		tmp = malloc(dinode.din.UFSX_DIN.di_size);
+		UFSX(read_data)(device, fs, &dinode, block_list, tmp, 0, 0);
+		ufs_free_block_list(block_list);
+		STATS_ADD(directories, 1);
+		STATS_ADD(dirblocks, ufsx_nblocks(fs, dinode.size));
+
+		nexte = tmp;
+
+		for (i = 0;; ++i) {
+			ret = ufs_read_direntry(nexte, &direct);
+
+			if (nexte - tmp >= dinode.din.UFSX_DIN.di_size) {
+				TRACE_LOOKUP(nexts, 0);
+				free(tmp);
+				free(sorig);
+				return 0;
+			}
+
+			if (!strcmp(direct.d_name, nexts)) {
+				found_ino = direct.d_ino;
+				break;
+			}
+
+			nexte += ret;
+		}
+
+		free(tmp);
+		TRACE_LOOKUP(nexts, found_ino);
+		if (!found_ino) {
+			free(sorig);
+			return 0;
+		}
+
+		if (follow || (s && s[0] != '\0')) {
+			root_ino = UFSX(follow_symlinks)(device,
+			    fs, root_ino, found_ino);
+		} else {
+			root_ino = found_ino;
+		}
+	}
+
+	free(sorig);
+	return root_ino;
+}
+
+#undef ufsx_nblocks
@@ -0,0 +1,637 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+#include "walk.h"
+#include "stats.h"
+
+// most bytes of one read, of directory blocks or of inodes
+#define WALK_READ_MAX	(1 << 20)
+// inodes up to this many bytes apart in a table are read together
+#define WALK_INODE_GAP	(64 << 10)
+
+walk_limits walk_default_limits = { WALK_MAX_IO, WALK_MAX_MEMORY };
+
+enum walk_io_kind {
+	WALK_IO_DIR,			/* blocks of a directory */
+	WALK_IO_INODES			/* inodes of a directory's entries */
+};
+
+struct walk_child {
+	ufs_inop ino;
+	int type;
+	char *name;
+};
+
+// a directory found by the walk. it is read, then its entries' inodes,
+// then it is done; pending counts the reads of the current step.
+struct walk_dir {
+	struct walk_dir *next;		/* on the stack of unread ones */
+	ufs_inop ino;
+	ufs_inop parent;
+	ufs_dinode dinode;
+	char *path;
+	void *data;
+	char *buf;			/* its blocks, while being read */
+	struct walk_child *children;
+	int nchildren;
+	int pending;
+	int failed;
+	int64_t memory;			/* counted against the limit */
+};
+
+// one read, and what to do with it. ov comes first, so the completion
+// port's OVERLAPPED pointer is the walk_io.
+struct walk_io {
+	OVERLAPPED ov;
+	struct walk_io *next;		/* on the submit, done or reading list */
+	struct walk_io *prev;		/* on the reading list */
+	enum walk_io_kind kind;
+	struct walk_dir *dir;
+	int64_t offset;			/* absolute, sector aligned */
+	int64_t len;
+	char *buf;
+	int error;
+	int64_t dirpos;			/* WALK_IO_DIR: where in dir->buf */
+	int64_t dirlen;
+	int64_t cg;			/* WALK_IO_INODES: table of buf */
+	int64_t tablepos;		/* offset of buf in the table */
+	int first;			/* range of dir->children */
+	int count;
+};
+
+typedef struct _walker_ {
+	disk_device *device;
+	struct fs *fs;
+	HANDLE handle;			/* overlapped, or INVALID_HANDLE_VALUE */
+	HANDLE port;
+	walk_fn fn;
+	void *arg;
+	walk_limits limits;
+	int inflight;			/* issued, not handled yet */
+	int64_t memory;
+	int stopping;
+	int errors;
+	struct walk_dir *dirs;
+	struct walk_io *submit, *submit_tail;
+	struct walk_io *done, *done_tail;
+	struct walk_io *reading;	/* issued on handle, not yet completed */
+} walker;
+
+static void append_io(struct walk_io **head, struct walk_io **tail,
+    struct walk_io *io)
+{
+	io->next = NULL;
+	if (*tail)
+		(*tail)->next = io;
+	else
+		*head = io;
+	*tail = io;
+}
+
+static struct walk_io *pop_io(struct walk_io **head, struct walk_io **tail)
+{
+	struct walk_io *io = *head;
+
+	if (io) {
+		*head = io->next;
+		if (!*head)
+			*tail = NULL;
+	}
+
+	return io;
+}
+
+static void unlink_reading(walker *w, struct walk_io *io)
+{
+	if (io->prev)
+		io->prev->next = io->next;
+	else
+		w->reading = io->next;
+	if (io->next)
+		io->next->prev = io->prev;
+	io->next = io->prev = NULL;
+}
+
+static int compare_children(const void *first, const void *second)
+{
+	const struct walk_child *a = first;
+	const struct walk_child *b = second;
+
+	return a->ino < b->ino ? -1 : a->ino > b->ino;
+}
+
+static char *join_path(const char *dir, const char *name)
+{
+	size_t len = strlen(dir);
+	char *path;
+
+	path = malloc(len + strlen(name) + 2);
+	strcpy(path, dir);
+	if (!len || dir[len - 1] != '/')
+		path[len++] = '/';
+	strcpy(path + len, name);
+
+	return path;
+}
+
+static void walk_issue(walker *w, struct walk_io *io)
+{
+	io->buf = _aligned_malloc((size_t)io->len, w->device->sector_size);
+	w->memory += io->len;
+	STATS_MAX(walk_depth, ++w->inflight);
+
+	if (io->buf == NULL) {
+		io->error = 1;
+	} else if (w->handle != INVALID_HANDLE_VALUE) {
+		memset(&io->ov, 0, sizeof(io->ov));
+		io->ov.Offset = (DWORD)(io->offset & 0xFFFFFFFF);
+		io->ov.OffsetHigh = (DWORD)(io->offset >> 32);
+		STATS_ADD(reads, 1);
+		STATS_ADD(requests, 1);
+		// done now or later, the port hears of it either way
+		if (ReadFile(w->handle, io->buf, (DWORD)io->len, NULL,
+		    &io->ov) || GetLastError() == ERROR_IO_PENDING) {
+			io->prev = NULL;
+			io->next = w->reading;
+			if (w->reading)
+				w->reading->prev = io;
+			w->reading = io;
+			return;
+		}
+		io->error = 1;
+	} else {
+		io->error = seek_absolute_device(w->device, io->offset,
+		    SEEK_SET) || read_device(w->device, io->buf, io->len);
+	}
+
+	append_io(&w->done, &w->done_tail, io);
+}
+
+static struct walk_io *walk_wait(walker *w)
+{
+	struct walk_io *io;
+	OVERLAPPED *ov;
+	ULONG_PTR key;
+	DWORD n;
+
+	if ((io = pop_io(&w->done, &w->done_tail)) != NULL)
+		return io;
+
+	ov = NULL;
+	if (!GetQueuedCompletionStatus(w->port, &n, &key, &ov, INFINITE)) {
+		if (ov == NULL)
+			return NULL;
+		io = (struct walk_io *)ov;
+		unlink_reading(w, io);
+		io->error = 1;
+		return io;
+	}
+
+	io = (struct walk_io *)ov;
+	unlink_reading(w, io);
+	STATS_ADD(bytes, n);
+	// past the end of an image file
+	if (n < io->len)
+		memset(io->buf + n, 0, (size_t)(io->len - n));
+
+	return io;
+}
+
+static void dir_read(walker *w, struct walk_dir *dir);
+
+// every entry of dir was given, or it couldn't be read
+static void dir_done(walker *w, struct walk_dir *dir)
+{
+	walk_entry entry;
+	int i;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.ino = dir->ino;
+	entry.parent = dir->parent;
+	entry.dinode = &dir->dinode;
+	entry.type = DT_DIR;
+	entry.path = dir->path;
+	entry.name = strrchr(dir->path, '/') ? strrchr(dir->path, '/') + 1 :
+	    dir->path;
+	entry.data = dir->data;
+	entry.incomplete = dir->failed || w->stopping;
+	w->fn(w->arg, WALK_DONE, &entry);
+
+	for (i = 0; i < dir->nchildren; ++i)
+		free(dir->children[i].name);
+	free(dir->children);
+	free(dir->buf);
+	free(dir->path);
+	w->memory -= dir->memory;
+	free(dir);
+}
+
+// queue reads for the blocks of dir, merging those that follow each
+// other on disk
+static void start_dir(walker *w, struct walk_dir *dir)
+{
+	struct fs *fs = w->fs;
+	ufs_block_list *list;
+	struct walk_io *io;
+	int64_t size, nblocks, b, run, len, pos, frag;
+	int64_t t;
+
+	size = dir->dinode.size;
+	dir->buf = malloc((size_t)size + sizeof(struct direct));
+	dir->memory += size;
+	w->memory += size;
+
+	t = stats_begin();
+	list = ufs_get_block_list(w->device, fs, &dir->dinode);
+	stats_end(STATS_BLOCKMAP, t);
+	nblocks = lblkno(fs, blkroundup(fs, size));
+	STATS_ADD(directories, 1);
+	STATS_ADD(dirblocks, nblocks);
+
+	dir->pending = 1;
+	for (b = 0, pos = 0; b < nblocks && pos < size; b += run, pos += len) {
+		frag = ufs_block_at(fs, list, b);
+		len = sblksize(fs, size, b);
+		for (run = 1; frag && b + run < nblocks &&
+		    len + sblksize(fs, size, b + run) <= WALK_READ_MAX &&
+		    ufs_block_at(fs, list, b + run) == frag + run * fs->fs_frag;
+		    ++run)
+			len += sblksize(fs, size, b + run);
+
+		if (!frag) {
+			memset(dir->buf + pos, 0, (size_t)(len < size - pos ?
+			    len : size - pos));
+			continue;
+		}
+
+		io = calloc(1, sizeof(*io));
+		io->kind = WALK_IO_DIR;
+		io->dir = dir;
+		io->offset = device_absolute(w->device,
+		    ufs_fragtobytes(fs, frag));
+		io->len = roundup(len, w->device->sector_size);
+		io->dirpos = pos;
+		io->dirlen = len < size - pos ? len : size - pos;
+		append_io(&w->submit, &w->submit_tail, io);
+		dir->pending++;
+	}
+	ufs_free_block_list(list);
+
+	if (--dir->pending == 0)
+		dir_read(w, dir);
+}
+
+// the blocks of dir are in: queue reads for its entries' inodes, sorted
+// by number so each read takes the sectors of a run of them
+static void dir_read(walker *w, struct walk_dir *dir)
+{
+	struct fs *fs = w->fs;
+	struct direct direct;
+	struct walk_io *io;
+	walk_entry entry;
+	char *path;
+	int64_t pos, size, ninodes, isize, cg, start, end, ipos;
+	int i, j, n, r, oldfmt;
+	uint16_t reclen;
+
+	size = dir->dinode.size;
+	if (w->stopping) {
+		dir_done(w, dir);
+		return;
+	}
+	if (dir->failed) {
+		fprintf(stderr, "ufs2tool: cannot read directory \"%s\"\n",
+		    dir->path);
+		w->errors++;
+		dir_done(w, dir);
+		return;
+	}
+
+	for (pos = 0, n = 0; pos < size; pos += reclen, ++n) {
+		reclen = ufs_read_direntry(dir->buf + pos, &direct);
+		if (!reclen)
+			break;
+	}
+
+	// the old format has no types; its name length takes their place
+	oldfmt = fs->fs_maxsymlinklen <= 0;
+
+	dir->children = malloc((n ? n : 1) * sizeof(*dir->children));
+	for (pos = 0, i = 0; i < n; pos += reclen, ++i) {
+		reclen = ufs_read_direntry(dir->buf + pos, &direct);
+		if (!direct.d_ino || !strcmp(direct.d_name, ".") ||
+		    !strcmp(direct.d_name, ".."))
+			continue;
+
+		// let the callback pass on it before its inode is read
+		memset(&entry, 0, sizeof(entry));
+		entry.ino = direct.d_ino;
+		entry.parent = dir->ino;
+		entry.type = oldfmt ? DT_UNKNOWN : direct.d_type;
+		entry.path = path = join_path(dir->path, direct.d_name);
+		entry.name = direct.d_name;
+		entry.parent_data = dir->data;
+		r = w->stopping ? WALK_SKIP : w->fn(w->arg, WALK_NAME, &entry);
+		free(path);
+		if (r < 0)
+			w->stopping = 1;
+		if (r != WALK_CONTINUE)
+			continue;
+
+		dir->children[dir->nchildren].ino = direct.d_ino;
+		dir->children[dir->nchildren].type = entry.type;
+		dir->children[dir->nchildren].name = strdup(direct.d_name);
+		dir->memory += sizeof(*dir->children) + direct.d_namlen + 1;
+		w->memory += sizeof(*dir->children) + direct.d_namlen + 1;
+		dir->nchildren++;
+	}
+	free(dir->buf);
+	dir->buf = NULL;
+	dir->memory -= size;
+	w->memory -= size;
+
+	qsort(dir->children, dir->nchildren, sizeof(*dir->children),
+	    compare_children);
+
+	ninodes = (int64_t)fs->fs_ncg * fs->fs_ipg;
+	isize = ufs_dinode_size(fs);
+
+	dir->pending = 1;
+	for (i = 0; i < dir->nchildren; i = j) {
+		if (dir->children[i].ino >= ninodes) {
+			fprintf(stderr, "ufs2tool: \"%s/%s\" has bad inode "
+			    "%I64d\n", dir->path, dir->children[i].name,
+			    dir->children[i].ino);
+			w->errors++;
+			dir->failed = 1;
+			j = i + 1;
+			continue;
+		}
+
+		// as read_inodes does: from the sector holding the first
+		// inode of a run in this group's table to the one holding
+		// the last
+		cg = dir->children[i].ino / fs->fs_ipg;
+		start = (dir->children[i].ino - cg * fs->fs_ipg) * isize;
+		start -= start % w->device->sector_size;
+		end = (dir->children[i].ino - cg * fs->fs_ipg + 1) * isize;
+		for (j = i + 1; j < dir->nchildren &&
+		    dir->children[j].ino < ninodes &&
+		    dir->children[j].ino / fs->fs_ipg == cg; ++j) {
+			ipos = (dir->children[j].ino - cg * fs->fs_ipg) * isize;
+			if (ipos - end > WALK_INODE_GAP ||
+			    ipos + isize - start > WALK_READ_MAX)
+				break;
+			end = ipos + isize;
+		}
+
+		io = calloc(1, sizeof(*io));
+		io->kind = WALK_IO_INODES;
+		io->dir = dir;
+		io->cg = cg;
+		io->tablepos = start;
+		io->offset = device_absolute(w->device,
+		    ufs_fragtobytes(fs, cgimin(fs, cg)) + start);
+		io->len = roundup(end, w->device->sector_size) - start;
+		io->first = i;
+		io->count = j - i;
+		append_io(&w->submit, &w->submit_tail, io);
+		dir->pending++;
+	}
+
+	if (--dir->pending == 0)
+		dir_done(w, dir);
+}
+
+// hand the entries whose inodes io read to the callback
+static void inodes_read(walker *w, struct walk_io *io)
+{
+	struct walk_dir *dir = io->dir;
+	struct walk_dir *sub;
+	struct walk_child *child;
+	ufs_dinode dinode;
+	walk_entry entry;
+	char *path;
+	int64_t isize = ufs_dinode_size(w->fs);
+	int i, r;
+
+	for (i = io->first; i < io->first + io->count; ++i) {
+		child = &dir->children[i];
+		path = join_path(dir->path, child->name);
+		if (io->error) {
+			if (!w->stopping) {
+				fprintf(stderr, "ufs2tool: cannot read inode "
+				    "of \"%s\"\n", path);
+				w->errors++;
+			}
+			dir->failed = 1;
+			free(path);
+			continue;
+		}
+
+		ufs_decode_inode(w->fs, io->buf + (child->ino - io->cg *
+		    w->fs->fs_ipg) * isize - io->tablepos, &dinode);
+		STATS_ADD(inodes, 1);
+
+		memset(&entry, 0, sizeof(entry));
+		entry.ino = child->ino;
+		entry.parent = dir->ino;
+		entry.dinode = &dinode;
+		entry.type = child->type;
+		entry.path = path;
+		entry.name = child->name;
+		entry.parent_data = dir->data;
+		r = w->stopping ? WALK_SKIP :
+		    w->fn(w->arg, WALK_ENTRY, &entry);
+		if (r < 0)
+			w->stopping = 1;
+
+		if (r == WALK_CONTINUE && (dinode.mode & IFMT) == IFDIR) {
+			sub = calloc(1, sizeof(*sub));
+			sub->ino = child->ino;
+			sub->parent = dir->ino;
+			sub->dinode = dinode;
+			sub->path = path;
+			sub->data = entry.data;
+			sub->memory = sizeof(*sub) + strlen(path) + 1;
+			w->memory += sub->memory;
+			sub->next = w->dirs;
+			w->dirs = sub;
+			continue;
+		}
+
+		// a directory given data but not walked is done already
+		if (entry.data)
+			w->fn(w->arg, WALK_DONE, &entry);
+		free(path);
+	}
+
+	if (--dir->pending == 0)
+		dir_done(w, dir);
+}
+
+static void walk_complete(walker *w, struct walk_io *io)
+{
+	struct walk_dir *dir = io->dir;
+
+	if (io->kind == WALK_IO_DIR) {
+		if (io->error)
+			dir->failed = 1;
+		else
+			memcpy(dir->buf + io->dirpos, io->buf,
+			    (size_t)io->dirlen);
+		if (--dir->pending == 0)
+			dir_read(w, dir);
+	} else {
+		inodes_read(w, io);
+	}
+
+	_aligned_free(io->buf);
+	w->memory -= io->len;
+	free(io);
+}
+
+// the port failed: cancel what's still being read and wait for each to
+// finish with its buffer, then complete them unread. the directories
+// they were for, and any not started, get WALK_DONE as incomplete.
+static void walk_drain(walker *w)
+{
+	struct walk_io *io;
+	DWORD n;
+
+	w->stopping = 1;
+	if (w->reading)
+		CancelIoEx(w->handle, NULL);
+	while ((io = w->reading) != NULL) {
+		unlink_reading(w, io);
+		GetOverlappedResult(w->handle, &io->ov, &n, TRUE);
+		io->error = 1;
+		w->inflight--;
+		walk_complete(w, io);
+	}
+}
+
+int ufs_walk(disk_device *device, struct fs *fs, ufs_inop ino,
+    const ufs_dinode *dinode, const char *path, void *data,
+    const walk_limits *limits, walk_fn fn, void *arg)
+{
+	walker w;
+	struct walk_dir *dir;
+	struct walk_io *io;
+
+	memset(&w, 0, sizeof(w));
+	w.device = device;
+	w.fs = fs;
+	w.fn = fn;
+	w.arg = arg;
+	w.limits = limits ? *limits : walk_default_limits;
+	if (w.limits.max_io < 1)
+		w.limits.max_io = 1;
+
+	// a handle of its own for overlapped reads. anything else reads
+	// one at a time through device, completing as it's issued.
+	w.handle = INVALID_HANDLE_VALUE;
+	if (!device->memory && !device->sim) {
+		w.handle = ReOpenFile(device->handle, GENERIC_READ,
+		    FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_OVERLAPPED);
+		if (w.handle != INVALID_HANDLE_VALUE) {
+			w.port = CreateIoCompletionPort(w.handle, NULL, 0, 1);
+			if (w.port == NULL) {
+				CloseHandle(w.handle);
+				w.handle = INVALID_HANDLE_VALUE;
+			}
+		}
+	}
+
+	dir = calloc(1, sizeof(*dir));
+	dir->ino = ino;
+	dir->parent = ino;
+	dir->dinode = *dinode;
+	dir->path = strdup(path);
+	dir->data = data;
+	w.dirs = dir;
+
+	for (;;) {
+		while (w.submit && (w.stopping ||
+		    w.inflight < w.limits.max_io)) {
+			io = pop_io(&w.submit, &w.submit_tail);
+			if (w.stopping) {
+				// complete it unread
+				io->error = 1;
+				w.inflight++;
+				append_io(&w.done, &w.done_tail, io);
+			} else {
+				walk_issue(&w, io);
+			}
+		}
+
+		while (w.stopping && w.dirs) {
+			dir = w.dirs;
+			w.dirs = dir->next;
+			dir_done(&w, dir);
+		}
+
+		// more directories while there's room; above the memory
+		// limit, only when nothing else would free any
+		if (w.dirs && w.inflight < w.limits.max_io &&
+		    (w.memory < w.limits.max_memory || !w.inflight)) {
+			dir = w.dirs;
+			w.dirs = dir->next;
+			start_dir(&w, dir);
+			continue;
+		}
+
+		if (!w.inflight)
+			break;
+
+		if ((io = walk_wait(&w)) == NULL) {
+			fprintf(stderr, "ufs2tool: walk of \"%s\" failed\n",
+			    path);
+			w.errors++;
+			walk_drain(&w);
+			continue;
+		}
+		w.inflight--;
+		walk_complete(&w, io);
+	}
+
+	if (w.port)
+		CloseHandle(w.port);
+	if (w.handle != INVALID_HANDLE_VALUE)
+		CloseHandle(w.handle);
+
+	return w.errors ? -1 : 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _WALK_H_
+#define _WALK_H_
+
+#include <stdint.h>
+
+#include "disk/diskio.h"
+#include "ufs.h"
+
+// a walk of a directory tree that keeps many directory and inode reads
+// in flight at once, instead of one after another. every read carries
+// what to do when it completes: a directory's blocks are all read, its
+// entries are parsed and their inodes read, sorted by disk order, a few
+// sectors of the inode table at a time; as inodes arrive each entry is
+// handed to the callback, and directories among them are queued to be
+// read in turn. the reads go through an I/O completion port on a second,
+// overlapped handle to the device; memory images and simulated disks are
+// read synchronously, in the same order.
+
+#define WALK_MAX_IO	256		/* default reads in flight */
+#define WALK_MAX_MEMORY	(64 << 20)	/* default bytes of buffers */
+
+typedef struct _walk_limits_ {
+	int max_io;			/* reads in flight, 0 for no walk */
+	int64_t max_memory;		/* soft, directories wait above it */
+} walk_limits;
+
+// what the callback is told about
+typedef enum {
+	WALK_NAME,			/* an entry, before its inode is read */
+	WALK_ENTRY,			/* an entry of a directory */
+	WALK_DONE			/* every entry of a directory was given */
+} walk_event;
+
+// the callback's return for WALK_NAME and WALK_ENTRY. for WALK_NAME,
+// WALK_CONTINUE reads the inode and gives the entry again as WALK_ENTRY,
+// WALK_SKIP drops it without reading anything more.
+#define WALK_CONTINUE	0
+#define WALK_SKIP	1		/* don't walk into this directory */
+#define WALK_STOP	-1		/* finish what is in flight and return */
+
+typedef struct _walk_entry_ {
+	ufs_inop ino;
+	ufs_inop parent;		/* inode of its directory */
+	const ufs_dinode *dinode;	/* NULL for WALK_NAME */
+	int type;			/* DT_ type from the directory entry */
+	const char *path;		/* the walk's root path, then names */
+	const char *name;
+	void *parent_data;		/* data of its directory */
+	void *data;			/* set for a directory, given to its
+					   entries and to its WALK_DONE */
+	int incomplete;			/* WALK_DONE: some entries weren't
+					   given, it couldn't all be read */
+} walk_entry;
+
+// called on the walking thread. parents come before their entries, but
+// otherwise in whatever order the reads complete.
+typedef int (*walk_fn)(void *arg, walk_event event, walk_entry *entry);
+
+extern walk_limits walk_default_limits;
+
+extern int ufs_walk(disk_device *device, struct fs *fs, ufs_inop ino,
+    const ufs_dinode *dinode, const char *path, void *data,
+    const walk_limits *limits, walk_fn fn, void *arg);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdint.h>
+
+#include "bench.h"
+
+volatile uint64_t bench_sink;
+
+// counted by memcount.h, ufsbench is built with UFS_COUNT_ALLOCS
+volatile int64_t ufs_allocs;
+
+// monotonic time in nanoseconds
+int64_t bench_now(void)
+{
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+
+	return (int64_t)((double)now.QuadPart * 1e9 / freq.QuadPart);
+}
+
+// time fn with growing iteration counts until one run takes at least
+// BENCH_MIN_TIME, return nanoseconds per iteration. allocs, if not NULL,
+// gets the heap allocations per iteration.
+double bench_run(bench_fn fn, void *arg, double *allocs)
+{
+	int64_t iterations, start, elapsed, allocs_start;
+
+	for (iterations = 1;; iterations *= 2) {
+		allocs_start = ufs_allocs;
+		start = bench_now();
+		fn(arg, iterations);
+		elapsed = bench_now() - start;
+
+		if (elapsed >= BENCH_MIN_TIME)
+			break;
+	}
+
+	if (allocs)
+		*allocs = (double)(ufs_allocs - allocs_start) / iterations;
+
+	return (double)elapsed / iterations;
+}
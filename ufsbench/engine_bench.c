@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../ufs2tools-reboot/disk/diskio.h"
+#include "../ufs2tools-reboot/ufs.h"
+#include "bench.h"
+
+// synthetic UFS2 file system: 32k blocks, 4k fragments and a few small
+// cylinder groups, all in memory
+#define BENCH_BSHIFT	15
+#define BENCH_FSHIFT	12
+#define BENCH_NCG	4
+#define BENCH_FPG	1024
+#define BENCH_IPG	512
+
+/*
+ * the UFS2 read path as it was before ufs_engine.h, kept for comparison.
+ * the format was picked once through function pointers, read_data walked
+ * the file from its first block to find where to start, and inode
+ * addresses were worked out with multiplies and divides.
+ */
+static int legacy_ufs2_read_data(disk_device *device, struct fs *fs,
+    const ufs_dinode *dinode, ufs_block_list *block_list,
+    unsigned char *buf, ufs_inop start_block, ufs_inop num_blocks)
+{
+	int i, bsize;
+	const struct ufs2_dinode *di;
+	int64_t total, read, len, offset;
+	int64_t *bl;
+
+	di = &dinode->din.ufs2;
+	bl = block_list->ufs2;
+
+	if (!num_blocks) {
+		len = di->di_size;
+	} else {
+		len = num_blocks * fs->fs_fsize;
+	}
+
+	// no blocks, data is small enough to fit in dinode.di_db
+	if (di->di_blocks == 0) {
+		memcpy(buf, di->di_db, di->di_size);
+		return di->di_size;
+	}
+
+	// find start position
+	total = 0;
+	offset = 0;
+	for (i = 0; total < start_block * fs->fs_fsize; ++i) {
+		bsize = sblksize(fs, di->di_size, i);
+
+		if (total + bsize > start_block * fs->fs_fsize) {
+			offset = start_block * fs->fs_fsize - total;
+			break;
+		}
+
+		total += bsize;
+	}
+
+	for (total = 0; total < len; ++i) {
+		if (bl[i] != 0 && seek_device(device, bl[i] *
+		    fs->fs_fsize + offset, SEEK_SET) < 0)
+			return -1;
+
+		read = sblksize(fs, di->di_size, i) - offset;
+		offset = 0;
+
+		if (read + total > len)
+			read = len - total;
+
+		if (bl[i] == 0) {
+			memset(buf, 0, read);
+		} else if (read_device(device, buf, read) < 0) {
+			return -1;
+		}
+
+		total += read;
+		buf += read;
+	}
+
+	return total;
+}
+
+static int legacy_ufs2_read_inode(disk_device *device, struct fs *fs,
+    ufs_inop ino, ufs_dinode *dinode)
+{
+	int ret;
+	struct ufs2_dinode *di;
+
+	di = &dinode->din.ufs2;
+
+	ret = seek_device(device, cgimin(fs,(ino / fs->fs_ipg)) *
+	    fs->fs_fsize + ((ino % fs->fs_ipg) * sizeof(struct ufs2_dinode)),
+	    SEEK_SET);
+
+	if (ret)
+		return -1;
+
+	ret = read_device(device, (char*)di, sizeof(*di));
+	if (ret)
+		return -1;
+
+	dinode->mode = di->di_mode;
+	dinode->size = di->di_size;
+	dinode->atime = di->di_atime;
+	dinode->mtime = di->di_mtime;
+
+	return 0;
+}
+
+static int (*legacy_read_data)(disk_device *device, struct fs *fs,
+    const ufs_dinode *dinode, ufs_block_list *block_list,
+    unsigned char *buf, ufs_inop start_block, ufs_inop num_blocks);
+static int (*legacy_read_inode)(disk_device *device, struct fs *fs,
+    ufs_inop ino, ufs_dinode *dinode);
+
+struct engine_arg {
+	disk_device *device;
+	struct fs *fs;
+	ufs_dinode dinode;
+	ufs_block_list *block_list;
+	int64_t count;			/* fragments or inodes to pick from */
+	unsigned char *buf;
+	int legacy;
+};
+
+// a cheap pseudo-random sequence, so neither version gets to stream
+static uint64_t next_random(uint64_t x)
+{
+	return x * 6364136223846793005ULL + 1442695040888963407ULL;
+}
+
+// read one fragment at a random place in a file
+static void map_ops(void *arg, int64_t iterations)
+{
+	struct engine_arg *a = arg;
+	uint64_t x = 1;
+	int64_t i, start;
+
+	for (i = 0; i < iterations; ++i) {
+		x = next_random(x);
+		start = (int64_t)((x >> 16) % a->count);
+		if (a->legacy)
+			bench_sink += legacy_read_data(a->device, a->fs,
+			    &a->dinode, a->block_list, a->buf, start, 1);
+		else
+			bench_sink += ufs_read_data(a->device, a->fs,
+			    &a->dinode, a->block_list, a->buf, start, 1);
+	}
+}
+
+// read and decode a random inode
+static void inode_ops(void *arg, int64_t iterations)
+{
+	struct engine_arg *a = arg;
+	ufs_dinode dinode;
+	uint64_t x = 1;
+	int64_t i;
+	ufs_inop ino;
+
+	for (i = 0; i < iterations; ++i) {
+		x = next_random(x);
+		ino = (ufs_inop)((x >> 16) % a->count);
+		if (a->legacy)
+			legacy_read_inode(a->device, a->fs, ino, &dinode);
+		else
+			ufs_read_inode(a->device, a->fs, ino, &dinode);
+		bench_sink += dinode.size;
+	}
+}
+
+static struct fs *bench_fs(void)
+{
+	struct fs *fs;
+
+	fs = calloc(1, SBLOCKSIZE);
+	fs->fs_magic = FS_UFS2_MAGIC;
+	fs->fs_bshift = BENCH_BSHIFT;
+	fs->fs_fshift = BENCH_FSHIFT;
+	fs->fs_bsize = 1 << BENCH_BSHIFT;
+	fs->fs_fsize = 1 << BENCH_FSHIFT;
+	fs->fs_fragshift = BENCH_BSHIFT - BENCH_FSHIFT;
+	fs->fs_frag = 1 << fs->fs_fragshift;
+	fs->fs_bmask = ~(fs->fs_bsize - 1);
+	fs->fs_fmask = ~(fs->fs_fsize - 1);
+	fs->fs_qbmask = ~(int64_t)fs->fs_bmask;
+	fs->fs_qfmask = ~(int64_t)fs->fs_fmask;
+	fs->fs_nindir = fs->fs_bsize / sizeof(ufs2_daddr_t);
+	fs->fs_inopb = fs->fs_bsize / sizeof(struct ufs2_dinode);
+	fs->fs_ncg = BENCH_NCG;
+	fs->fs_fpg = BENCH_FPG;
+	fs->fs_ipg = BENCH_IPG;
+	fs->fs_iblkno = 3 * fs->fs_frag;
+
+	return fs;
+}
+
+static void report(const char *name, double legacy, double engine)
+{
+	printf("%-24s legacy %12.1f ns/op  engine %10.1f ns/op  %8.2fx\n",
+	    name, legacy, engine, legacy / engine);
+}
+
+int engine_bench(int argc, char **argv)
+{
+	static const int64_t sizes[] = {
+		1LL << 20, 64LL << 20, 1LL << 30, 16LL << 30
+	};
+	struct engine_arg arg;
+	char name[64], *image;
+	int64_t image_size;
+	double legacy, engine;
+	int i;
+
+	legacy_read_data = legacy_ufs2_read_data;
+	legacy_read_inode = legacy_ufs2_read_inode;
+
+	image_size = (int64_t)BENCH_NCG * BENCH_FPG << BENCH_FSHIFT;
+	image = calloc(1, (size_t)image_size);
+
+	memset(&arg, 0, sizeof(arg));
+	arg.fs = bench_fs();
+	arg.device = open_memory_device(image, image_size);
+	arg.buf = malloc(arg.fs->fs_bsize);
+
+	// block mapping, in files of holes so only the arithmetic is timed
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		arg.dinode.din.ufs2.di_size = sizes[i];
+		arg.dinode.din.ufs2.di_blocks = 1;
+		arg.dinode.size = sizes[i];
+		arg.block_list = ufs_get_block_list(arg.device, arg.fs,
+		    &arg.dinode);
+		arg.count = sizes[i] >> BENCH_FSHIFT;
+
+		arg.legacy = 1;
+		legacy = bench_run(map_ops, &arg, NULL);
+		arg.legacy = 0;
+		engine = bench_run(map_ops, &arg, NULL);
+
+		sprintf(name, "map %I64dM file", sizes[i] >> 20);
+		report(name, legacy, engine);
+
+		ufs_free_block_list(arg.block_list);
+	}
+
+	// inode decoding
+	arg.count = (int64_t)BENCH_NCG * BENCH_IPG;
+	arg.legacy = 1;
+	legacy = bench_run(inode_ops, &arg, NULL);
+	arg.legacy = 0;
+	engine = bench_run(inode_ops, &arg, NULL);
+	report("inode", legacy, engine);
+
+	close_device(arg.device);
+	free(arg.buf);
+	free(arg.fs);
+	free(image);
+
+	return 0;
+}
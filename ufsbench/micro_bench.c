@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../ufs2tools-reboot/disk/diskio.h"
+#include "../ufs2tools-reboot/ufs.h"
+#include "../ufs2tools-reboot/list.h"
+#include "../ufs2tools-reboot/misc.h"
+#include "bench.h"
+#include "mkimage.h"
+
+// entries in the direntry buffer, and the depth of the deepest lookup
+#define DIRENTRY_COUNT	1024
+#define LOOKUP_DEPTH	48
+
+struct micro_arg {
+	disk_device *device;
+	struct fs *fs;
+	ufs_dinode dinode;
+	ufs_block_list *block_list;
+	ufs_inop start;			/* read_data start fragment */
+	char path[MAX_PATH];
+	char *buf;
+	int64_t len;
+	struct direct *entries;		/* sort input, and its scratch copy */
+	struct direct *sorted;
+	int count;
+};
+
+// a UFS image built by build(), read back into memory
+struct micro_image {
+	char *data;
+	int64_t size;
+	disk_device *device;
+	struct fs *fs;
+};
+
+static void build_lookup(mkimage *img, void *arg)
+{
+	static const int sizes[] = { 10, 1000, 100000 };
+	ufs_inop dir;
+	char name[32];
+	int i, j;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		sprintf(name, "d%d", sizes[i]);
+		dir = mkimage_mkdir(img, ROOTINO, name);
+		for (j = 0; j < sizes[i] - 1; ++j) {
+			sprintf(name, "entry%07d", j);
+			mkimage_file(img, dir, name, 0, 0);
+		}
+		mkimage_file(img, dir, "last", 0, 0);
+	}
+
+	// a leaf at every level of c/d/d/...
+	dir = mkimage_mkdir(img, ROOTINO, "c");
+	for (i = 0; i < LOOKUP_DEPTH; ++i) {
+		mkimage_file(img, dir, "leaf", 0, 0);
+		dir = mkimage_mkdir(img, dir, "d");
+	}
+}
+
+// one file for each level of block pointers, only its first and last
+// block allocated
+static void build_blocks(mkimage *img, void *arg)
+{
+	int64_t nindir, bsize, nblocks;
+
+	bsize = 4096;
+	nindir = bsize / (mkimage_version(img) == 1 ? sizeof(int32_t) :
+	    sizeof(int64_t));
+
+	nblocks = NDADDR;
+	mkimage_file(img, ROOTINO, "direct", nblocks * bsize, MKIMAGE_HOLLOW);
+	nblocks += nindir;
+	mkimage_file(img, ROOTINO, "single", nblocks * bsize, MKIMAGE_HOLLOW);
+	nblocks += nindir * nindir;
+	mkimage_file(img, ROOTINO, "double", nblocks * bsize, MKIMAGE_HOLLOW);
+	nblocks += 64;
+	mkimage_file(img, ROOTINO, "triple", nblocks * bsize, MKIMAGE_HOLLOW);
+}
+
+static int load_image(struct micro_image *mi, int version, int bsize,
+    int fsize, int64_t ninodes, void (*build)(mkimage *, void *))
+{
+	char path[MAX_PATH];
+	mkimage *img;
+	FILE *f;
+
+	GetTempPath(sizeof(path) - 32, path);
+	sprintf(path + strlen(path), "ufsbench-%u.img", GetCurrentProcessId());
+
+	img = mkimage_create(path, version, 64LL << 20, bsize, fsize, ninodes);
+	if (img == NULL)
+		return -1;
+	build(img, NULL);
+	if (mkimage_close(img)) {
+		DeleteFile(path);
+		return -1;
+	}
+
+	f = fopen(path, "rb");
+	if (f == NULL) {
+		DeleteFile(path);
+		return -1;
+	}
+	// mkimage can grow the image past the size asked for
+	fseek(f, 0, SEEK_END);
+	mi->size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	mi->data = malloc((size_t)mi->size);
+	mi->size = fread(mi->data, 1, (size_t)mi->size, f);
+	fclose(f);
+	DeleteFile(path);
+
+	mi->device = open_memory_device(mi->data, mi->size);
+	mi->fs = ufs_init(mi->device);
+	if (mi->fs == NULL) {
+		close_device(mi->device);
+		free(mi->data);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void free_image(struct micro_image *mi)
+{
+	free(mi->fs);
+	close_device(mi->device);
+	free(mi->data);
+}
+
+static void report(const char *bench, const char *name, double ns,
+    double allocs)
+{
+	printf("%-10s %-28s %14.1f ns/op %10.2f allocs/op\n", bench, name, ns,
+	    allocs);
+	fflush(stdout);
+}
+
+static void direntry_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	struct direct direct;
+	int64_t i, offset;
+
+	offset = 0;
+	for (i = 0; i < iterations; ++i) {
+		if (offset >= a->len)
+			offset = 0;
+		offset += ufs_read_direntry(a->buf + offset, &direct);
+		bench_sink += direct.d_ino;
+	}
+}
+
+static void bench_direntry(void)
+{
+	static const int namelens[] = { 1, 16, 255 };
+	struct micro_arg arg;
+	struct direct *dp;
+	char name[64];
+	double ns, allocs;
+	int i, j, reclen;
+
+	memset(&arg, 0, sizeof(arg));
+
+	for (i = 0; i < sizeof(namelens) / sizeof(namelens[0]); ++i) {
+		reclen = (8 + namelens[i] + 1 + 3) & ~3;
+		arg.len = (int64_t)reclen * DIRENTRY_COUNT;
+		arg.buf = calloc(1, (size_t)arg.len + sizeof(struct direct));
+
+		for (j = 0; j < DIRENTRY_COUNT; ++j) {
+			dp = (struct direct *)(arg.buf + j * reclen);
+			dp->d_ino = j + ROOTINO;
+			dp->d_reclen = reclen;
+			dp->d_type = DT_REG;
+			dp->d_namlen = namelens[i];
+			memset(dp->d_name, 'a' + j % 26, namelens[i]);
+		}
+
+		ns = bench_run(direntry_ops, &arg, &allocs);
+		sprintf(name, "name length %d", namelens[i]);
+		report("direntry", name, ns, allocs);
+
+		free(arg.buf);
+	}
+}
+
+static void lookup_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	int64_t i;
+
+	for (i = 0; i < iterations; ++i)
+		bench_sink += ufs_lookup_path(a->device, a->fs, a->path, 0,
+		    ROOTINO);
+}
+
+static void bench_lookup(int version)
+{
+	static const int sizes[] = { 10, 1000, 100000 };
+	static const int depths[] = { 1, 8, LOOKUP_DEPTH };
+	struct micro_image mi;
+	struct micro_arg arg;
+	char name[64];
+	double ns, allocs;
+	int i, j;
+
+	if (load_image(&mi, version, 16384, 2048, 110000, build_lookup)) {
+		fprintf(stderr, "ufsbench: cannot build lookup image\n");
+		return;
+	}
+
+	memset(&arg, 0, sizeof(arg));
+	arg.device = mi.device;
+	arg.fs = mi.fs;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		sprintf(arg.path, "/d%d/last", sizes[i]);
+		ns = bench_run(lookup_ops, &arg, &allocs);
+		sprintf(name, "ufs%d %d entries", version, sizes[i]);
+		report("lookup", name, ns, allocs);
+	}
+
+	for (i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+		strcpy(arg.path, "/c/");
+		for (j = 1; j < depths[i]; ++j)
+			strcat(arg.path, "d/");
+		strcat(arg.path, "leaf");
+		ns = bench_run(lookup_ops, &arg, &allocs);
+		sprintf(name, "ufs%d depth %d", version, depths[i]);
+		report("lookup", name, ns, allocs);
+	}
+
+	free_image(&mi);
+}
+
+static void blocklist_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	ufs_block_list *list;
+	int64_t i;
+
+	for (i = 0; i < iterations; ++i) {
+		list = ufs_get_block_list(a->device, a->fs, &a->dinode);
+		bench_sink += list->ufs2 != NULL;
+		ufs_free_block_list(list);
+	}
+}
+
+static void startscan_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	int64_t i;
+
+	for (i = 0; i < iterations; ++i)
+		bench_sink += ufs_read_data(a->device, a->fs, &a->dinode,
+		    a->block_list, a->buf, a->start, 1);
+}
+
+// get_block_list for each level of indirection, and read_data of the
+// last fragment of the same files
+static void bench_blocks(int version)
+{
+	static const char *files[] = { "direct", "single", "double", "triple" };
+	struct micro_image mi;
+	struct micro_arg arg;
+	char name[64];
+	double ns, allocs;
+	ufs_inop ino;
+	int i;
+
+	if (load_image(&mi, version, 4096, 512, 100, build_blocks)) {
+		fprintf(stderr, "ufsbench: cannot build block image\n");
+		return;
+	}
+
+	memset(&arg, 0, sizeof(arg));
+	arg.device = mi.device;
+	arg.fs = mi.fs;
+	arg.buf = malloc(mi.fs->fs_bsize);
+
+	for (i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+		sprintf(arg.path, "/%s", files[i]);
+		ino = ufs_lookup_path(arg.device, arg.fs, arg.path, 0, ROOTINO);
+		ufs_read_inode(arg.device, arg.fs, ino, &arg.dinode);
+
+		ns = bench_run(blocklist_ops, &arg, &allocs);
+		sprintf(name, "ufs%d %s", version, files[i]);
+		report("blocklist", name, ns, allocs);
+	}
+
+	for (i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+		sprintf(arg.path, "/%s", files[i]);
+		ino = ufs_lookup_path(arg.device, arg.fs, arg.path, 0, ROOTINO);
+		ufs_read_inode(arg.device, arg.fs, ino, &arg.dinode);
+		arg.block_list = ufs_get_block_list(arg.device, arg.fs,
+		    &arg.dinode);
+		arg.start = (arg.dinode.size - 1) >> arg.fs->fs_fshift;
+
+		ns = bench_run(startscan_ops, &arg, &allocs);
+		sprintf(name, "ufs%d %s, last fragment", version, files[i]);
+		report("startscan", name, ns, allocs);
+
+		ufs_free_block_list(arg.block_list);
+	}
+
+	free(arg.buf);
+	free_image(&mi);
+}
+
+static void sort_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	int64_t i;
+
+	for (i = 0; i < iterations; ++i) {
+		memcpy(a->sorted, a->entries, a->count * sizeof(*a->sorted));
+		qsort(a->sorted, a->count, sizeof(*a->sorted), sort_direct);
+		bench_sink += a->sorted[0].d_ino;
+	}
+}
+
+// the qsort of a directory listing, including copying the entries in
+static void bench_sort(void)
+{
+	static const int counts[] = { 100, 10000, 100000 };
+	struct micro_arg arg;
+	char name[64];
+	double ns, allocs;
+	uint64_t x;
+	int i, j;
+
+	memset(&arg, 0, sizeof(arg));
+
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+		arg.count = counts[i];
+		arg.entries = calloc(arg.count, sizeof(*arg.entries));
+		arg.sorted = malloc(arg.count * sizeof(*arg.sorted));
+
+		x = 1;
+		for (j = 0; j < arg.count; ++j) {
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			arg.entries[j].d_ino = j + ROOTINO;
+			sprintf(arg.entries[j].d_name, "file%016I64x",
+			    x);
+			arg.entries[j].d_namlen =
+			    (uint8_t)strlen(arg.entries[j].d_name);
+		}
+		strcpy(arg.entries[0].d_name, "..");
+		strcpy(arg.entries[arg.count - 1].d_name, ".");
+
+		ns = bench_run(sort_ops, &arg, &allocs);
+		sprintf(name, "%d entries", counts[i]);
+		report("sort", name, ns, allocs);
+
+		free(arg.entries);
+		free(arg.sorted);
+	}
+}
+
+static void validname_ops(void *arg, int64_t iterations)
+{
+	struct micro_arg *a = arg;
+	char *name;
+	int64_t i;
+
+	for (i = 0; i < iterations; ++i) {
+		name = valid_filename(a->path, 0);
+		bench_sink += name[0];
+		free(name);
+	}
+}
+
+static void bench_validname(void)
+{
+	static const char *names[] = {
+		"dir/file.txt", "dir/prn.txt", "dir/x::y<z>", NULL
+	};
+	struct micro_arg arg;
+	double ns, allocs;
+	int i;
+
+	memset(&arg, 0, sizeof(arg));
+
+	for (i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (names[i]) {
+			strcpy(arg.path, names[i]);
+		} else {
+			strcpy(arg.path, "dir/");
+			memset(arg.path + 4, 'n', 200);
+			arg.path[204] = '\0';
+		}
+
+		ns = bench_run(validname_ops, &arg, &allocs);
+		report("validname", names[i] ? names[i] : "dir/<200 chars>", ns,
+		    allocs);
+	}
+}
+
+static int selected(int argc, char **argv, const char *name)
+{
+	int i;
+
+	for (i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], name))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * ufsbench micro [bench ...]
+ * per-function timings over in-memory images. bench is one of direntry,
+ * lookup, blocklist (with startscan), sort or validname.
+ */
+int micro_bench(int argc, char **argv)
+{
+	int i, all;
+
+#define SELECTED(name) (all || selected(argc, argv, name))
+	all = argc < 2;
+
+	for (i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "direntry") && strcmp(argv[i], "lookup") &&
+		    strcmp(argv[i], "blocklist") && strcmp(argv[i], "sort") &&
+		    strcmp(argv[i], "validname"))
+			return -1;
+	}
+
+	if (SELECTED("direntry"))
+		bench_direntry();
+	if (SELECTED("lookup")) {
+		bench_lookup(1);
+		bench_lookup(2);
+	}
+	if (SELECTED("blocklist")) {
+		bench_blocks(1);
+		bench_blocks(2);
+	}
+	if (SELECTED("sort"))
+		bench_sort();
+	if (SELECTED("validname"))
+		bench_validname();
+#undef SELECTED
+
+	return 0;
+}
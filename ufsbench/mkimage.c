@@ -0,0 +1,826 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <winioctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mkimage.h"
+
+// fixed timestamp so generated images are reproducible
+#define MKIMAGE_TIME	1700000000
+
+#define FS_DYNAMICPOSTBLFMT	1
+
+struct mkimage_dir {
+	ufs_inop ino;
+	ufs_inop parent;
+	int nlink;
+	char *buf;		/* entries, already in on-disk format */
+	int64_t len;
+	int64_t cap;
+	int64_t last;		/* offset of the last entry */
+};
+
+struct _mkimage_ {
+	HANDLE handle;
+	struct fs *fs;
+	int ufs2;
+	int dinode_size;
+	uint8_t *fragmap;	/* set = allocated */
+	uint8_t *inomap;	/* set = allocated */
+	int32_t *cg_ndir;
+	int64_t nfrags;
+	int64_t next_frag;	/* block allocation cursor */
+	int64_t tail_frag;	/* partially used block for file tails */
+	int tail_left;
+	ufs_inop next_ino;
+	ufs_inop ninodes;
+	int32_t *dir_index;	/* ino => dirs[] index, -1 if not a dir */
+	struct mkimage_dir *dirs;
+	int ndirs;
+	int dirs_cap;
+	unsigned char *blockbuf;
+	int failed;
+};
+
+void mkimage_pattern(ufs_inop ino, uint64_t offset, unsigned char *buf,
+    size_t len)
+{
+	size_t i;
+	uint64_t v;
+
+	for (i = 0; i < len; ++i, ++offset) {
+		v = ((uint64_t)ino << 32) ^ ((offset >> 3) *
+		    0x9E3779B97F4A7C15ULL);
+		buf[i] = (unsigned char)(v >> ((offset & 7) * 8));
+	}
+}
+
+static void write_at(mkimage *img, const void *buf, int64_t offset,
+    DWORD len)
+{
+	OVERLAPPED ov;
+	DWORD written;
+
+	memset(&ov, 0, sizeof(ov));
+	ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+
+	if (!WriteFile(img->handle, buf, len, &written, &ov) ||
+	    written != len) {
+		if (!img->failed)
+			fprintf(stderr, "mkimage: write failed at %I64d\n",
+			    offset);
+		img->failed = 1;
+	}
+}
+
+static int64_t frag_offset(mkimage *img, int64_t frag)
+{
+	return frag * img->fs->fs_fsize;
+}
+
+static void mark_frags(mkimage *img, int64_t frag, int64_t count)
+{
+	for (; count > 0; ++frag, --count)
+		setbit(img->fragmap, frag);
+}
+
+// find the next free, block aligned block at or after the cursor
+static int64_t alloc_block(mkimage *img)
+{
+	struct fs *fs = img->fs;
+	int64_t f;
+	int i;
+
+	for (f = img->next_frag; f + fs->fs_frag <= img->nfrags;
+	    f += fs->fs_frag) {
+		for (i = 0; i < fs->fs_frag; ++i) {
+			if (isset(img->fragmap, f + i))
+				break;
+		}
+		if (i == fs->fs_frag) {
+			mark_frags(img, f, fs->fs_frag);
+			img->next_frag = f + fs->fs_frag;
+			return f;
+		}
+	}
+
+	if (!img->failed)
+		fprintf(stderr, "mkimage: filesystem full\n");
+	img->failed = 1;
+	return 0;
+}
+
+static int64_t alloc_frags(mkimage *img, int count)
+{
+	int64_t f;
+
+	if (count >= img->fs->fs_frag)
+		return alloc_block(img);
+
+	if (img->tail_left < count) {
+		img->tail_frag = alloc_block(img);
+		img->tail_left = img->fs->fs_frag;
+		// give back what the tail doesn't use yet
+		for (f = 0; f < img->fs->fs_frag; ++f)
+			clrbit(img->fragmap, img->tail_frag + f);
+	}
+
+	f = img->tail_frag;
+	mark_frags(img, f, count);
+	img->tail_frag += count;
+	img->tail_left -= count;
+
+	return f;
+}
+
+static ufs_inop alloc_inode(mkimage *img)
+{
+	ufs_inop ino;
+
+	if (img->next_ino >= img->ninodes) {
+		if (!img->failed)
+			fprintf(stderr, "mkimage: out of inodes\n");
+		img->failed = 1;
+		return 0;
+	}
+
+	ino = img->next_ino++;
+	setbit(img->inomap, ino);
+
+	return ino;
+}
+
+// write one indirect block covering lbns [base, base + NINDIR^level)
+static int64_t write_indirect(mkimage *img, const int64_t *ptrs,
+    int64_t nptrs, int64_t base, int level, int64_t *nfrags)
+{
+	struct fs *fs = img->fs;
+	int64_t span, lbn, v, addr;
+	void *buf;
+	int i, any;
+
+	for (span = 1, i = 1; i < level; ++i)
+		span *= NINDIR(fs);
+
+	buf = calloc(1, fs->fs_bsize);
+	any = 0;
+
+	for (i = 0; i < NINDIR(fs); ++i) {
+		lbn = base + i * span;
+		if (lbn >= nptrs)
+			break;
+
+		if (level == 1) {
+			v = ptrs[lbn];
+		} else {
+			v = write_indirect(img, ptrs, nptrs, lbn, level - 1,
+			    nfrags);
+		}
+
+		if (!v)
+			continue;
+
+		any = 1;
+		if (img->ufs2)
+			((int64_t *)buf)[i] = v;
+		else
+			((int32_t *)buf)[i] = (int32_t)v;
+	}
+
+	if (!any) {
+		free(buf);
+		return 0;
+	}
+
+	addr = alloc_block(img);
+	write_at(img, buf, frag_offset(img, addr), fs->fs_bsize);
+	*nfrags += fs->fs_frag;
+	free(buf);
+
+	return addr;
+}
+
+static void write_dinode(mkimage *img, ufs_inop ino, uint16_t mode,
+    int nlink, uint64_t size, int64_t nfrags, const int64_t *db,
+    const int64_t *ib, const char *inline_data)
+{
+	struct fs *fs = img->fs;
+	struct ufs1_dinode d1;
+	struct ufs2_dinode d2;
+	int64_t offset;
+	int i;
+
+	offset = frag_offset(img, cgimin(fs, ino / fs->fs_ipg)) +
+	    (ino % fs->fs_ipg) * img->dinode_size;
+
+	if (img->ufs2) {
+		memset(&d2, 0, sizeof(d2));
+		d2.di_mode = mode;
+		d2.di_nlink = nlink;
+		d2.di_blksize = fs->fs_bsize;
+		d2.di_size = size;
+		d2.di_blocks = nfrags * (fs->fs_fsize / 512);
+		d2.di_atime = d2.di_mtime = d2.di_ctime = d2.di_birthtime =
+		    MKIMAGE_TIME + ino;
+		d2.di_gen = (int32_t)(ino * 2654435761U);
+		if (inline_data) {
+			memcpy(d2.di_db, inline_data, size);
+		} else {
+			for (i = 0; i < NDADDR; ++i)
+				d2.di_db[i] = db[i];
+			for (i = 0; i < NIADDR; ++i)
+				d2.di_ib[i] = ib[i];
+		}
+		write_at(img, &d2, offset, sizeof(d2));
+	} else {
+		memset(&d1, 0, sizeof(d1));
+		d1.di_mode = mode;
+		d1.di_nlink = nlink;
+		d1.di_size = size;
+		d1.di_blocks = (int32_t)(nfrags * (fs->fs_fsize / 512));
+		d1.di_atime = d1.di_mtime = d1.di_ctime =
+		    (int32_t)(MKIMAGE_TIME + ino);
+		d1.di_gen = (int32_t)(ino * 2654435761U);
+		if (inline_data) {
+			memcpy(d1.di_db, inline_data, size);
+		} else {
+			for (i = 0; i < NDADDR; ++i)
+				d1.di_db[i] = (int32_t)db[i];
+			for (i = 0; i < NIADDR; ++i)
+				d1.di_ib[i] = (int32_t)ib[i];
+		}
+		write_at(img, &d1, offset, sizeof(d1));
+	}
+}
+
+// allocate and write the blocks of an inode, either from data or from
+// the test pattern, then write its dinode
+static void write_inode_data(mkimage *img, ufs_inop ino, uint16_t mode,
+    int nlink, uint64_t size, const char *data, int flags)
+{
+	struct fs *fs = img->fs;
+	int64_t nblocks, lbn, nfrags, base, span;
+	int64_t *ptrs;
+	int64_t db[NDADDR], ib[NIADDR];
+	uint64_t len;
+	int bsize, i;
+
+	nblocks = howmany(size, (uint64_t)fs->fs_bsize);
+	ptrs = calloc(nblocks ? nblocks : 1, sizeof(*ptrs));
+	nfrags = 0;
+
+	for (lbn = 0; lbn < nblocks; ++lbn) {
+		// sparse files keep every 16th block and the last one
+		if ((flags & MKIMAGE_SPARSE) && lbn % 16 &&
+		    lbn != nblocks - 1)
+			continue;
+		if ((flags & MKIMAGE_HOLLOW) && lbn != 0 &&
+		    lbn != nblocks - 1)
+			continue;
+
+		bsize = (int)sblksize(fs, (int64_t)size, lbn);
+		ptrs[lbn] = alloc_frags(img, bsize / fs->fs_fsize);
+		nfrags += bsize / fs->fs_fsize;
+
+		if (flags & MKIMAGE_NODATA) {
+			if (flags & MKIMAGE_FRAGMENT)
+				img->next_frag += fs->fs_frag;
+			continue;
+		}
+
+		if (data) {
+			len = size - lbn * fs->fs_bsize;
+			if (len > (uint64_t)bsize)
+				len = bsize;
+			memset(img->blockbuf, 0, bsize);
+			memcpy(img->blockbuf, data + lbn * fs->fs_bsize,
+			    (size_t)len);
+		} else {
+			mkimage_pattern(ino, lbn * fs->fs_bsize,
+			    img->blockbuf, bsize);
+		}
+		write_at(img, img->blockbuf, frag_offset(img, ptrs[lbn]),
+		    bsize);
+
+		if (flags & MKIMAGE_FRAGMENT)
+			img->next_frag += fs->fs_frag;
+	}
+
+	for (i = 0; i < NDADDR; ++i)
+		db[i] = i < nblocks ? ptrs[i] : 0;
+
+	base = NDADDR;
+	span = NINDIR(fs);
+	for (i = 0; i < NIADDR; ++i) {
+		ib[i] = base < nblocks ? write_indirect(img, ptrs, nblocks,
+		    base, i + 1, &nfrags) : 0;
+		base += span;
+		span *= NINDIR(fs);
+	}
+
+	write_dinode(img, ino, mode, nlink, size, nfrags, db, ib, NULL);
+	free(ptrs);
+}
+
+static void dir_add(mkimage *img, struct mkimage_dir *dir, ufs_inop ino,
+    uint8_t type, const char *name)
+{
+	struct direct *dp;
+	int namlen, reclen, used;
+
+	namlen = (int)strlen(name);
+	reclen = (8 + namlen + 1 + 3) & ~3;
+
+	if (dir->len + reclen + DIRBLKSIZ > dir->cap) {
+		dir->cap = (dir->cap + reclen + DIRBLKSIZ) * 2;
+		dir->buf = realloc(dir->buf, dir->cap);
+	}
+
+	// entries never cross a DIRBLKSIZ boundary, the previous entry
+	// absorbs the unused space instead
+	used = dir->len % DIRBLKSIZ;
+	if (used && used + reclen > DIRBLKSIZ) {
+		dp = (struct direct *)(dir->buf + dir->last);
+		dp->d_reclen += DIRBLKSIZ - used;
+		dir->len += DIRBLKSIZ - used;
+	}
+
+	dp = (struct direct *)(dir->buf + dir->len);
+	memset(dp, 0, reclen);
+	dp->d_ino = (uint32_t)ino;
+	dp->d_reclen = reclen;
+	dp->d_type = type;
+	dp->d_namlen = namlen;
+	memcpy(dp->d_name, name, namlen);
+
+	dir->last = dir->len;
+	dir->len += reclen;
+}
+
+static struct mkimage_dir *new_dir(mkimage *img, ufs_inop ino,
+    ufs_inop parent)
+{
+	struct mkimage_dir *dir;
+
+	if (img->ndirs == img->dirs_cap) {
+		img->dirs_cap = img->dirs_cap ? img->dirs_cap * 2 : 64;
+		img->dirs = realloc(img->dirs, img->dirs_cap *
+		    sizeof(*img->dirs));
+	}
+
+	img->dir_index[ino] = img->ndirs;
+	dir = &img->dirs[img->ndirs++];
+	memset(dir, 0, sizeof(*dir));
+	dir->ino = ino;
+	dir->parent = parent;
+	dir->nlink = 2;
+
+	dir_add(img, dir, ino, DT_DIR, ".");
+	dir_add(img, dir, parent, DT_DIR, "..");
+
+	img->cg_ndir[ino / img->fs->fs_ipg]++;
+
+	return dir;
+}
+
+static struct mkimage_dir *find_dir(mkimage *img, ufs_inop ino)
+{
+	if (ino <= 0 || ino >= img->ninodes || img->dir_index[ino] < 0)
+		return NULL;
+
+	return &img->dirs[img->dir_index[ino]];
+}
+
+mkimage *mkimage_create(const char *path, int ufs_version, int64_t size,
+    int bsize, int fsize, int64_t ninodes)
+{
+	mkimage *img;
+	struct fs *fs;
+	int64_t fpg, ncg, ipg, totalfrags, cgsize, c;
+	int frag, inopb, shift;
+
+	if (bsize < MINBSIZE || fsize < 512 || bsize % fsize ||
+	    bsize / fsize > MAXFRAG || (bsize & (bsize - 1)) ||
+	    (fsize & (fsize - 1)))
+		return NULL;
+
+	img = calloc(1, sizeof(*img));
+	img->ufs2 = ufs_version == 2;
+	img->dinode_size = img->ufs2 ? sizeof(struct ufs2_dinode) :
+	    sizeof(struct ufs1_dinode);
+	img->fs = fs = calloc(1, SBLOCKSIZE);
+
+	frag = bsize / fsize;
+	inopb = bsize / img->dinode_size;
+	totalfrags = size / fsize;
+	totalfrags -= totalfrags % frag;
+
+	fs->fs_bsize = bsize;
+	fs->fs_fsize = fsize;
+	fs->fs_frag = frag;
+	fs->fs_bmask = ~(bsize - 1);
+	fs->fs_fmask = ~(fsize - 1);
+	fs->fs_qbmask = ~(int64_t)fs->fs_bmask;
+	fs->fs_qfmask = ~(int64_t)fs->fs_fmask;
+	for (shift = 0; (1 << shift) < bsize; ++shift);
+	fs->fs_bshift = shift;
+	for (shift = 0; (1 << shift) < fsize; ++shift);
+	fs->fs_fshift = shift;
+	for (shift = 0; (1 << shift) < frag; ++shift);
+	fs->fs_fragshift = shift;
+	for (shift = 0; (512 << shift) < fsize; ++shift);
+	fs->fs_fsbtodb = shift;
+	fs->fs_nindir = bsize / (img->ufs2 ? sizeof(int64_t) :
+	    sizeof(int32_t));
+	fs->fs_inopb = inopb;
+	fs->fs_maxcontig = bsize < 131072 ? 131072 / bsize : 1;
+	fs->fs_contigsumsize = fs->fs_maxcontig < FS_MAXCONTIG ?
+	    fs->fs_maxcontig : FS_MAXCONTIG;
+	fs->fs_old_cpg = img->ufs2 ? 0 : 1;
+	fs->fs_sblockloc = img->ufs2 ? SBLOCK_UFS2 : SBLOCK_UFS1;
+	fs->fs_sblkno = (int32_t)roundup(howmany(fs->fs_sblockloc +
+	    SBLOCKSIZE, fsize), frag);
+	fs->fs_cblkno = fs->fs_sblkno + (int32_t)roundup(howmany(SBLOCKSIZE,
+	    fsize), frag);
+	fs->fs_iblkno = fs->fs_cblkno + frag;
+
+	// largest cylinder group whose maps still fit in one block
+	fpg = (int64_t)bsize * NBBY;
+	if (fpg > totalfrags)
+		fpg = totalfrags;
+	fpg -= fpg % frag;
+	for (;;) {
+		ncg = howmany(totalfrags, fpg);
+		if (ncg < 1)
+			ncg = 1;
+		ipg = roundup(howmany(ninodes + ROOTINO + 1, ncg), inopb);
+		fs->fs_fpg = (int32_t)fpg;
+		fs->fs_ipg = (int32_t)ipg;
+		cgsize = CGSIZE(fs);
+		if (cgsize <= bsize && fs->fs_iblkno + ipg / inopb * frag +
+		    4 * frag < fpg)
+			break;
+		fpg -= fpg / 8;
+		fpg -= fpg % frag;
+		if (fpg < 8 * frag) {
+			fprintf(stderr, "mkimage: image too small\n");
+			free(fs);
+			free(img);
+			return NULL;
+		}
+	}
+
+	fs->fs_ncg = (int32_t)ncg;
+	fs->fs_dblkno = fs->fs_iblkno + (int32_t)(ipg / inopb * frag);
+	fs->fs_cgsize = (int32_t)roundup(cgsize, fsize);
+	fs->fs_size = ncg * fpg;
+	fs->fs_cssize = (int32_t)roundup(ncg * sizeof(struct csum), fsize);
+	fs->fs_csaddr = fs->fs_dblkno;
+	fs->fs_dsize = fs->fs_size - ncg * fs->fs_dblkno -
+	    howmany(fs->fs_cssize, fsize);
+	fs->fs_sbsize = (int32_t)roundup(sizeof(struct fs), fsize);
+	fs->fs_minfree = MINFREE;
+	fs->fs_maxbpg = bsize / 4;
+	fs->fs_optim = FS_OPTTIME;
+	fs->fs_avgfilesize = AVFILESIZ;
+	fs->fs_avgfpdir = AFPDIR;
+	fs->fs_maxsymlinklen = (NDADDR + NIADDR) * (img->ufs2 ?
+	    sizeof(int64_t) : sizeof(int32_t));
+	fs->fs_maxfilesize = (uint64_t)bsize * (NDADDR + NINDIR(fs) +
+	    (int64_t)NINDIR(fs) * NINDIR(fs)) - 1;
+	fs->fs_clean = 1;
+	fs->fs_id[0] = MKIMAGE_TIME;
+	fs->fs_id[1] = 0x75667332;
+	fs->fs_time = MKIMAGE_TIME;
+	fs->fs_old_time = MKIMAGE_TIME;
+	strcpy((char *)fs->fs_volname, "ufsbench");
+	fs->fs_magic = img->ufs2 ? FS_UFS2_MAGIC : FS_UFS1_MAGIC;
+
+	if (!img->ufs2) {
+		fs->fs_old_cgmask = (int32_t)0xffffffff;
+		fs->fs_old_cgoffset = 0;
+		fs->fs_old_size = (int32_t)fs->fs_size;
+		fs->fs_old_dsize = (int32_t)fs->fs_dsize;
+		fs->fs_old_csaddr = (int32_t)fs->fs_csaddr;
+		fs->fs_old_inodefmt = FS_44INODEFMT;
+		fs->fs_old_postblformat = FS_DYNAMICPOSTBLFMT;
+		fs->fs_old_nrpos = 1;
+		fs->fs_old_rps = 60;
+		fs->fs_old_nspf = fsize / 512;
+		fs->fs_old_ncyl = (int32_t)ncg;
+		fs->fs_old_spc = (int32_t)(fpg * fs->fs_old_nspf);
+		fs->fs_old_nsect = fs->fs_old_spc;
+		fs->fs_old_npsect = fs->fs_old_spc;
+		fs->fs_old_interleave = 1;
+	}
+
+	img->nfrags = fs->fs_size;
+	img->ninodes = ncg * ipg;
+	img->fragmap = calloc(howmany(img->nfrags, NBBY), 1);
+	img->inomap = calloc(howmany(img->ninodes, NBBY), 1);
+	img->cg_ndir = calloc(ncg, sizeof(*img->cg_ndir));
+	img->dir_index = malloc(img->ninodes * sizeof(*img->dir_index));
+	memset(img->dir_index, 0xff, img->ninodes * sizeof(*img->dir_index));
+	img->blockbuf = malloc(bsize);
+
+	img->handle = CreateFile(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+	    CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (img->handle == INVALID_HANDLE_VALUE) {
+		fprintf(stderr, "mkimage: cannot create %s\n", path);
+		img->failed = 1;
+		mkimage_close(img);
+		return NULL;
+	}
+
+#ifdef FSCTL_SET_SPARSE
+	{
+		DWORD returned;
+		DeviceIoControl(img->handle, FSCTL_SET_SPARSE, NULL, 0, NULL,
+		    0, &returned, NULL);
+	}
+#endif
+
+	// cylinder group metadata and the summary area are never free
+	for (c = 0; c < ncg; ++c)
+		mark_frags(img, cgbase(fs, c), fs->fs_dblkno);
+	mark_frags(img, fs->fs_csaddr, howmany(fs->fs_cssize, fsize));
+	img->next_frag = 0;
+
+	setbit(img->inomap, 0);
+	setbit(img->inomap, 1);
+	img->next_ino = ROOTINO;
+	alloc_inode(img);
+	new_dir(img, ROOTINO, ROOTINO);
+
+	return img;
+}
+
+ufs_inop mkimage_mkdir(mkimage *img, ufs_inop parent, const char *name)
+{
+	struct mkimage_dir *pdir;
+	ufs_inop ino;
+
+	pdir = find_dir(img, parent);
+	if (pdir == NULL || (ino = alloc_inode(img)) == 0)
+		return 0;
+
+	dir_add(img, pdir, ino, DT_DIR, name);
+	pdir->nlink++;
+	new_dir(img, ino, parent);
+
+	return ino;
+}
+
+ufs_inop mkimage_file(mkimage *img, ufs_inop parent, const char *name,
+    uint64_t size, int flags)
+{
+	struct mkimage_dir *pdir;
+	ufs_inop ino;
+
+	pdir = find_dir(img, parent);
+	if (pdir == NULL || (ino = alloc_inode(img)) == 0)
+		return 0;
+
+	dir_add(img, pdir, ino, DT_REG, name);
+	write_inode_data(img, ino, IFREG | 0644, 1, size, NULL, flags);
+
+	return ino;
+}
+
+ufs_inop mkimage_symlink(mkimage *img, ufs_inop parent, const char *name,
+    const char *target)
+{
+	struct mkimage_dir *pdir;
+	ufs_inop ino;
+	size_t len;
+
+	pdir = find_dir(img, parent);
+	if (pdir == NULL || (ino = alloc_inode(img)) == 0)
+		return 0;
+
+	dir_add(img, pdir, ino, DT_LNK, name);
+
+	len = strlen(target);
+	if ((int)len < img->fs->fs_maxsymlinklen) {
+		write_dinode(img, ino, IFLNK | 0755, 1, len, 0, NULL, NULL,
+		    target);
+	} else {
+		write_inode_data(img, ino, IFLNK | 0755, 1, len, target, 0);
+	}
+
+	return ino;
+}
+
+// 1 or 2
+int mkimage_version(mkimage *img)
+{
+	return img->ufs2 ? 2 : 1;
+}
+
+// fill in a cylinder group header and its maps from the allocation maps
+static void write_cg(mkimage *img, int64_t c, struct csum *cs)
+{
+	struct fs *fs = img->fs;
+	struct cg *cgp;
+	uint8_t *blksfree, *inosused, *clustersfree;
+	int32_t *clustersum;
+	int64_t base, i, b, run;
+	int j, nfree, frun;
+
+	cgp = calloc(1, fs->fs_cgsize);
+	base = cgbase(fs, c);
+
+	cgp->cg_magic = CG_MAGIC;
+	cgp->cg_cgx = (int32_t)c;
+	cgp->cg_ndblk = fs->fs_fpg;
+	cgp->cg_niblk = fs->fs_ipg;
+	cgp->cg_initediblk = fs->fs_ipg;
+	cgp->cg_time = MKIMAGE_TIME;
+	cgp->cg_old_time = MKIMAGE_TIME;
+
+	if (img->ufs2) {
+		cgp->cg_iusedoff = sizeof(struct cg);
+	} else {
+		cgp->cg_old_ncyl = 1;
+		cgp->cg_old_niblk = (int16_t)fs->fs_ipg;
+		cgp->cg_old_btotoff = sizeof(struct cg);
+		cgp->cg_old_boff = cgp->cg_old_btotoff +
+		    fs->fs_old_cpg * sizeof(int32_t);
+		cgp->cg_iusedoff = cgp->cg_old_boff +
+		    fs->fs_old_cpg * sizeof(uint16_t);
+	}
+	cgp->cg_freeoff = cgp->cg_iusedoff + howmany(fs->fs_ipg, NBBY);
+	cgp->cg_nextfreeoff = cgp->cg_freeoff + howmany(fs->fs_fpg, NBBY);
+	if (fs->fs_contigsumsize > 0) {
+		cgp->cg_clustersumoff = roundup(cgp->cg_nextfreeoff,
+		    sizeof(uint32_t)) - sizeof(uint32_t);
+		cgp->cg_clusteroff = cgp->cg_clustersumoff +
+		    (fs->fs_contigsumsize + 1) * sizeof(uint32_t);
+		cgp->cg_nextfreeoff = cgp->cg_clusteroff +
+		    howmany(fragstoblks(fs, fs->fs_fpg), NBBY);
+		cgp->cg_nclusterblks = fragstoblks(fs, fs->fs_fpg);
+	}
+
+	inosused = cg_inosused(cgp);
+	blksfree = cg_blksfree(cgp);
+
+	cgp->cg_cs.cs_ndir = img->cg_ndir[c];
+	for (i = 0; i < fs->fs_ipg; ++i) {
+		if (isset(img->inomap, c * fs->fs_ipg + i))
+			setbit(inosused, i);
+		else
+			cgp->cg_cs.cs_nifree++;
+	}
+
+	for (b = 0; b < fs->fs_fpg; b += fs->fs_frag) {
+		nfree = 0;
+		frun = 0;
+		for (j = 0; j < fs->fs_frag; ++j) {
+			if (isset(img->fragmap, base + b + j)) {
+				if (frun)
+					cgp->cg_frsum[frun]++;
+				frun = 0;
+			} else {
+				setbit(blksfree, b + j);
+				nfree++;
+				frun++;
+			}
+		}
+		if (nfree == fs->fs_frag) {
+			cgp->cg_cs.cs_nbfree++;
+		} else {
+			if (frun)
+				cgp->cg_frsum[frun]++;
+			cgp->cg_cs.cs_nffree += nfree;
+		}
+	}
+
+	if (fs->fs_contigsumsize > 0) {
+		clustersfree = cg_clustersfree(cgp);
+		clustersum = cg_clustersum(cgp);
+		run = 0;
+		for (b = 0; b < cgp->cg_nclusterblks; ++b) {
+			for (j = 0; j < fs->fs_frag; ++j) {
+				if (!isset(blksfree, b * fs->fs_frag + j))
+					break;
+			}
+			if (j == fs->fs_frag) {
+				setbit(clustersfree, b);
+				run++;
+			} else if (run) {
+				clustersum[run > fs->fs_contigsumsize ?
+				    fs->fs_contigsumsize : run]++;
+				run = 0;
+			}
+		}
+		if (run)
+			clustersum[run > fs->fs_contigsumsize ?
+			    fs->fs_contigsumsize : run]++;
+	}
+
+	*cs = cgp->cg_cs;
+	write_at(img, cgp, frag_offset(img, cgtod(fs, c)), fs->fs_cgsize);
+	free(cgp);
+}
+
+int mkimage_close(mkimage *img)
+{
+	struct fs *fs = img->fs;
+	struct mkimage_dir *dir;
+	struct csum *csp;
+	LARGE_INTEGER end;
+	int64_t c;
+	int i, ret;
+
+	if (img->handle == INVALID_HANDLE_VALUE)
+		goto out;
+
+	for (i = 0; i < img->ndirs; ++i) {
+		dir = &img->dirs[i];
+
+		// the last entry runs to the end of its directory block
+		if (dir->len % DIRBLKSIZ) {
+			((struct direct *)(dir->buf + dir->last))->d_reclen +=
+			    (uint16_t)(DIRBLKSIZ - dir->len % DIRBLKSIZ);
+			dir->len = roundup(dir->len, DIRBLKSIZ);
+		}
+
+		write_inode_data(img, dir->ino, IFDIR | 0755, dir->nlink,
+		    dir->len, dir->buf, 0);
+	}
+
+	csp = calloc(1, fs->fs_cssize);
+	memset(&fs->fs_cstotal, 0, sizeof(fs->fs_cstotal));
+	for (c = 0; c < fs->fs_ncg; ++c) {
+		write_cg(img, c, &csp[c]);
+		fs->fs_cstotal.cs_ndir += csp[c].cs_ndir;
+		fs->fs_cstotal.cs_nbfree += csp[c].cs_nbfree;
+		fs->fs_cstotal.cs_nifree += csp[c].cs_nifree;
+		fs->fs_cstotal.cs_nffree += csp[c].cs_nffree;
+	}
+	fs->fs_old_cstotal.cs_ndir = (int32_t)fs->fs_cstotal.cs_ndir;
+	fs->fs_old_cstotal.cs_nbfree = (int32_t)fs->fs_cstotal.cs_nbfree;
+	fs->fs_old_cstotal.cs_nifree = (int32_t)fs->fs_cstotal.cs_nifree;
+	fs->fs_old_cstotal.cs_nffree = (int32_t)fs->fs_cstotal.cs_nffree;
+	write_at(img, csp, frag_offset(img, fs->fs_csaddr), fs->fs_cssize);
+	free(csp);
+
+	// primary superblock, then a backup in every cylinder group
+	write_at(img, fs, fs->fs_sblockloc, fs->fs_sbsize);
+	for (c = 0; c < fs->fs_ncg; ++c)
+		write_at(img, fs, frag_offset(img, cgsblock(fs, c)),
+		    fs->fs_sbsize);
+
+	end.QuadPart = frag_offset(img, fs->fs_size);
+	if (!SetFilePointerEx(img->handle, end, NULL, FILE_BEGIN) ||
+	    !SetEndOfFile(img->handle))
+		img->failed = 1;
+
+	CloseHandle(img->handle);
+
+out:
+	ret = img->failed ? -1 : 0;
+
+	for (i = 0; i < img->ndirs; ++i)
+		free(img->dirs[i].buf);
+	free(img->dirs);
+	free(img->dir_index);
+	free(img->cg_ndir);
+	free(img->inomap);
+	free(img->fragmap);
+	free(img->blockbuf);
+	free(img->fs);
+	free(img);
+
+	return ret;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MKIMAGE_H_
+#define _MKIMAGE_H_
+
+#include <stdint.h>
+
+#include "../ufs2tools-reboot/ufs.h"
+
+// writes small UFS1/UFS2 images with known contents for the benchmarks.
+// file data comes from mkimage_pattern(), so it can be checked after
+// extraction. a failed write or a full image makes mkimage_close() fail.
+
+// mkimage_file flags
+#define MKIMAGE_SPARSE		0x01	/* leave most blocks as holes */
+#define MKIMAGE_FRAGMENT	0x02	/* leave a free block after each block */
+#define MKIMAGE_HOLLOW		0x04	/* only the first and last block */
+#define MKIMAGE_NODATA		0x08	/* allocate blocks, don't write them */
+
+typedef struct _mkimage_ mkimage;
+
+extern mkimage *mkimage_create(const char *path, int ufs_version,
+    int64_t size, int bsize, int fsize, int64_t ninodes);
+extern ufs_inop mkimage_mkdir(mkimage *img, ufs_inop parent,
+    const char *name);
+extern ufs_inop mkimage_file(mkimage *img, ufs_inop parent,
+    const char *name, uint64_t size, int flags);
+extern ufs_inop mkimage_symlink(mkimage *img, ufs_inop parent,
+    const char *name, const char *target);
+extern int mkimage_version(mkimage *img);
+extern int mkimage_close(mkimage *img);
+
+extern void mkimage_pattern(ufs_inop ino, uint64_t offset,
+    unsigned char *buf, size_t len);
+
+#endif
@@ -0,0 +1,502 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../ufs2tools-reboot/disk/diskio.h"
+#include "../ufs2tools-reboot/ufs.h"
+#include "../ufs2tools-reboot/extract.h"
+#include "../ufs2tools-reboot/diff.h"
+#include "../ufs2tools-reboot/image.h"
+#include "../ufs2tools-reboot/list.h"
+#include "../ufs2tools-reboot/stats.h"
+#include "../ufs2tools-reboot/stream.h"
+#include "bench.h"
+#include "mkimage.h"
+
+// the tree is TREE_DIRS directories of TREE_FILES files each
+#define TREE_DIRS	50
+#define TREE_FILES	1000
+#define ROOT_FILES	20
+#define BIG_SIZE	(1LL << 30)
+#define RESOLVE_PATHS	10000
+#define IO_SIZE		(2 << 20)
+
+#define MAX_BASELINE	256
+
+struct ops_counter {
+	const char *name;
+	size_t offset;			/* in ufs_stats */
+};
+
+// what is compared. all of these only depend on the image and the code.
+static const struct ops_counter counters[] = {
+	{ "reads", offsetof(ufs_stats, reads) },
+	{ "requests", offsetof(ufs_stats, requests) },
+	{ "bytes", offsetof(ufs_stats, bytes) },
+	{ "seeks", offsetof(ufs_stats, seeks) },
+	{ "discontiguous", offsetof(ufs_stats, discontig) },
+	{ "inodes", offsetof(ufs_stats, inodes) },
+	{ "directories", offsetof(ufs_stats, directories) },
+	{ "dirblocks", offsetof(ufs_stats, dirblocks) },
+	{ "blocks", offsetof(ufs_stats, blocks) },
+};
+
+#define NCOUNTERS (sizeof(counters) / sizeof(counters[0]))
+
+struct ops_baseline {
+	char scenario[32];
+	char counter[32];
+	int64_t value;
+};
+
+typedef int (*ops_fn)(disk_device *device, struct fs *fs,
+    const char *workdir);
+
+static void build_ops(mkimage *img)
+{
+	ufs_inop tree, dir;
+	char name[32];
+	int i, j;
+
+	for (i = 0; i < ROOT_FILES; ++i) {
+		sprintf(name, "r%02d", i);
+		mkimage_file(img, ROOTINO, name, 4096, MKIMAGE_NODATA);
+	}
+	mkimage_file(img, ROOTINO, "big", BIG_SIZE, MKIMAGE_NODATA);
+
+	tree = mkimage_mkdir(img, ROOTINO, "tree");
+	for (i = 0; i < TREE_DIRS; ++i) {
+		sprintf(name, "d%02d", i);
+		dir = mkimage_mkdir(img, tree, name);
+		for (j = 0; j < TREE_FILES; ++j) {
+			sprintf(name, "f%04d", j);
+			mkimage_file(img, dir, name, 1024, MKIMAGE_NODATA);
+		}
+	}
+}
+
+static int ops_list(disk_device *device, struct fs *fs, const char *workdir)
+{
+	char path[MAX_PATH], root[] = "/";
+	FILE *out;
+	int ret;
+
+	sprintf(path, "%s/ops-list.txt", workdir);
+	if ((out = fopen(path, "w")) == NULL)
+		return -1;
+	ret = print_dir_listing(device, fs, root, out);
+	fclose(out);
+
+	return ret;
+}
+
+static int ops_get(disk_device *device, struct fs *fs, const char *src,
+    const char *workdir)
+{
+	extract_ctx ctx;
+	char path[MAX_PATH], dest[MAX_PATH];
+	ufs_inop ino;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.device = device;
+	ctx.fs = fs;
+	ctx.quiet = 1;
+	ctx.discard = 1;
+
+	strcpy(path, src);
+	sprintf(dest, "%s/ops.out", workdir);
+	ino = ufs_lookup_path(device, fs, path, 0, ROOTINO);
+
+	return read_file(&ctx, ROOTINO, ino, path, dest);
+}
+
+static int ops_get_big(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	return ops_get(device, fs, "/big", workdir);
+}
+
+static int ops_get_tree(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	return ops_get(device, fs, "/tree", workdir);
+}
+
+// the tree again over a copy of it, with EXTRACT_UPDATE. only the
+// second copy is counted, which reads no file data.
+static int ops_get_tree_update(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	extract_ctx ctx;
+	char path[] = "/tree", dest[MAX_PATH];
+	ufs_inop ino;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.device = device;
+	ctx.fs = fs;
+	ctx.quiet = 1;
+
+	sprintf(dest, "%s/ops-tree", workdir);
+	CreateDirectory(dest, NULL);
+	ino = ufs_lookup_path(device, fs, path, 0, ROOTINO);
+	if (read_file(&ctx, ROOTINO, ino, path, dest))
+		return -1;
+
+	memset(&stats, 0, sizeof(stats));
+	ctx.update = EXTRACT_UPDATE;
+	if (read_file(&ctx, ROOTINO, ino, path, dest))
+		return -1;
+
+	return ctx.unchanged == TREE_DIRS * TREE_FILES ? 0 : -1;
+}
+
+// bytes a sink was given, from a walk of the tree with no copy written
+static int ops_count_data(void *arg, const char *buf, int64_t len,
+    int64_t offset)
+{
+	*(int64_t *)arg += len;
+
+	return STREAM_CONTINUE;
+}
+
+static int ops_stream_tree(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	ufs_sink sink;
+	char path[] = "/tree";
+	int64_t bytes;
+
+	memset(&sink, 0, sizeof(sink));
+	sink.data = ops_count_data;
+	sink.arg = &bytes;
+	bytes = 0;
+	if (ufs_stream_tree(device, fs, path, &sink))
+		return -1;
+
+	return bytes ? 0 : -1;
+}
+
+// the image against itself, as of two snapshots with nothing changed:
+// directories and inodes are read, no file data
+static int ops_diff(disk_device *device, struct fs *fs, const char *workdir)
+{
+	disk_device *other;
+	struct fs *other_fs;
+	char path[MAX_PATH], root[] = "/";
+	FILE *out;
+	int ret;
+
+	if ((other = clone_device(device)) == NULL)
+		return -1;
+	if ((other_fs = ufs_init(other)) == NULL) {
+		close_device(other);
+		return -1;
+	}
+
+	sprintf(path, "%s/ops-diff.txt", workdir);
+	if ((out = fopen(path, "w")) == NULL) {
+		ret = -1;
+	} else {
+		ret = ufs_diff(device, fs, other, other_fs, root, out);
+		fclose(out);
+	}
+
+	free(other_fs);
+	close_device(other);
+
+	return ret;
+}
+
+// only the hash, so nothing but the reads is measured
+static int ops_image(disk_device *device, struct fs *fs, const char *workdir)
+{
+	char path[MAX_PATH];
+	FILE *out;
+	int ret;
+
+	sprintf(path, "%s/ops-image.txt", workdir);
+	if ((out = fopen(path, "w")) == NULL)
+		return -1;
+	ret = image_partition(device, fs, NULL, out);
+	fclose(out);
+
+	return ret;
+}
+
+static int ops_resolve(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	char path[MAX_PATH];
+	int i;
+
+	for (i = 0; i < RESOLVE_PATHS; ++i) {
+		sprintf(path, "/tree/d%02d/f%04d", i % TREE_DIRS,
+		    (i / TREE_DIRS * 5) % TREE_FILES);
+		if (!ufs_lookup_path(device, fs, path, 1, ROOTINO))
+			return -1;
+	}
+
+	return 0;
+}
+
+// the same paths, resolved together
+static int ops_resolve_batch(disk_device *device, struct fs *fs,
+    const char *workdir)
+{
+	char *paths[RESOLVE_PATHS];
+	ufs_inop inos[RESOLVE_PATHS];
+	int i, ret;
+
+	for (i = 0; i < RESOLVE_PATHS; ++i) {
+		paths[i] = malloc(32);
+		sprintf(paths[i], "/tree/d%02d/f%04d", i % TREE_DIRS,
+		    (i / TREE_DIRS * 5) % TREE_FILES);
+	}
+	ret = ufs_lookup_paths(device, fs, paths, RESOLVE_PATHS, 1, ROOTINO,
+	    inos);
+	for (i = 0; i < RESOLVE_PATHS; ++i)
+		free(paths[i]);
+
+	return ret;
+}
+
+static const struct {
+	const char *name;
+	ops_fn fn;
+} scenarios[] = {
+	{ "list", ops_list },
+	{ "get1g", ops_get_big },
+	{ "getr", ops_get_tree },
+	{ "getru", ops_get_tree_update },
+	{ "streamr", ops_stream_tree },
+	{ "resolve", ops_resolve },
+	{ "resolveb", ops_resolve_batch },
+	{ "diff", ops_diff },
+	{ "image", ops_image },
+};
+
+static int read_baseline(const char *path, struct ops_baseline *base,
+    int max)
+{
+	char line[256];
+	FILE *f;
+	int n;
+
+	if ((f = fopen(path, "r")) == NULL)
+		return -1;
+
+	n = 0;
+	while (n < max && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+		if (sscanf(line, "%31s %31s %I64d", base[n].scenario,
+		    base[n].counter, &base[n].value) == 3)
+			++n;
+	}
+	fclose(f);
+
+	return n;
+}
+
+static const struct ops_baseline *find_baseline(
+    const struct ops_baseline *base, int n, const char *scenario,
+    const char *counter)
+{
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		if (!strcmp(base[i].scenario, scenario) &&
+		    !strcmp(base[i].counter, counter))
+			return &base[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * ufsbench ops [-update] [-d workdir] [-b baseline]
+ * runs fixed scenarios on generated images and compares the exact
+ * number of reads, bytes, seeks, inodes, directories and blocks each
+ * needs against the checked in baseline. fails if any went up.
+ * -update rewrites the baseline with the current counts instead.
+ */
+int ops_bench(int argc, char **argv)
+{
+	struct ops_baseline *base;
+	const struct ops_baseline *b;
+	const char *workdir, *baseline, *status;
+	char image[MAX_PATH], scenario[32];
+	disk_device *device;
+	struct fs *fs;
+	mkimage *img;
+	FILE *out;
+	int64_t value;
+	int i, c, n, version, update, regressed, improved, error;
+
+	workdir = "ufsbench.tmp";
+	baseline = "ufsbench/ops_baseline.txt";
+	update = 0;
+
+	for (i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-update"))
+			update = 1;
+		else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			workdir = argv[++i];
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+			baseline = argv[++i];
+		else
+			return -1;
+	}
+
+	if (GetFileAttributes(workdir) == INVALID_FILE_ATTRIBUTES &&
+	    !CreateDirectory(workdir, NULL)) {
+		fprintf(stderr, "ufsbench: cannot create %s\n", workdir);
+		return -1;
+	}
+
+	base = calloc(MAX_BASELINE, sizeof(*base));
+	n = 0;
+	if (!update && (n = read_baseline(baseline, base, MAX_BASELINE)) < 0) {
+		fprintf(stderr, "ufsbench: cannot read %s\n", baseline);
+		free(base);
+		return -1;
+	}
+
+	out = NULL;
+	if (update && (out = fopen(baseline, "w")) == NULL) {
+		fprintf(stderr, "ufsbench: cannot write %s\n", baseline);
+		free(base);
+		return -1;
+	}
+	if (out) {
+		fprintf(out, "# operation counts of \"ufsbench ops\", "
+		    "rewritten by \"ufsbench ops -update\"\n"
+		    "# scenario counter value\n");
+	}
+
+	stats_enable();
+	regressed = improved = error = 0;
+
+	for (version = 1; version <= 2; ++version) {
+		sprintf(image, "%s/ops-ufs%d.img", workdir, version);
+		if (GetFileAttributes(image) == INVALID_FILE_ATTRIBUTES) {
+			fprintf(stderr, "generating %s\n", image);
+			img = mkimage_create(image, version, BIG_SIZE +
+			    (256LL << 20), 32768, 4096,
+			    TREE_DIRS * (TREE_FILES + 1) + ROOT_FILES + 64);
+			if (img == NULL) {
+				error = 1;
+				break;
+			}
+			build_ops(img);
+			if (mkimage_close(img)) {
+				DeleteFile(image);
+				error = 1;
+				break;
+			}
+		}
+
+		for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+			sprintf(scenario, "%s-ufs%d", scenarios[i].name,
+			    version);
+
+			// a new device each time, so the head starts at 0
+			device = open_file_device(image);
+			if (device == NULL || (fs = ufs_init(device)) == NULL) {
+				fprintf(stderr, "ufsbench: cannot open %s\n",
+				    image);
+				error = 1;
+				break;
+			}
+
+			// timing must not change the counts
+			io_tune_fixed(&device->tune, IO_SIZE);
+			memset(&stats, 0, sizeof(stats));
+			if (scenarios[i].fn(device, fs, workdir)) {
+				fprintf(stderr, "ufsbench: %s failed\n",
+				    scenario);
+				error = 1;
+			}
+
+			for (c = 0; c < NCOUNTERS; ++c) {
+				value = *(volatile int64_t *)((char *)&stats +
+				    counters[c].offset);
+
+				if (out) {
+					fprintf(out, "%s %s %I64d\n", scenario,
+					    counters[c].name, value);
+					printf("%-14s %-14s %12I64d\n",
+					    scenario, counters[c].name, value);
+					continue;
+				}
+
+				b = find_baseline(base, n, scenario,
+				    counters[c].name);
+				if (b == NULL) {
+					status = "no baseline";
+				} else if (value > b->value) {
+					status = "REGRESSED";
+					regressed = 1;
+				} else if (value < b->value) {
+					status = "improved";
+					improved = 1;
+				} else {
+					status = "";
+				}
+				printf("%-14s %-14s %12I64d %12I64d  %s\n",
+				    scenario, counters[c].name,
+				    b ? b->value : 0, value, status);
+			}
+
+			free(fs);
+			close_device(device);
+		}
+	}
+
+	if (out)
+		fclose(out);
+	free(base);
+
+	if (error)
+		return -1;
+	if (regressed) {
+		fprintf(stderr, "ufsbench: operation counts went up\n");
+		return 1;
+	}
+	if (improved) {
+		fprintf(stderr, "ufsbench: counts went down, update the "
+		    "baseline with \"ufsbench ops -update\"\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <psapi.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../ufs2tools-reboot/disk/diskio.h"
+#include "../ufs2tools-reboot/ufs.h"
+#include "../ufs2tools-reboot/extract.h"
+#include "../ufs2tools-reboot/list.h"
+#include "bench.h"
+#include "mkimage.h"
+
+// every case repeats its operation for at least this long
+#define CASE_MIN_TIME 1000000000
+
+// a 48 level deep path
+#define DEEP4	"d/d/d/d/"
+#define DEEP16	DEEP4 DEEP4 DEEP4 DEEP4
+#define DEEP_PATH "/" DEEP16 DEEP16 DEEP16 "leaf"
+#define DEEP_LEVELS 48
+
+#define SYMLINK_CHAIN 32
+
+// an image layout, built once per UFS version. the quick run uses the
+// small counts, -full the large ones.
+struct shape {
+	const char *name;
+	int bsize;
+	int fsize;
+	int64_t image_size[2];		/* quick, full */
+	int64_t ninodes[2];
+	void (*build)(mkimage *img, int full);
+	const char *list_path;
+	const char *lookup_path;
+	const char *get_path;		/* a single file, or NULL */
+};
+
+static void build_deep(mkimage *img, int full)
+{
+	ufs_inop dir;
+	char name[16];
+	int i, j;
+
+	dir = ROOTINO;
+	for (i = 0; i < DEEP_LEVELS; ++i) {
+		for (j = 0; j < (full ? 64 : 4); ++j) {
+			sprintf(name, "f%d", j);
+			mkimage_file(img, dir, name, 4096 * (j % 8 + 1), 0);
+		}
+		dir = mkimage_mkdir(img, dir, "d");
+	}
+	mkimage_file(img, dir, "leaf", 65536, 0);
+}
+
+static void build_bigdir(mkimage *img, int full)
+{
+	ufs_inop dir;
+	char name[32];
+	int i;
+
+	dir = mkimage_mkdir(img, ROOTINO, "big");
+	for (i = 0; i < (full ? 1000000 : 20000); ++i) {
+		sprintf(name, "entry%07d", i);
+		mkimage_file(img, dir, name, 0, 0);
+	}
+	mkimage_file(img, dir, "last", 100, 0);
+}
+
+static void build_tiny(mkimage *img, int full)
+{
+	ufs_inop dir;
+	char name[32];
+	int i, j;
+
+	for (i = 0; i < (full ? 100 : 20); ++i) {
+		sprintf(name, "t%02d", i);
+		dir = mkimage_mkdir(img, ROOTINO, name);
+		for (j = 0; j < (full ? 1000 : 100); ++j) {
+			sprintf(name, "f%04d", j);
+			mkimage_file(img, dir, name, (i * 1000 + j) * 37 % 1024 + 1,
+			    0);
+		}
+	}
+}
+
+static void build_frag(mkimage *img, int full)
+{
+	char name[16];
+	int i;
+
+	for (i = 0; i < 4; ++i) {
+		sprintf(name, "frag%d", i);
+		mkimage_file(img, ROOTINO, name, (full ? 128LL : 8LL) << 20,
+		    MKIMAGE_FRAGMENT);
+	}
+}
+
+static void build_sparse(mkimage *img, int full)
+{
+	mkimage_file(img, ROOTINO, "sparse", (full ? 16LL << 30 : 512LL << 20)
+	    + 12345, MKIMAGE_SPARSE);
+}
+
+// just far enough into the triple indirect blocks, whatever the pointer
+// width
+static void build_triple(mkimage *img, int full)
+{
+	int64_t nindir, bsize;
+
+	bsize = 4096;
+	nindir = bsize / (mkimage_version(img) == 1 ? sizeof(int32_t) :
+	    sizeof(int64_t));
+	mkimage_file(img, ROOTINO, "triple", (NDADDR + nindir +
+	    nindir * nindir + 64) * bsize + 321, MKIMAGE_HOLLOW);
+}
+
+static void build_symlinks(mkimage *img, int full)
+{
+	char name[16], target[16];
+	int i;
+
+	mkimage_file(img, ROOTINO, "target", 1 << 20, 0);
+	strcpy(target, "target");
+	for (i = 0; i < SYMLINK_CHAIN; ++i) {
+		sprintf(name, "l%02d", i);
+		mkimage_symlink(img, ROOTINO, name, target);
+		strcpy(target, name);
+	}
+}
+
+static void build_large(mkimage *img, int full)
+{
+	mkimage_file(img, ROOTINO, "large", (full ? 2048LL : 128LL) << 20, 0);
+}
+
+static const struct shape shapes[] = {
+	{ "deep", 32768, 4096, { 64LL << 20, 256LL << 20 }, { 1000, 8000 },
+	    build_deep, "/", DEEP_PATH, DEEP_PATH },
+	{ "bigdir", 32768, 4096, { 256LL << 20, 4LL << 30 },
+	    { 20100, 1000100 }, build_bigdir, "/big", "/big/last", NULL },
+	{ "tiny", 32768, 4096, { 64LL << 20, 1LL << 30 }, { 2100, 100200 },
+	    build_tiny, "/t00", "/t07/f0042", NULL },
+	{ "frag", 32768, 4096, { 128LL << 20, 2LL << 30 }, { 100, 100 },
+	    build_frag, "/", "/frag3", "/frag0" },
+	{ "sparse", 32768, 4096, { 128LL << 20, 2LL << 30 }, { 100, 100 },
+	    build_sparse, "/", "/sparse", "/sparse" },
+	{ "triple", 4096, 512, { 64LL << 20, 64LL << 20 }, { 100, 100 },
+	    build_triple, "/", "/triple", "/triple" },
+	{ "symlinks", 32768, 4096, { 64LL << 20, 64LL << 20 }, { 100, 100 },
+	    build_symlinks, "/", "/l31", "/l31" },
+	{ "large", 32768, 4096, { 256LL << 20, 3LL << 30 }, { 100, 100 },
+	    build_large, "/", "/large", "/large" },
+};
+
+static int generate(const struct shape *shape, int version, int full,
+    const char *path)
+{
+	mkimage *img;
+	int64_t start;
+
+	fprintf(stderr, "generating %s\n", path);
+	start = bench_now();
+
+	img = mkimage_create(path, version, shape->image_size[full],
+	    shape->bsize, shape->fsize, shape->ninodes[full]);
+	if (img == NULL)
+		return -1;
+	shape->build(img, full);
+	if (mkimage_close(img)) {
+		DeleteFile(path);
+		return -1;
+	}
+
+	fprintf(stderr, "generated %s in %.1fs\n", path,
+	    (bench_now() - start) / 1e9);
+
+	return 0;
+}
+
+/*
+ * one case, run in its own process so peak_rss belongs to it alone.
+ * ufsbench case [-o file] [-sim spec] image op sink path workdir
+ *   op		list, lookup, get or getr
+ *   sink	null (read everything, write nothing) or real (files in
+ *		workdir)
+ *   spec	a simdisk model of the device (see simdisk.c). the
+ *		operation then runs once, and its time on the model is
+ *		reported as sim_seconds.
+ */
+int case_bench(int argc, char **argv)
+{
+	disk_device *device;
+	struct fs *fs;
+	extract_ctx ctx;
+	PROCESS_MEMORY_COUNTERS pmc;
+	FILE *out, *json;
+	char *image, *op, *sink, *path, *workdir, *spec;
+	char src[MAX_PATH], dest[MAX_PATH];
+	int64_t start, elapsed, ops, bytes;
+	int null_sink, error;
+	ufs_inop ino;
+	sim_disk *sim;
+
+	json = stdout;
+	sim = NULL;
+	spec = NULL;
+	while (argc > 2 && argv[1][0] == '-') {
+		if (!strcmp(argv[1], "-o")) {
+			if (json != stdout)
+				fclose(json);
+			json = fopen(argv[2], "w");
+			if (json == NULL)
+				return -1;
+		} else if (!strcmp(argv[1], "-sim")) {
+			sim_free(sim);
+			spec = argv[2];
+			sim = sim_create(spec);
+			if (sim == NULL)
+				return -1;
+		} else {
+			return -1;
+		}
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc != 6)
+		return -1;
+
+	image = argv[1];
+	op = argv[2];
+	sink = argv[3];
+	path = argv[4];
+	workdir = argv[5];
+	null_sink = !strcmp(sink, "null");
+
+	device = open_file_device(image);
+	if (device == NULL || (fs = ufs_init(device)) == NULL) {
+		fprintf(stderr, "ufsbench: cannot open %s\n", image);
+		return -1;
+	}
+
+	// the model starts after the superblock has been read
+	device->sim = sim;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.device = device;
+	ctx.fs = fs;
+	ctx.quiet = 1;
+	ctx.discard = null_sink;
+
+	ops = 0;
+	bytes = 0;
+	error = 0;
+	start = bench_now();
+
+	do {
+		if (!strcmp(op, "list")) {
+			if (null_sink)
+				strcpy(dest, "NUL");
+			else
+				sprintf(dest, "%s/list.txt", workdir);
+			out = fopen(dest, "w");
+			if (out == NULL ||
+			    print_dir_listing(device, fs, path, out))
+				error = 1;
+			if (out) {
+				bytes += ftell(out);
+				fclose(out);
+			}
+		} else if (!strcmp(op, "lookup")) {
+			if (!ufs_lookup_path(device, fs, path, 1, ROOTINO))
+				error = 1;
+		} else if (!strcmp(op, "get") || !strcmp(op, "getr")) {
+			strcpy(src, path);
+			sprintf(dest, "%s/%s.out", workdir, op);
+			ino = ufs_lookup_path(device, fs, src, 0, ROOTINO);
+			ctx.bytes = 0;
+			if (read_file(&ctx, ROOTINO, ino, src, dest))
+				error = 1;
+			bytes += ctx.bytes;
+		} else {
+			error = 1;
+		}
+
+		++ops;
+		elapsed = bench_now() - start;
+	} while (!error && !sim && elapsed < CASE_MIN_TIME);
+
+	GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+
+	fprintf(json, "{\"op\": \"%s\", \"sink\": \"%s\", \"path\": \"%s\", "
+	    "\"error\": %s, \"ops\": %I64d, \"seconds\": %.6f, "
+	    "\"ops_per_sec\": %.1f, \"bytes\": %I64d, "
+	    "\"bytes_per_sec\": %.0f, \"syscalls\": %I64d, "
+	    "\"read_bytes\": %I64d, \"peak_rss\": %I64d",
+	    op, sink, path, error ? "true" : "false", ops, elapsed / 1e9,
+	    ops / (elapsed / 1e9), bytes, bytes / (elapsed / 1e9),
+	    device->nreads, device->nbytes,
+	    (int64_t)pmc.PeakWorkingSetSize);
+	if (sim) {
+		fprintf(json, ", \"sim\": {\"spec\": \"%s\", \"seconds\": %.6f, "
+		    "\"requests\": %I64d, \"seeks\": %I64d, "
+		    "\"seek_seconds\": %.6f, \"rotate_seconds\": %.6f, "
+		    "\"transfer_seconds\": %.6f}", spec, sim->clock / 1e9,
+		    sim->requests, sim->seeks, sim->seek_ns / 1e9,
+		    sim->rotate_ns / 1e9, sim->transfer_ns / 1e9);
+	}
+	fprintf(json, "}");
+
+	if (json != stdout)
+		fclose(json);
+	free(fs);
+	close_device(device);
+	sim_free(sim);
+
+	return error ? -1 : 0;
+}
+
+// the suite's -sim spec, passed on to every case
+static const char *suite_sim;
+
+// run one case in a child process and copy its result to out
+static int run_case(FILE *out, int *first, const char *name,
+    const char *image, const char *op, const char *sink, const char *path,
+    const char *workdir)
+{
+	STARTUPINFO si;
+	PROCESS_INFORMATION pi;
+	DWORD code;
+	FILE *json;
+	char exe[MAX_PATH], result[MAX_PATH], buf[1024];
+	char cmdline[5 * MAX_PATH], sim[MAX_PATH + 16];
+	size_t len;
+
+	sim[0] = '\0';
+	if (suite_sim)
+		sprintf(sim, "-sim \"%s\" ", suite_sim);
+
+	GetModuleFileName(NULL, exe, sizeof(exe));
+	sprintf(result, "%s/case.json", workdir);
+	sprintf(cmdline, "\"%s\" case -o \"%s\" %s\"%s\" %s %s \"%s\" \"%s\"",
+	    exe, result, sim, image, op, sink, path, workdir);
+
+	fprintf(stderr, "%s %s %s %s\n", name, op, sink, path);
+	fflush(out);
+
+	memset(&si, 0, sizeof(si));
+	si.cb = sizeof(si);
+	if (!CreateProcess(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL,
+	    &si, &pi)) {
+		fprintf(stderr, "ufsbench: cannot run %s\n", exe);
+		return -1;
+	}
+	WaitForSingleObject(pi.hProcess, INFINITE);
+	GetExitCodeProcess(pi.hProcess, &code);
+	CloseHandle(pi.hProcess);
+	if (pi.hThread)
+		CloseHandle(pi.hThread);
+
+	json = fopen(result, "r");
+	if (json == NULL)
+		return -1;
+
+	fprintf(out, "%s\n    {\"image\": \"%s\", \"case\": ",
+	    *first ? "" : ",", name);
+	while ((len = fread(buf, 1, sizeof(buf), json)) > 0)
+		fwrite(buf, 1, len, out);
+	fprintf(out, "}");
+	*first = 0;
+
+	fclose(json);
+	DeleteFile(result);
+
+	return code ? -1 : 0;
+}
+
+/*
+ * ufsbench suite [-full] [-d workdir] [-o results.json] [-sim spec]
+ *     [shape ...]
+ * generates the images that aren't in workdir yet, then times every
+ * operation on each of them, on a simdisk model of spec if given.
+ */
+int suite_bench(int argc, char **argv)
+{
+	static const char *sinks[] = { "null", "real" };
+	const struct shape *shape;
+	const char *workdir, *output, *mode;
+	char image[MAX_PATH], name[64];
+	FILE *out;
+	int i, j, s, version, full, first, failed, nselected;
+	char **selected;
+
+	full = 0;
+	workdir = "ufsbench.tmp";
+	output = NULL;
+	selected = calloc(argc, sizeof(*selected));
+	nselected = 0;
+
+	for (i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-full")) {
+			full = 1;
+		} else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			workdir = argv[++i];
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			output = argv[++i];
+		} else if (!strcmp(argv[i], "-sim") && i + 1 < argc) {
+			suite_sim = argv[++i];
+		} else if (argv[i][0] == '-') {
+			free(selected);
+			return -1;
+		} else {
+			selected[nselected++] = argv[i];
+		}
+	}
+	mode = full ? "full" : "quick";
+
+	if (GetFileAttributes(workdir) == INVALID_FILE_ATTRIBUTES &&
+	    !CreateDirectory(workdir, NULL)) {
+		fprintf(stderr, "ufsbench: cannot create %s\n", workdir);
+		free(selected);
+		return -1;
+	}
+
+	out = stdout;
+	if (output && (out = fopen(output, "w")) == NULL) {
+		fprintf(stderr, "ufsbench: cannot create %s\n", output);
+		free(selected);
+		return -1;
+	}
+
+	fprintf(out, "{\"suite\": \"ufsbench\", \"mode\": \"%s\", "
+	    "\"sim\": %s%s%s, \"results\": [", mode, suite_sim ? "\"" : "",
+	    suite_sim ? suite_sim : "null", suite_sim ? "\"" : "");
+	first = 1;
+	failed = 0;
+
+	for (i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+		shape = &shapes[i];
+
+		for (j = 0; j < nselected; ++j) {
+			if (!strcmp(selected[j], shape->name))
+				break;
+		}
+		if (nselected && j == nselected)
+			continue;
+
+		for (version = 1; version <= 2; ++version) {
+			sprintf(name, "%s-ufs%d", shape->name, version);
+			sprintf(image, "%s/%s-%s.img", workdir, name, mode);
+
+			if (GetFileAttributes(image) == INVALID_FILE_ATTRIBUTES &&
+			    generate(shape, version, full, image)) {
+				fprintf(stderr, "ufsbench: cannot generate %s\n",
+				    image);
+				failed = 1;
+				continue;
+			}
+
+			for (s = 0; s < 2; ++s) {
+				failed |= run_case(out, &first, name, image,
+				    "list", sinks[s], shape->list_path, workdir);
+			}
+			failed |= run_case(out, &first, name, image, "lookup",
+			    "null", shape->lookup_path, workdir);
+			for (s = 0; shape->get_path && s < 2; ++s) {
+				failed |= run_case(out, &first, name, image,
+				    "get", sinks[s], shape->get_path, workdir);
+			}
+			for (s = 0; s < 2; ++s) {
+				failed |= run_case(out, &first, name, image,
+				    "getr", sinks[s], "/", workdir);
+			}
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	if (out != stdout)
+		fclose(out);
+	free(selected);
+
+	return failed ? -1 : 0;
+}
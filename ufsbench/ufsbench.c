@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2004 Nehal Mistry
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+void usage()
+{
+	fprintf(stderr, "%s\n\n%s\n\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n",
+	"    ufsbench",
+	"    usage: ufsbench command [args]",
+	"    suite [-full] [-d workdir] [-o results.json] [-sim spec] [shape ...]",
+	"		generate images and time list, lookup and get on them",
+	"    case [-o file] [-sim spec] image op sink path workdir",
+	"		time one operation, as run by suite",
+	"    micro [direntry|lookup|blocklist|sort|validname ...]",
+	"		ns/op and allocs/op of the hot-path functions",
+	"    ops [-update] [-d workdir] [-b baseline]",
+	"		compare operation counts against the checked in baseline",
+	"    engine	block mapping and inode decoding, engine against the old code",
+	""
+	);
+	exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	if (argc < 2)
+		usage();
+
+	if (!strcmp(argv[1], "suite"))
+		return suite_bench(argc - 1, argv + 1);
+	if (!strcmp(argv[1], "case"))
+		return case_bench(argc - 1, argv + 1);
+	if (!strcmp(argv[1], "micro") && !micro_bench(argc - 1, argv + 1))
+		return 0;
+	if (!strcmp(argv[1], "ops")) {
+		ret = ops_bench(argc - 1, argv + 1);
+		if (ret >= 0)
+			return ret;
+	}
+	if (!strcmp(argv[1], "engine"))
+		return engine_bench(argc - 1, argv + 1);
+
+	usage();
+	return -1;
+}